@@ -106,7 +106,7 @@ void								BallisticDemo::Fire				()										{
 }
 
 void								BallisticDemo::Update			()										{
-	float									duration						= (float)TimingData::get().LastFrameDuration * 0.001f;	// Find the duration of the last frame in seconds
+	float									duration						= (float)TimingData::get().LastFrameSeconds;	// Find the duration of the last frame in seconds
 	if (duration <= 0.0f) 
 		return;
 
@@ -0,0 +1,805 @@
+// This file contains the benchmark: the physics of the demos rebuilt without any rendering or window, run for a fixed number of frames of a fixed duration, with the time spent in each phase of the frame reported as JSON on the standard output.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "cyclone.h"
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Holds the measurements of a single frame.
+struct FrameStats {
+	double								Integrate							= 0;	// Holds the time spent applying the forces and integrating the bodies, in seconds.
+	double								Contacts							= 0;	// Holds the time spent generating the contacts, in seconds.
+	double								Resolve								= 0;	// Holds the time spent resolving the contacts, in seconds.
+	uint32_t							ContactCount						= 0;
+	uint32_t							VelocityIterations					= 0;	// Holds the velocity iterations used by the resolver. The particle resolver has a single pass, counted here.
+	uint32_t							PositionIterations					= 0;
+};
+
+// A scene of the benchmark. The scene is built by the constructor of each implementation, with a number of bodies proportional to the given scale, and each frame is split into the three phases that are timed on their own.
+class BenchmarkScene {
+public:
+	virtual								~BenchmarkScene						()															{}
+
+	virtual	const char*					GetName								()													const	= 0;
+	virtual	uint32_t					GetBodyCount						()													const	= 0;	// Returns the number of bodies or particles in the scene.
+	virtual	void						UpdateObjects						(double duration)											= 0;	// Applies the forces and moves the objects forward in time.
+	virtual	uint32_t					GenerateContacts					()															{ return 0; }	// Returns the number of contacts generated.
+	virtual	void						ResolveContacts						(double /*duration*/, FrameStats & /*stats*/)				{}	// Resolves the contacts of the frame and writes the iterations used into the given stats.
+};
+
+// Sets up the body of the given box with the mass of a solid of density one, as the demos do.
+static	void						setBoxState							(cyclone::CollisionBox &box, const cyclone::Vector3 &position, const cyclone::Quaternion &orientation, const cyclone::Vector3 &halfSize, const cyclone::Vector3 &velocity, const cyclone::Vector3 &acceleration)	{
+	cyclone::RigidBody						& body								= *box.Body;
+	body.Pivot.Position					= position;
+	body.Pivot.setOrientation(orientation);
+	body.Force.Velocity					= velocity;
+	body.Force.Rotation					= {};
+	body.Force.Acceleration				= acceleration;
+	box.HalfSize						= halfSize;
+
+	const double							mass								= halfSize.x * halfSize.y * halfSize.z * 8;
+	cyclone::Matrix3						tensor;
+	tensor.setBlockInertiaTensor(halfSize, mass);
+	body.Mass.setMass(mass);
+	body.Mass.setInertiaTensor(tensor);
+	body.Mass.setDamping(0.95, 0.8);
+	body.clearAccumulators();
+	body.setAwake();
+	body.CalculateDerivedData();
+	box.InvalidateTransform();
+}
+
+static	void						setSphereState						(cyclone::CollisionSphere &sphere, const cyclone::Vector3 &position, double radius, double mass, const cyclone::Vector3 &velocity, const cyclone::Vector3 &acceleration, double linearDamping)				{
+	cyclone::RigidBody						& body								= *sphere.Body;
+	body.Pivot.Position					= position;
+	body.Pivot.Orientation				= {1, 0, 0, 0};
+	body.Force.Velocity					= velocity;
+	body.Force.Rotation					= {};
+	body.Force.Acceleration				= acceleration;
+	sphere.Radius						= radius;
+
+	const double							coeff								= 0.4 * mass * radius * radius;
+	cyclone::Matrix3						tensor;
+	tensor.setInertiaTensorCoeffs(coeff, coeff, coeff);
+	body.Mass.setMass(mass);
+	body.Mass.setInertiaTensor(tensor);
+	body.Mass.setDamping(linearDamping, 0.8);
+	body.clearAccumulators();
+	body.setAwake();
+	body.CalculateDerivedData();
+	sphere.InvalidateTransform();
+}
+
+// Holds boxes and spheres in a collision world over a ground plane, and resolves their contacts with the rigid body resolver, as the rigid body demos do.
+// The bodies are allocated once by the constructor, so the primitives can point into the arrays.
+class RigidBodyScene : public BenchmarkScene {
+protected:
+	::std::vector<cyclone::RigidBody>		Bodies								= {};	// Holds the bodies of the boxes first and then the ones of the spheres.
+	::std::vector<cyclone::CollisionBox>	Boxes								= {};
+	::std::vector<cyclone::CollisionSphere>	Spheres								= {};
+	::std::vector<cyclone::Contact>			Contacts							= {};
+	cyclone::CollisionData					Collisions							= {};
+	cyclone::CollisionWorld					Collision							= {};
+	cyclone::ContactResolver				Resolver							= {0};
+	double									Friction							= 0.9;
+	double									Restitution							= 0.1;
+	double									Tolerance							= 0.1;
+
+	virtual	uint32_t						GenerateJointContacts				()															{ return 0; }	// Adds the contacts of the joints of the scene after the collisions.
+public:
+											RigidBodyScene						(uint32_t boxes, uint32_t spheres, uint32_t maxContacts)
+		: Resolver(maxContacts * 8)
+	{
+		Bodies	.resize(boxes + spheres);
+		Boxes	.resize(boxes);
+		Spheres	.resize(spheres);
+		Contacts.resize(maxContacts);
+		Collisions.ContactArray				= Contacts.data();
+		for (uint32_t iBox = 0; iBox < boxes; ++iBox) {
+			Boxes[iBox].Body					= &Bodies[iBox];
+			Collision.Register(&Boxes[iBox]);
+		}
+		for (uint32_t iSphere = 0; iSphere < spheres; ++iSphere) {
+			Spheres[iSphere].Body				= &Bodies[boxes + iSphere];
+			Collision.Register(&Spheres[iSphere]);
+		}
+		Collision.HalfSpaces.push_back({{0, 1, 0}, 0});	// The ground plane.
+	}
+
+	virtual	uint32_t					GetBodyCount						()													const	{ return (uint32_t)Bodies.size(); }
+	virtual	void						UpdateObjects						(double duration)											{
+		for (uint32_t iBody = 0; iBody < Bodies.size(); ++iBody)
+			Bodies[iBody].Integrate(duration);
+	}
+
+	virtual	uint32_t					GenerateContacts					()															{
+		Collisions.Reset((uint32_t)Contacts.size());
+		Collisions.Friction					= Friction;
+		Collisions.Restitution				= Restitution;
+		Collisions.Tolerance				= Tolerance;
+		Collision.Update();
+		Collision.GenerateContacts(&Collisions);
+		GenerateJointContacts();
+		return Collisions.ContactCount;
+	}
+
+	virtual	void						ResolveContacts						(double duration, FrameStats &stats)						{
+		Resolver.VelocityIterationsUsed		= 0;
+		Resolver.PositionIterationsUsed		= 0;
+		if (Collisions.ContactCount)
+			Resolver.resolveContacts(Collisions.ContactArray, Collisions.ContactCount, duration);
+		stats.VelocityIterations			= Resolver.VelocityIterationsUsed;
+		stats.PositionIterations			= Resolver.PositionIterationsUsed;
+	}
+};
+
+// Two boxes per row, at 20 and 110 metres from the firing points, shot at by rounds of the first three ammunition types of the demo. Rounds that leave the range are fired again.
+class BigBallisticScene : public RigidBodyScene {
+	static constexpr	uint32_t		RoundsPerRow						= 8;
+
+	uint32_t							Rows								= 0;
+
+	void								Fire								(uint32_t round)											{
+		const cyclone::Vector3					origin								= {(round / RoundsPerRow) * 4.0, 1.5, 0};
+		cyclone::CollisionSphere				& shot								= Spheres[round];
+		switch (round % 3) {
+		case 0	: setSphereState(shot, origin, 0.2,   1.5, {0,  0.0, 20}, {0, -0.5, 0}, 0.99); break;	// Pistol
+		case 1	: setSphereState(shot, origin, 0.4, 200.0, {0, 30.0, 40}, {0, -21., 0}, 0.99); break;	// Artillery
+		default	: setSphereState(shot, origin, 0.6,   4.0, {0, -0.5, 10}, {0,  0.3, 0}, 0.9 ); break;	// Fireball
+		}
+	}
+public:
+										BigBallisticScene					(uint32_t scale) : RigidBodyScene(scale * 2, scale * RoundsPerRow, 256 * scale), Rows(scale)	{
+		Restitution							= 0.1;
+		for (uint32_t iRow = 0; iRow < Rows; ++iRow) {
+			setBoxState(Boxes[iRow * 2    ], {iRow * 4.0, 3,  20}, {1, 0, 0, 0}, {1, 1, 1}, {}, {0, -10, 0});
+			setBoxState(Boxes[iRow * 2 + 1], {iRow * 4.0, 3, 110}, {1, 0, 0, 0}, {1, 1, 1}, {}, {0, -10, 0});
+		}
+		for (uint32_t iRound = 0; iRound < Spheres.size(); ++iRound)
+			Fire(iRound);
+	}
+	virtual	const char*					GetName								()													const	{ return "bigballistic"; }
+	virtual	void						UpdateObjects						(double duration)											{
+		RigidBodyScene::UpdateObjects(duration);
+		for (uint32_t iRound = 0; iRound < Spheres.size(); ++iRound) {
+			const cyclone::Vector3					& position							= Spheres[iRound].Body->Pivot.Position;
+			if (position.y < 0 || position.z > 200)
+				Fire(iRound);
+		}
+	}
+};
+
+// Random boxes and balls in a volume that grows with the scale, with an explosion going off at its centre whenever the last one is over.
+class ExplosionScene : public RigidBodyScene {
+	cyclone::ExplosionSet				Blasts								= {};
+public:
+										ExplosionScene						(uint32_t scale) : RigidBodyScene(scale * 5, scale * 5, 256 * scale)	{
+		Restitution							= 0.6;
+		const double							spread								= 5 * real_sqrt((double)scale);
+		cyclone::Random							random								= {1};
+		for (uint32_t iBox = 0; iBox < Boxes.size(); ++iBox)
+			setBoxState(Boxes[iBox], random.RandomVector({-spread, 5, -spread}, {spread, 10, spread}), random.RandomQuaternion(), random.RandomVector({.5, .5, .5}, {4.5, 1.5, 1.5}), {}, {0, -10, 0});
+		for (uint32_t iBall = 0; iBall < Spheres.size(); ++iBall) {
+			const double							radius								= random.RandomReal(0.5, 1.5);
+			setSphereState(Spheres[iBall], random.RandomVector({-spread, 5, -spread}, {spread, 10, spread}), radius, 4 * 0.3333 * R_PI * radius * radius * radius, {}, {0, -10, 0}, 0.95);
+		}
+		Collision.Update();	// The explosions find the bodies through the broad phase.
+	}
+	virtual	const char*					GetName								()													const	{ return "explosion"; }
+	virtual	void						UpdateObjects						(double duration)											{
+		if (Blasts.Explosions.empty()) {
+			cyclone::Explosion						blast								= {};
+			blast.Detonation					= {0, 0.5, 0};
+			blast.ImplosionMaxRadius			= 10;
+			blast.ImplosionMinRadius			= 1;
+			blast.ImplosionDuration				= 0.1;
+			blast.ImplosionForce				= 50;
+			blast.ShockwaveSpeed				= 20;
+			blast.ShockwaveThickness			= 3;
+			blast.PeakConcussionForce			= 1000;
+			blast.ConcussionDuration			= 0.8;
+			blast.PeakConvectionForce			= 200;
+			blast.ChimneyRadius					= 3;
+			blast.ChimneyHeight					= 15;
+			blast.ConvectionDuration			= 2;
+			Blasts.Add(blast);
+		}
+		Blasts.Apply(Collision.Coarse);
+		Blasts.Advance(duration);
+		RigidBodyScene::UpdateObjects(duration);
+	}
+};
+
+// Blocks of the demo in a row, each already split into the eight pieces the demo breaks it into, each hit by its own ball.
+class FractureScene : public RigidBodyScene {
+public:
+										FractureScene						(uint32_t scale) : RigidBodyScene(8 * scale, scale, 256 * scale)	{
+		Restitution							= 0.2;
+		for (uint32_t iBlock = 0; iBlock < scale; ++iBlock) {
+			const cyclone::Vector3					centre								= {iBlock * 12.0, 7, 0};
+			for (uint32_t iPiece = 0; iPiece < 8; ++iPiece) {
+				const cyclone::Vector3					offset								= {(iPiece & 1) ? 2.0 : -2.0, (iPiece & 2) ? 2.0 : -2.0, (iPiece & 4) ? 2.0 : -2.0};
+				setBoxState(Boxes[iBlock * 8 + iPiece], centre + offset, {1, 0, 0, 0}, {2, 2, 2}, {}, cyclone::Vector3::GRAVITY);
+			}
+			setSphereState(Spheres[iBlock], centre + cyclone::Vector3{0, -2, 20}, 0.25, 5, {0, 3, -20}, cyclone::Vector3::GRAVITY, 0.9);
+			Spheres[iBlock].Body->setCanSleep(false);
+		}
+	}
+	virtual	const char*					GetName								()													const	{ return "fracture"; }
+};
+
+// Ragdolls of the demo standing in a row, knocked over by a push. The bones collide as boxes, and the bones held by a joint don't collide with each other.
+class RagdollScene : public RigidBodyScene {
+	static constexpr	uint32_t		BoneCount							= 12;
+	static constexpr	uint32_t		JointCount							= 11;
+
+	::std::vector<cyclone::Joint>		Joints								= {};
+
+	virtual	uint32_t					GenerateJointContacts				()															{
+		for (uint32_t iJoint = 0; iJoint < Joints.size() && Collisions.HasMoreContacts(); ++iJoint)
+			Collisions.AddContacts(Joints[iJoint].AddContact(Collisions.Contacts, Collisions.ContactsLeft));
+		return Collisions.ContactCount;
+	}
+public:
+										RagdollScene						(uint32_t scale) : RigidBodyScene(BoneCount * scale, 0, 256 * scale)	{
+		static const cyclone::Vector3			bonePositions	[BoneCount]			=
+			{ { 0.000, 0.993, -0.500}, { 0.000, 3.159, -0.560}, { 0.000, 0.993,  0.500}, { 0.000, 3.150,  0.560}
+			, {-0.054, 4.683,  0.013}, { 0.043, 5.603,  0.013}, { 0.000, 6.485,  0.013}, { 0.000, 7.759,  0.013}
+			, { 0.000, 5.946, -1.066}, { 0.000, 4.024, -1.066}, { 0.000, 5.946,  1.066}, { 0.000, 4.024,  1.066}
+			};
+		static const cyclone::Vector3			boneSizes		[BoneCount]			=
+			{ {0.301, 1.000, 0.234}, {0.301, 1.000, 0.234}, {0.301, 1.000, 0.234}, {0.301, 1.000, 0.234}
+			, {0.415, 0.392, 0.690}, {0.301, 0.367, 0.693}, {0.435, 0.367, 0.786}, {0.450, 0.598, 0.421}
+			, {0.267, 0.888, 0.207}, {0.267, 0.888, 0.207}, {0.267, 0.888, 0.207}, {0.267, 0.888, 0.207}
+			};
+		struct JointDesc { uint32_t Bone[2]; cyclone::Vector3 Position[2]; double Error; };
+		static const JointDesc					joints			[JointCount]		=
+			{ {{ 0,  1}, {{0, 1.07, 0}			, {0, -1.07, 0}			}, 0.15 }	// Right knee
+			, {{ 2,  3}, {{0, 1.07, 0}			, {0, -1.07, 0}			}, 0.15 }	// Left knee
+			, {{ 9,  8}, {{0, 0.96, 0}			, {0, -0.96, 0}			}, 0.15 }	// Right elbow
+			, {{11, 10}, {{0, 0.96, 0}			, {0, -0.96, 0}			}, 0.15 }	// Left elbow
+			, {{ 4,  5}, {{ 0.054,  0.50, 0}	, {-0.043, -0.45, 0}	}, 0.15 }	// Stomach to waist
+			, {{ 5,  6}, {{-0.043, 0.411, 0}	, {0, -0.411, 0}		}, 0.15 }
+			, {{ 6,  7}, {{0, 0.521, 0}			, {0, -0.752, 0}		}, 0.15 }
+			, {{ 1,  4}, {{0, 1.066, 0}			, {0, -0.458, -0.5}		}, 0.15 }	// Right hip
+			, {{ 3,  4}, {{0, 1.066, 0}			, {0, -0.458,  0.5}		}, 0.105}	// Left hip
+			, {{ 6,  8}, {{0, 0.367, -0.8}		, {0, 0.888,  0.32}		}, 0.15 }	// Right shoulder
+			, {{ 6, 10}, {{0, 0.367,  0.8}		, {0, 0.888, -0.32}		}, 0.15 }	// Left shoulder
+			};
+		Restitution							= 0.6;
+		Joints.resize(JointCount * scale);
+		cyclone::Random							random								= {1};
+		for (uint32_t iRagdoll = 0; iRagdoll < scale; ++iRagdoll) {
+			const cyclone::Vector3					offset								= {0, 0, iRagdoll * 3.0};
+			cyclone::CollisionBox					* bones								= &Boxes[iRagdoll * BoneCount];
+			for (uint32_t iBone = 0; iBone < BoneCount; ++iBone) {
+				setBoxState(bones[iBone], bonePositions[iBone] + offset, {1, 0, 0, 0}, boneSizes[iBone], {}, cyclone::Vector3::GRAVITY);
+				bones[iBone].Body->setCanSleep(false);
+			}
+			for (uint32_t iJoint = 0; iJoint < JointCount; ++iJoint) {
+				const JointDesc							& joint								= joints[iJoint];
+				Joints[iRagdoll * JointCount + iJoint].Set(bones[joint.Bone[0]].Body, joint.Position[0], bones[joint.Bone[1]].Body, joint.Position[1], joint.Error);
+				Collision.Coarse.ExcludePair(bones[joint.Bone[0]].Body, bones[joint.Bone[1]].Body);
+			}
+			const double							strength							= -random.RandomReal(500, 1000);
+			for (uint32_t iBone = 0; iBone < BoneCount; ++iBone)
+				bones[iBone].Body->addForceAtBodyPoint({strength, 0, 0}, {});
+			bones[6].Body->addForceAtBodyPoint({strength, 0, random.RandomBinomial(1000)}, {random.RandomBinomial(4), random.RandomBinomial(3), 0});
+		}
+	}
+	virtual	const char*					GetName								()													const	{ return "ragdoll"; }
+	virtual	void						UpdateObjects						(double duration)											{
+		RigidBodyScene::UpdateObjects(duration);
+		for (uint32_t iBody = 0; iBody < Bodies.size(); ++iBody)
+			Bodies[iBody].clearAccumulators();	// The push is only applied on the first frame.
+	}
+};
+
+// Holds particles in a particle world, and resolves their contacts with the particle resolver, as the mass aggregate demos do.
+class ParticleScene : public BenchmarkScene {
+protected:
+	::std::vector<cyclone::Particle>	Particles							= {};
+	cyclone::ParticleWorld				World;
+	uint32_t							ContactCount						= 0;
+public:
+										ParticleScene						(uint32_t particles, uint32_t maxContacts) : World(maxContacts)	{
+		Particles.resize(particles);
+		for (uint32_t iParticle = 0; iParticle < particles; ++iParticle)
+			World.Particles.push_back(&Particles[iParticle]);
+	}
+
+	virtual	uint32_t					GetBodyCount						()													const	{ return (uint32_t)Particles.size(); }
+	virtual	void						UpdateObjects						(double duration)											{
+		World.StartFrame();
+		World.ForceRegistry.UpdateForces(duration);
+		World.Integrate(duration);
+	}
+	virtual	uint32_t					GenerateContacts					()															{ return ContactCount = World.GenerateContacts(); }
+	virtual	void						ResolveContacts						(double duration, FrameStats &stats)						{
+		if (0 == ContactCount)
+			return;
+		World.Resolver.SetIterations(ContactCount * 2);
+		World.Resolver.ResolveContacts(World.Contacts, ContactCount, duration);
+		stats.VelocityIterations			= World.Resolver.GetIterationsUsed();
+	}
+};
+
+// Bridges of the demo side by side, each with the extra mass resting at its middle.
+class BridgeScene : public ParticleScene {
+	static constexpr	uint32_t		ParticlesPerBridge					= 12;
+
+	cyclone::ParticleLinkSet			Links								= {};
+	cyclone::GroundContacts				Ground								= {};
+public:
+										BridgeScene							(uint32_t scale) : ParticleScene(ParticlesPerBridge * scale, ParticlesPerBridge * 10 * scale)	{
+		Links.Particles						= Particles.data();
+		for (uint32_t iBridge = 0; iBridge < scale; ++iBridge) {
+			const uint32_t							first								= iBridge * ParticlesPerBridge;
+			const double							z									= iBridge * 4.0;
+			for (uint32_t i = 0; i < ParticlesPerBridge; ++i) {
+				cyclone::Particle						& particle							= Particles[first + i];
+				particle.Position					= {(i / 2) * 2.0 - 5, 4, (i % 2) * 2.0 - 1 + z};
+				particle.Damping					= 0.9;
+				particle.Acceleration				= cyclone::Vector3::GRAVITY;
+				particle.SetMass((i == 4 || i == 5 || i == 6 || i == 7) ? 1 + 10 * 0.25 : 1);	// The extra mass is spread over the four particles around the middle.
+			}
+			for (uint32_t i = 0; i < 10; ++i)
+				Links.AddCable(first + i, first + i + 2, 1.9, 0.3);
+			for (uint32_t i = 0; i < 12; ++i)
+				Links.AddAnchoredCable(first + i, {(i / 2) * 2.2 - 5.5, 6, (i % 2) * 1.6 - 0.8 + z}, (i < 6) ? (i / 2) * 0.5 + 3 : 5.5 - (i / 2) * 0.5, 0.5);
+			for (uint32_t i = 0; i < 6; ++i)
+				Links.AddRod(first + i * 2, first + i * 2 + 1, 2);
+		}
+		Ground.Init(&World.Particles);
+		World.ContactGenerators.push_back(&Ground);
+		World.ContactGenerators.push_back(&Links);
+	}
+	virtual	const char*					GetName								()													const	{ return "bridge"; }
+};
+
+// Columns of the platforms of the blob demo, each with its own blob. The blob particles of a column only attract each other.
+class BlobScene : public ParticleScene {
+	static constexpr	uint32_t		BlobCount							= 5;
+	static constexpr	uint32_t		PlatformCount						= 10;
+	static constexpr	double			BlobRadius							= 0.4;
+
+	// A line on which the particles of a blob can rest.
+	struct Platform : public cyclone::ParticleContactGenerator {
+		cyclone::Vector3					Start								= {};
+		cyclone::Vector3					End									= {};
+		cyclone::Particle					* Particles							= 0;
+		uint32_t							Count								= 0;
+
+		virtual	uint32_t					AddContact							(cyclone::ParticleContact *contact, uint32_t limit)	const	{
+			const cyclone::Vector3					lineDirection						= End - Start;
+			const double							lineSquareLength					= lineDirection.squareMagnitude();
+			uint32_t								used								= 0;
+			for (uint32_t iParticle = 0; iParticle < Count && used < limit; ++iParticle) {
+				const cyclone::Vector3					toParticle							= Particles[iParticle].Position - Start;
+				double									projected							= toParticle * lineDirection;
+				projected							= (projected < 0) ? 0 : (projected > lineSquareLength) ? lineSquareLength : projected;
+				const cyclone::Vector3					separation							= Particles[iParticle].Position - (Start + lineDirection * (projected / lineSquareLength));
+				const double							squareDistance						= separation.squareMagnitude();
+				if (squareDistance >= BlobRadius * BlobRadius || squareDistance <= 0)
+					continue;
+				contact->ContactNormal				= separation * (1.0 / real_sqrt(squareDistance));
+				contact->ContactNormal.z			= 0;
+				contact->Restitution				= 0;
+				contact->Particle[0]				= Particles + iParticle;
+				contact->Particle[1]				= 0;
+				contact->Penetration				= BlobRadius - real_sqrt(squareDistance);
+				++contact;
+				++used;
+			}
+			return used;
+		}
+	};
+
+	// Pulls the particles of a blob together when they drift apart and pushes them away when they get too close, and floats the first particle.
+	struct BlobForce : public cyclone::ParticleForceGenerator {
+		cyclone::Particle					* Particles							= 0;
+		uint32_t							Count								= 0;
+
+		virtual	void						UpdateForce							(cyclone::Particle *particle, double /*duration*/)			{
+			const double							minNaturalDistance					= BlobRadius * 0.75;
+			const double							maxNaturalDistance					= BlobRadius * 1.5;
+			const double							maxDistance							= BlobRadius * 2.5;
+			uint32_t								joinCount							= 0;
+			for (uint32_t iParticle = 0; iParticle < Count; ++iParticle) {
+				if (Particles + iParticle == particle)
+					continue;
+				cyclone::Vector3						separation							= Particles[iParticle].Position - particle->Position;
+				separation.z						= 0;
+				double									distance							= separation.magnitude();
+				if (distance < minNaturalDistance) {
+					distance							= 1 - distance / minNaturalDistance;
+					particle->AccumulatedForce			+= separation.unit() * (1 - distance) * -10.0;
+					++joinCount;
+				}
+				else if (distance > maxNaturalDistance && distance < maxDistance) {
+					particle->AccumulatedForce			+= separation.unit() * ((distance - maxNaturalDistance) / (maxDistance - maxNaturalDistance)) * 20.0;
+					++joinCount;
+				}
+			}
+			if (particle == Particles && joinCount > 0) {
+				const double							force								= (joinCount / 2.0 * 8 > 8) ? 8 : joinCount / 2.0 * 8;
+				particle->AccumulatedForce			+= {0, force, 0};
+			}
+		}
+	};
+
+	::std::vector<Platform>				Platforms							= {};
+	::std::vector<BlobForce>			Forces								= {};
+public:
+										BlobScene							(uint32_t scale) : ParticleScene(BlobCount * scale, (BlobCount + PlatformCount) * scale)	{
+		Platforms	.resize(PlatformCount * scale);
+		Forces		.resize(scale);
+		cyclone::Random							random								= {1};
+		for (uint32_t iColumn = 0; iColumn < scale; ++iColumn) {
+			const double							x									= iColumn * 25.0;
+			cyclone::Particle						* blobs								= &Particles[iColumn * BlobCount];
+			for (uint32_t iPlatform = 0; iPlatform < PlatformCount; ++iPlatform) {
+				Platform								& platform							= Platforms[iColumn * PlatformCount + iPlatform];
+				platform.Start						= {x + (iPlatform % 2) * 10.0 - 5 + random.RandomBinomial(2), iPlatform * 4.0 + ((iPlatform % 2) ? 0 : 2) + random.RandomBinomial(2), 0};
+				platform.End						= {x + (iPlatform % 2) * 10.0 + 5 + random.RandomBinomial(2), iPlatform * 4.0 + ((iPlatform % 2) ? 2 : 0) + random.RandomBinomial(2), 0};
+				platform.Particles					= blobs;
+				platform.Count						= BlobCount;
+				World.ContactGenerators.push_back(&platform);
+			}
+			Forces[iColumn].Particles			= blobs;
+			Forces[iColumn].Count				= BlobCount;
+			const Platform							& top								= Platforms[iColumn * PlatformCount + PlatformCount - 2];
+			for (uint32_t iBlob = 0; iBlob < BlobCount; ++iBlob) {
+				const uint32_t							me									= (iBlob + BlobCount / 2) % BlobCount;
+				blobs[iBlob].Position				= top.Start + (top.End - top.Start) * (me * 0.8 / BlobCount + 0.1) + cyclone::Vector3{0, 1 + random.RandomReal(), 0};
+				blobs[iBlob].Damping				= 0.2;
+				blobs[iBlob].Acceleration			= cyclone::Vector3::GRAVITY * 0.4;
+				blobs[iBlob].SetMass(1);
+				World.ForceRegistry.Add(&blobs[iBlob], &Forces[iColumn]);
+			}
+		}
+	}
+	virtual	const char*					GetName								()													const	{ return "blob"; }
+};
+
+// Rockets of the fireworks demo launched at a steady rate, bursting into sparks that burst again.
+class FireworksScene : public BenchmarkScene {
+	cyclone::ParticleEmitter			Fireworks							= {};
+	uint32_t							Launchers							= 0;
+	double								LaunchTimer							= 0;
+public:
+										FireworksScene						(uint32_t scale) : Launchers(scale)	{
+		cyclone::ParticleEmitterRule			rule								= {};
+		const cyclone::ParticleEmitterPayload	rocketPayloads	[]					= {{1, 12}, {2, 4}};
+		const cyclone::ParticleEmitterPayload	burstPayloads	[]					= {{1, 6}};
+		rule.MinAge							= 0.5;	// The rocket.
+		rule.MaxAge							= 1.4;
+		rule.MinVelocity					= {-5, 25, -5};
+		rule.MaxVelocity					= { 5, 28,  5};
+		rule.Damping						= 0.1;
+		Fireworks.AddRule(rule, rocketPayloads, 2);
+		rule.MinAge							= 0.5;	// The sparks.
+		rule.MaxAge							= 1.0;
+		rule.MinVelocity					= {-5, -5, -5};
+		rule.MaxVelocity					= { 5,  5,  5};
+		rule.Damping						= 0.2;
+		Fireworks.AddRule(rule);
+		rule.MinAge							= 0.25;	// The sparks that burst again.
+		rule.MaxAge							= 0.5;
+		rule.MinVelocity					= {-10, 0, -10};
+		rule.MaxVelocity					= { 10, 5,  10};
+		Fireworks.AddRule(rule, burstPayloads, 1);
+		Fireworks.Reserve(1024 * scale);
+		Fireworks.FloorHeight				= 0;
+		Fireworks.Generator.Seed(1);
+	}
+	virtual	const char*					GetName								()													const	{ return "fireworks"; }
+	virtual	uint32_t					GetBodyCount						()													const	{ return Fireworks.Capacity; }
+	virtual	void						UpdateObjects						(double duration)											{
+		LaunchTimer							-= duration;
+		if (LaunchTimer <= 0) {
+			LaunchTimer							+= 0.5;
+			for (uint32_t iLauncher = 0; iLauncher < Launchers; ++iLauncher)
+				Fireworks.Emit(0, 1, {iLauncher * 5.0, 0, 0});
+		}
+		Fireworks.Update(duration);
+	}
+};
+
+// Boats of the sailboat demo in a grid, all driven by the same changing wind.
+class SailboatScene : public BenchmarkScene {
+	::std::vector<cyclone::RigidBody>	Boats								= {};
+	cyclone::Buoyancy					Buoyancy;
+	cyclone::Aero						Sail;
+	cyclone::Vector3					WindSpeed							= {};
+	cyclone::ForceRegistry				Registry							= {};
+	cyclone::Random						Random								= {1};
+public:
+										SailboatScene						(uint32_t scale)
+		: Buoyancy	({0, 0.5, 0}, 1, 3, 1.6)
+		, Sail		(cyclone::Matrix3(0,0,0, 0,0,0, 0,0,-1), {2, 0, 0}, &WindSpeed)
+	{
+		Boats.resize(scale);
+		cyclone::Matrix3						tensor;
+		tensor.setBlockInertiaTensor({2, 1, 1}, 100);
+		for (uint32_t iBoat = 0; iBoat < scale; ++iBoat) {
+			cyclone::RigidBody						& boat								= Boats[iBoat];
+			boat.Pivot.Position					= {(iBoat % 16) * 10.0, 1.6, (iBoat / 16) * 10.0};
+			boat.Pivot.Orientation				= {1, 0, 0, 0};
+			boat.Mass.setMass(200);
+			boat.Mass.setInertiaTensor(tensor);
+			boat.Mass.setDamping(0.8, 0.8);
+			boat.Force.Acceleration				= cyclone::Vector3::GRAVITY;
+			boat.CalculateDerivedData();
+			boat.setAwake();
+			boat.setCanSleep(false);
+			Registry.Add(&boat, &Sail);
+			Registry.Add(&boat, &Buoyancy);
+		}
+	}
+	virtual	const char*					GetName								()													const	{ return "sailboat"; }
+	virtual	uint32_t					GetBodyCount						()													const	{ return (uint32_t)Boats.size(); }
+	virtual	void						UpdateObjects						(double duration)											{
+		for (uint32_t iBoat = 0; iBoat < Boats.size(); ++iBoat)
+			Boats[iBoat].clearAccumulators();
+		Registry.UpdateForces(duration);
+		for (uint32_t iBoat = 0; iBoat < Boats.size(); ++iBoat)
+			Boats[iBoat].Integrate(duration);
+		WindSpeed							= WindSpeed * 0.9 + Random.RandomXZVector(1);
+	}
+};
+
+// Aircraft of the flight sim demo flying side by side. The ground check of the demo is the contact phase of this scene: it counts the aircraft it stops at the ground.
+class FlightSimScene : public BenchmarkScene {
+	::std::vector<cyclone::RigidBody>	Aircraft							= {};
+	cyclone::AeroControl				LeftWing;
+	cyclone::AeroControl				RightWing;
+	cyclone::AeroControl				Rudder;
+	cyclone::Aero						Tail;
+	cyclone::Vector3					Windspeed							= {};
+	cyclone::ForceRegistry				Registry							= {};
+public:
+										FlightSimScene						(uint32_t scale)
+		: LeftWing	(cyclone::Matrix3(0,0,0, -1,-0.5,0, 0,0,0), cyclone::Matrix3(0,0,0, -0.995,-0.5,0, 0,0,0), cyclone::Matrix3(0,0,0, -1.005,-0.5,0, 0,0,0), {-1, 0, -2}, &Windspeed)
+		, RightWing	(cyclone::Matrix3(0,0,0, -1,-0.5,0, 0,0,0), cyclone::Matrix3(0,0,0, -0.995,-0.5,0, 0,0,0), cyclone::Matrix3(0,0,0, -1.005,-0.5,0, 0,0,0), {-1, 0,  2}, &Windspeed)
+		, Rudder	(cyclone::Matrix3(0,0,0, 0,0,0, 0,0,0), cyclone::Matrix3(0,0,0, 0,0,0, 0.01,0,0), cyclone::Matrix3(0,0,0, 0,0,0, -0.01,0,0), {2, 0.5, 0}, &Windspeed)
+		, Tail		(cyclone::Matrix3(0,0,0, -1,-0.5,0, 0,0,-0.1), {2, 0, 0}, &Windspeed)
+	{
+		Aircraft.resize(scale);
+		cyclone::Matrix3						tensor;
+		tensor.setBlockInertiaTensor({2, 1, 1}, 1);
+		for (uint32_t iAircraft = 0; iAircraft < scale; ++iAircraft) {
+			cyclone::RigidBody						& aircraft							= Aircraft[iAircraft];
+			aircraft.Pivot.Position				= {0, 0, iAircraft * 10.0};
+			aircraft.Pivot.Orientation			= {1, 0, 0, 0};
+			aircraft.Mass.setMass(2.5);
+			aircraft.Mass.setInertiaTensor(tensor);
+			aircraft.Mass.setDamping(0.8, 0.8);
+			aircraft.Force.Acceleration			= cyclone::Vector3::GRAVITY;
+			aircraft.CalculateDerivedData();
+			aircraft.setAwake();
+			aircraft.setCanSleep(false);
+			Registry.Add(&aircraft, &LeftWing);
+			Registry.Add(&aircraft, &RightWing);
+			Registry.Add(&aircraft, &Rudder);
+			Registry.Add(&aircraft, &Tail);
+		}
+	}
+	virtual	const char*					GetName								()													const	{ return "flightsim"; }
+	virtual	uint32_t					GetBodyCount						()													const	{ return (uint32_t)Aircraft.size(); }
+	virtual	void						UpdateObjects						(double duration)											{
+		for (uint32_t iAircraft = 0; iAircraft < Aircraft.size(); ++iAircraft) {
+			cyclone::RigidBody						& aircraft							= Aircraft[iAircraft];
+			aircraft.clearAccumulators();
+			aircraft.addForce(aircraft.TransformMatrix.transformDirection({-10, 0, 0}));	// The propeller.
+		}
+		Registry.UpdateForces(duration);
+		for (uint32_t iAircraft = 0; iAircraft < Aircraft.size(); ++iAircraft)
+			Aircraft[iAircraft].Integrate(duration);
+	}
+	virtual	uint32_t					GenerateContacts					()															{
+		uint32_t								grounded							= 0;
+		for (uint32_t iAircraft = 0; iAircraft < Aircraft.size(); ++iAircraft) {
+			cyclone::RigidBody						& aircraft							= Aircraft[iAircraft];
+			if (aircraft.Pivot.Position.y >= 0)
+				continue;
+			aircraft.Pivot.Position.y			= 0;
+			if (aircraft.Force.Velocity.y < -10) {	// The demo resets a crashed aircraft.
+				aircraft.Pivot.Position				= {0, 0, iAircraft * 10.0};
+				aircraft.Pivot.Orientation			= {1, 0, 0, 0};
+				aircraft.Force.Velocity				= {};
+				aircraft.Force.Rotation				= {};
+			}
+			++grounded;
+		}
+		return grounded;
+	}
+};
+
+typedef	BenchmarkScene*			(*SceneFactory)						(uint32_t scale);
+
+template<typename _tScene>
+static	BenchmarkScene*			createScene							(uint32_t scale)											{ return new _tScene(scale); }
+
+static const struct { const char * Name; SceneFactory Create; }	sceneFactories	[]	=
+	{ {"bigballistic"	, createScene<BigBallisticScene	>}
+	, {"explosion"		, createScene<ExplosionScene	>}
+	, {"fracture"		, createScene<FractureScene		>}
+	, {"ragdoll"		, createScene<RagdollScene		>}
+	, {"bridge"			, createScene<BridgeScene		>}
+	, {"blob"			, createScene<BlobScene			>}
+	, {"fireworks"		, createScene<FireworksScene	>}
+	, {"sailboat"		, createScene<SailboatScene		>}
+	, {"flightsim"		, createScene<FlightSimScene	>}
+	};
+
+typedef	::std::chrono::steady_clock	TClock;
+
+static inline	double				secondsBetween						(TClock::time_point begin, TClock::time_point end)			{ return ::std::chrono::duration<double>(end - begin).count(); }
+
+// Runs the given scene for the given number of frames, storing the measurements of each frame and adding up the ones of the engine's instrumentation, which are only there when it's built with CYCLONE_PROFILE.
+static	void						runScene							(BenchmarkScene &scene, uint32_t frames, double duration, ::std::vector<FrameStats> &stats, cyclone::FrameStats &profile)	{
+	stats.assign(frames, FrameStats());
+	profile								= {};
+	cyclone::Profile::EndFrame();	// Drop what the setup of the scene measured.
+	for (uint32_t iFrame = 0; iFrame < frames; ++iFrame) {
+		FrameStats								& frame								= stats[iFrame];
+		{
+			CYCLONE_PROFILE_SCOPE(cyclone::PROFILE_SCOPE_STEP);
+			const TClock::time_point				start								= TClock::now();
+			scene.UpdateObjects(duration);
+			const TClock::time_point				integrated							= TClock::now();
+			frame.ContactCount					= scene.GenerateContacts();
+			const TClock::time_point				generated							= TClock::now();
+			scene.ResolveContacts(duration, frame);
+			const TClock::time_point				resolved							= TClock::now();
+			frame.Integrate						= secondsBetween(start, integrated);
+			frame.Contacts						= secondsBetween(integrated, generated);
+			frame.Resolve						= secondsBetween(generated, resolved);
+		}
+
+		const cyclone::FrameStats				ended								= cyclone::Profile::EndFrame();
+		for (uint32_t iScope = 0; iScope < cyclone::PROFILE_SCOPE_COUNT; ++iScope) {
+			profile.ScopeTime	[iScope]		+= ended.ScopeTime	[iScope];
+			profile.ScopeCalls	[iScope]		+= ended.ScopeCalls	[iScope];
+		}
+		for (uint32_t iCounter = 0; iCounter < cyclone::PROFILE_COUNTER_COUNT; ++iCounter)
+			profile.Counters[iCounter]			+= ended.Counters[iCounter];
+	}
+}
+
+// Writes the total, mean and largest value of a measurement over all the frames, with times in milliseconds.
+static	void						printSeries							(const char *name, const ::std::vector<FrameStats> &stats, double FrameStats::*time)	{
+	double									total								= 0;
+	double									largest								= 0;
+	for (uint32_t iFrame = 0; iFrame < stats.size(); ++iFrame) {
+		const double							value								= stats[iFrame].*time;
+		total								+= value;
+		largest								= (value > largest) ? value : largest;
+	}
+	printf("\"%s\": {\"total_ms\": %.6f, \"mean_ms\": %.6f, \"max_ms\": %.6f}", name, total * 1000, stats.empty() ? 0 : total * 1000 / stats.size(), largest * 1000);
+}
+
+static	void						printCounts							(const char *name, const ::std::vector<FrameStats> &stats, uint32_t FrameStats::*count)	{
+	uint64_t								total								= 0;
+	uint32_t								largest								= 0;
+	for (uint32_t iFrame = 0; iFrame < stats.size(); ++iFrame) {
+		const uint32_t							value								= stats[iFrame].*count;
+		total								+= value;
+		largest								= (value > largest) ? value : largest;
+	}
+	printf("\"%s\": {\"total\": %llu, \"mean\": %.3f, \"max\": %u}", name, (unsigned long long)total, stats.empty() ? 0 : (double)total / stats.size(), largest);
+}
+
+static	void						printUsage							()															{
+	fprintf(stderr,
+		"Usage: benchmark [options]\n"
+		"  -scene <name>     Runs only the given scene. Can be repeated. All the scenes run by default.\n"
+		"  -frames <count>   Sets the number of frames each scene runs for. The default is 600.\n"
+		"  -dt <seconds>     Sets the duration of each frame. The default is 1/60.\n"
+		"  -scale <count>    Multiplies the number of bodies in each scene. The default is 1.\n"
+		"  -perframe         Writes the measurements of every frame as well as the totals.\n"
+		"  -trace <file>     Records the timed phases of every frame and writes them to the given file as Chrome trace JSON.\n"
+		"                    The phases are only timed when the engine and the benchmark are built with CYCLONE_PROFILE.\n"
+		"Scenes:"
+		);
+	for (uint32_t iScene = 0; iScene < sizeof(sceneFactories) / sizeof(sceneFactories[0]); ++iScene)
+		fprintf(stderr, " %s", sceneFactories[iScene].Name);
+	fprintf(stderr, "\n");
+}
+
+int									main								(int argc, char **argv)										{
+	const uint32_t							sceneCount							= sizeof(sceneFactories) / sizeof(sceneFactories[0]);
+	bool									selected	[sceneCount]			= {};
+	bool									anySelected							= false;
+	uint32_t								frames								= 600;
+	double									duration							= 1.0 / 60;
+	uint32_t								scale								= 1;
+	bool									perFrame							= false;
+	const char								* traceFileName						= 0;
+	for (int iArg = 1; iArg < argc; ++iArg) {
+		const bool								hasValue							= iArg + 1 < argc;
+			 if (0 == strcmp(argv[iArg], "-frames"	) && hasValue) frames		= (uint32_t)strtoul(argv[++iArg], 0, 10);
+		else if (0 == strcmp(argv[iArg], "-dt"		) && hasValue) duration		= strtod(argv[++iArg], 0);
+		else if (0 == strcmp(argv[iArg], "-scale"	) && hasValue) scale		= (uint32_t)strtoul(argv[++iArg], 0, 10);
+		else if (0 == strcmp(argv[iArg], "-perframe")) perFrame	= true;
+		else if (0 == strcmp(argv[iArg], "-trace"	) && hasValue) traceFileName	= argv[++iArg];
+		else if (0 == strcmp(argv[iArg], "-scene"	) && hasValue) {
+			const char								* name								= argv[++iArg];
+			uint32_t								iScene								= 0;
+			while (iScene < sceneCount && strcmp(name, sceneFactories[iScene].Name))
+				++iScene;
+			if (iScene == sceneCount) {
+				fprintf(stderr, "Unknown scene: %s\n", name);
+				printUsage();
+				return EXIT_FAILURE;
+			}
+			selected[iScene]					= anySelected						= true;
+		}
+		else {
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (0 == frames || 0 == scale || !(duration > 0)) {
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (traceFileName)
+		cyclone::Profile::StartTrace();
+	printf("{\"frames\": %u, \"dt\": %.9g, \"scale\": %u, \"scenes\": [", frames, duration, scale);
+	::std::vector<FrameStats>				stats;
+	cyclone::FrameStats					profile;
+	bool									first								= true;
+	for (uint32_t iScene = 0; iScene < sceneCount; ++iScene) {
+		if (anySelected && !selected[iScene])
+			continue;
+		const TClock::time_point				start								= TClock::now();
+		::std::unique_ptr<BenchmarkScene>		scene								(sceneFactories[iScene].Create(scale));
+		const double							setup								= secondsBetween(start, TClock::now());
+		runScene(*scene, frames, duration, stats, profile);
+		double									total								= 0;
+		for (uint32_t iFrame = 0; iFrame < frames; ++iFrame)
+			total								+= stats[iFrame].Integrate + stats[iFrame].Contacts + stats[iFrame].Resolve;
+
+		printf("%s\n\t{\"name\": \"%s\", \"bodies\": %u, \"setup_ms\": %.6f, \"total_ms\": %.6f, \"frame_mean_ms\": %.6f,\n\t\t", first ? "" : ",", scene->GetName(), scene->GetBodyCount(), setup * 1000, total * 1000, total * 1000 / frames);
+		printSeries("integrate"				, stats, &FrameStats::Integrate				); printf(",\n\t\t");
+		printSeries("contacts"				, stats, &FrameStats::Contacts				); printf(",\n\t\t");
+		printSeries("resolve"				, stats, &FrameStats::Resolve				); printf(",\n\t\t");
+		printCounts("contact_count"			, stats, &FrameStats::ContactCount			); printf(",\n\t\t");
+		printCounts("velocity_iterations"	, stats, &FrameStats::VelocityIterations	); printf(",\n\t\t");
+		printCounts("position_iterations"	, stats, &FrameStats::PositionIterations	);
+#ifdef CYCLONE_PROFILE
+		printf(",\n\t\t\"profile\": {");
+		for (uint32_t iScope = 0; iScope < cyclone::PROFILE_SCOPE_COUNT; ++iScope)
+			printf("%s\"%s_ms\": %.6f", iScope ? ", " : "", cyclone::Profile::GetScopeName((cyclone::PROFILE_SCOPE)iScope), profile.ScopeTime[iScope] * 1e-6);
+		for (uint32_t iCounter = 0; iCounter < cyclone::PROFILE_COUNTER_COUNT; ++iCounter)
+			printf(", \"%s\": %llu", cyclone::Profile::GetCounterName((cyclone::PROFILE_COUNTER)iCounter), (unsigned long long)profile.Counters[iCounter]);
+		printf("}");
+#endif
+		if (perFrame) {
+			printf(",\n\t\t\"per_frame\": [");
+			for (uint32_t iFrame = 0; iFrame < frames; ++iFrame) {
+				const FrameStats						& frame								= stats[iFrame];
+				printf("%s\n\t\t\t[%.6f, %.6f, %.6f, %u, %u, %u]", iFrame ? "," : "", frame.Integrate * 1000, frame.Contacts * 1000, frame.Resolve * 1000, frame.ContactCount, frame.VelocityIterations, frame.PositionIterations);
+			}
+			printf("\n\t\t]");
+		}
+		printf("}");
+		first								= false;
+	}
+	printf("\n]}\n");
+	if (traceFileName) {
+		cyclone::Profile::StopTrace();
+		if (!cyclone::Profile::WriteTrace(traceFileName)) {
+			fprintf(stderr, "Failed to write the trace to %s\n", traceFileName);
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
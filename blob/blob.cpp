@@ -283,7 +283,7 @@ void BlobDemo::Display() {
 void BlobDemo::Update() {
 	World.StartFrame();	// Clear accumulators
 
-	double							duration				= TimingData::get().LastFrameDuration * 0.001;	// Find the duration of the last frame in seconds
+	double							duration				= TimingData::get().LastFrameSeconds;	// Find the duration of the last frame in seconds
 	if (duration <= 0.0f) 
 		return;
 	
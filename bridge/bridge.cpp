@@ -17,9 +17,7 @@
 
 // The main demo class definition.
 class BridgeDemo : public MassAggregateApplication {
-	::cyclone::ParticleCableConstraint	* supports					= 0;
-	::cyclone::ParticleCable			* cables					= 0;
-	::cyclone::ParticleRod				* rods						= 0;
+	::cyclone::ParticleLinkSet			Links						= {};	// Holds the cables first, then the supports and then the rods.
 	
 	::cyclone::Vector3					MassPos						= {0, 0, 0.5f};
 	::cyclone::Vector3					MassDisplayPos				= {};
@@ -55,49 +53,29 @@ BridgeDemo::BridgeDemo() : MassAggregateApplication(12) {
     }
 
     // Add the links
-    cables = new cyclone::ParticleCable[CABLE_COUNT];
-    for (uint32_t i = 0; i < 10; i++) {
-        cables[i].Particle[0]				= &ParticleArray[i];
-        cables[i].Particle[1]				= &ParticleArray[i+2];
-        cables[i].MaxLength					= 1.9f;
-        cables[i].Restitution				= 0.3f;
-        World.ContactGenerators.push_back(&cables[i]);
-    }
+    Links.Particles = ParticleArray;
+    for (uint32_t i = 0; i < CABLE_COUNT; i++)
+        Links.AddCable(i, i+2, 1.9f, 0.3f);
 
-    supports = new cyclone::ParticleCableConstraint[SUPPORT_COUNT];
     for (uint32_t i = 0; i < SUPPORT_COUNT; i++)
     {
-        supports[i].Particle = ParticleArray + i;
-        supports[i].Anchor = 
+        const cyclone::Vector3 anchor =
             {	double(i/2)*2.2f-5.5f
             ,	6
             ,	double(i%2)*1.6f-0.8f
             };
-        
-		if (i < 6)	supports[i].MaxLength = double(i/2)*0.5f + 3.0f;
-        else		supports[i].MaxLength = 5.5f - double(i/2)*0.5f;
-        
-		supports[i].Restitution = 0.5f;
-        World.ContactGenerators.push_back(&supports[i]);
+        Links.AddAnchoredCable(i, anchor, (i < 6) ? double(i/2)*0.5f + 3.0f : 5.5f - double(i/2)*0.5f, 0.5f);
     }
 
-    rods = new cyclone::ParticleRod[ROD_COUNT];
-    for (uint32_t i = 0; i < 6; i++)
-    {
-        rods[i].Particle[0] = &ParticleArray[i*2];
-        rods[i].Particle[1] = &ParticleArray[i*2+1];
-        rods[i].Length = 2;
-        World.ContactGenerators.push_back(&rods[i]);
-    }
+    for (uint32_t i = 0; i < ROD_COUNT; i++)
+        Links.AddRod(i*2, i*2+1, 2);
+
+    World.ContactGenerators.push_back(&Links);
 
     UpdateAdditionalMass();
 }
 
-BridgeDemo::~BridgeDemo() {
-    if (cables)		delete[] cables;
-    if (rods)		delete[] rods;
-    if (supports)	delete[] supports;
-}
+BridgeDemo::~BridgeDemo() {}
 
 void BridgeDemo::UpdateAdditionalMass()
 {
@@ -158,31 +136,15 @@ void BridgeDemo::Display()
     MassAggregateApplication::Display();
 
     glBegin(GL_LINES);
-    glColor3f(0,0,1);
-    for (uint32_t i = 0; i < ROD_COUNT; i++)
+    for (uint32_t i = 0; i < Links.Size(); i++)
     {
-        cyclone::Particle **particles = rods[i].Particle;
-        const cyclone::Vector3 &p0 = particles[0]->Position;
-        const cyclone::Vector3 &p1 = particles[1]->Position;
-        glVertex3f(p0.x, p0.y, p0.z);
-        glVertex3f(p1.x, p1.y, p1.z);
-    }
-
-    glColor3f(0,1,0);
-    for (uint32_t i = 0; i < CABLE_COUNT; i++)
-    {
-        cyclone::Particle **particles = cables[i].Particle;
-        const cyclone::Vector3 &p0 = particles[0]->Position;
-        const cyclone::Vector3 &p1 = particles[1]->Position;
-        glVertex3f(p0.x, p0.y, p0.z);
-        glVertex3f(p1.x, p1.y, p1.z);
-    }
-
-    glColor3f(0.7f, 0.7f, 0.7f);
-    for (uint32_t i = 0; i < SUPPORT_COUNT; i++)
-    {
-        const cyclone::Vector3 &p0 = supports[i].Particle->Position;
-        const cyclone::Vector3 &p1 = supports[i].Anchor;
+        switch (Links.Type[i]) {
+        case cyclone::PARTICLE_LINK_TYPE_ROD			: glColor3f(0,0,1); break;
+        case cyclone::PARTICLE_LINK_TYPE_CABLE			: glColor3f(0,1,0); break;
+        default											: glColor3f(0.7f, 0.7f, 0.7f); break;
+        }
+        const cyclone::Vector3 &p0 = ParticleArray[Links.ParticleA[i]].Position;
+        const cyclone::Vector3 &p1 = (Links.Type[i] & cyclone::PARTICLE_LINK_TYPE_ANCHORED_CABLE) ? Links.Anchors[Links.ParticleB[i]] : ParticleArray[Links.ParticleB[i]].Position;
         glVertex3f(p0.x, p0.y, p0.z);
         glVertex3f(p1.x, p1.y, p1.z);
     }
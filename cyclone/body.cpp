@@ -57,11 +57,25 @@ static inline	void					_calculateTransformMatrix				(Matrix4 &transformMatrix, c
 
 void									RigidBody::CalculateDerivedData			()																						{
 	Pivot.Orientation.normalise();
-	_calculateTransformMatrix	(TransformMatrix, Pivot.Position, Pivot.Orientation);	// Calculate the transform matrix for the body.
+	CalculateTransforms();
+}
+
+void									RigidBody::CalculateTransforms			()																						{
+	Matrix4										transformMatrix;
+	_calculateTransformMatrix	(transformMatrix, Pivot.Position, Pivot.Orientation);	// Calculate the transform matrix for the body.
+	if (!(transformMatrix == TransformMatrix)) {	// Bodies that didn't move keep their generation, so sleeping bodies don't invalidate the transforms of their primitives.
+		TransformMatrix							= transformMatrix;
+		++TransformGeneration;
+	}
 	_transformInertiaTensor		(InverseInertiaTensorWorld, Pivot.Orientation, Mass.InverseInertiaTensor, TransformMatrix);	// Calculate the inertiaTensor in world space.
 }
 
 void									RigidBody::Integrate					(double duration)																		{
+	if (IsAwake)
+		Integrate(duration, real_pow(Mass.LinearDamping, duration), real_pow(Mass.AngularDamping, duration), real_pow(0.5, duration));
+}
+
+void									RigidBody::Integrate					(double duration, double linearDampingFactor, double angularDampingFactor, double motionBiasFactor)	{
 	if (!IsAwake) 
 		return;
 	
@@ -76,8 +90,8 @@ void									RigidBody::Integrate					(double duration)																		{
 	Force.Rotation.addScaledVector(angularAcceleration, duration);	// Update angular velocity from both acceleration and impulse.
 	
 	// Impose drag.
-	Force.Velocity								*= real_pow(Mass.LinearDamping, duration);
-	Force.Rotation								*= real_pow(Mass.AngularDamping, duration);
+	Force.Velocity								*= linearDampingFactor;
+	Force.Rotation								*= angularDampingFactor;
 	
 	// Adjust positions
 	Pivot.Position		.addScaledVector(Force.Velocity, duration);	// Update linear position.
@@ -87,8 +101,7 @@ void									RigidBody::Integrate					(double duration)																		{
 	
 	if (CanSleep) {	// Update the kinetic energy store, and possibly put the body to sleep.
 		double										currentMotion	= Force.Velocity.scalarProduct(Force.Velocity) + Force.Rotation.scalarProduct(Force.Rotation);
-		double										bias			= real_pow(0.5, duration);
-		Motion									= bias * Motion + (1 - bias) * currentMotion;
+		Motion									= motionBiasFactor * Motion + (1 - motionBiasFactor) * currentMotion;
 		if (Motion < sleepEpsilon) 
 			setAwake(false);
 		else if (Motion > 10 * sleepEpsilon) 
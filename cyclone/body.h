@@ -15,6 +15,8 @@ namespace cyclone {
 				Matrix3						InverseInertiaTensor;
 				double						LinearDamping;
 				double						AngularDamping;
+				uint16_t					LinearDampingClass;		// Holds the class of LinearDamping in the damping table of the world that integrates the body. Set by World::AddBody, and again by the world when the damping changes. DampingTable::InvalidClass if the table was full.
+				uint16_t					AngularDampingClass;
 
 		inline	void						setInertiaTensor				(const Matrix3 &inertiaTensor)													{ InverseInertiaTensor.setInverse(inertiaTensor); checkInverseInertiaTensor(InverseInertiaTensor);	}
 		inline	void						setInverseInertiaTensor			(const Matrix3 &inverseInertiaTensor)											{ checkInverseInertiaTensor(inverseInertiaTensor); InverseInertiaTensor = inverseInertiaTensor;		}
@@ -48,13 +50,18 @@ namespace cyclone {
 				bool						IsAwake;
 				bool						CanSleep;
 				Matrix4						TransformMatrix;
+				uint32_t					Id;						// Holds the index the world gave the body when it was added, which orders its contacts in deterministic mode.
+				uint32_t					TransformGeneration;	// Holds a counter that CalculateDerivedData increments whenever the transform matrix actually changes, so the primitives attached to the body can tell when their cached transforms are stale.
 				Matrix3						InverseInertiaTensorWorld;
 				Vector3						AccumulatedForce;
 				Vector3						AccumulatedTorque;
 				Vector3						LastFrameAcceleration;
 				
 				void						CalculateDerivedData			();
+				void						CalculateTransforms				();	// Updates the matrices from the position and orientation as they are, without normalising the orientation first. Used to restore a saved state bit for bit.
 				void						Integrate						(double duration);
+				// Integrates the body with the given factors instead of raising the damping values and the motion bias of the sleep test to the power of the duration. Used by World, which takes the factors from its damping table.
+				void						Integrate						(double duration, double linearDampingFactor, double angularDampingFactor, double motionBiasFactor);
 
 				void						getGLTransform					(float matrix[16])													const;
 				void						setAwake						(const bool awake = true);
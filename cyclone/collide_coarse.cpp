@@ -2,6 +2,8 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "collide_coarse.h"
 
+#include <algorithm>
+
 using namespace cyclone;
 
 BoundingSphere::BoundingSphere(const BoundingSphere &one, const BoundingSphere &two)
@@ -40,4 +42,248 @@ bool BoundingSphere::Overlaps(const BoundingSphere *other) const {
 double BoundingSphere::GetGrowth(const BoundingSphere &other) const {
 	BoundingSphere newSphere(*this, other);
 	return newSphere.Radius * newSphere.Radius - Radius * Radius;	// We return a value proportional to the change in surface area of the sphere.
-}
\ No newline at end of file
+}
+
+BoundingBox								BoundingBox::FromSphere					(const CollisionSphere &sphere)															{
+	const Vector3								centre									= sphere.GetAxis(3);
+	const Vector3								extent									= {sphere.Radius, sphere.Radius, sphere.Radius};
+	return {centre - extent, centre + extent};
+}
+
+BoundingBox								BoundingBox::FromBox					(const CollisionBox &box)																{
+	// The extent along each world axis is the sum of the half-sizes projected onto it.
+	const double								* m										= box.Transform.data;
+	const Vector3								extent									=
+		{ real_abs(m[0]) * box.HalfSize.x + real_abs(m[1]) * box.HalfSize.y + real_abs(m[ 2]) * box.HalfSize.z
+		, real_abs(m[4]) * box.HalfSize.x + real_abs(m[5]) * box.HalfSize.y + real_abs(m[ 6]) * box.HalfSize.z
+		, real_abs(m[8]) * box.HalfSize.x + real_abs(m[9]) * box.HalfSize.y + real_abs(m[10]) * box.HalfSize.z
+		};
+	const Vector3								centre									= box.GetAxis(3);
+	return {centre - extent, centre + extent};
+}
+
+uint32_t								BroadPhase::InsertProxy					(CollisionPrimitive * primitive, SHAPE_TYPE type)										{
+	uint32_t									index									= (uint32_t)Proxies.size();
+	if(FreeProxies.size()) {
+		index									= FreeProxies.back();
+		FreeProxies.pop_back();
+	}
+	else
+		Proxies.push_back({});
+
+	CollisionProxy								& proxy									= Proxies[index];
+	proxy.Primitive							= primitive;
+	proxy.Type								= type;
+	proxy.Bounds							= {};
+	NeedsRebuild							= true;
+	return index;
+}
+
+uint32_t								BroadPhase::Insert						(CollisionSphere * sphere)																{ return InsertProxy(sphere	, SHAPE_TYPE_SPHERE	); }
+uint32_t								BroadPhase::Insert						(CollisionBox * box)																	{ return InsertProxy(box	, SHAPE_TYPE_BOX	); }
+void									BroadPhase::Remove						(uint32_t proxy)																		{
+	if(proxy >= Proxies.size() || 0 == Proxies[proxy].Primitive)
+		return;
+	Proxies[proxy].Primitive				= 0;
+	FreeProxies.push_back(proxy);
+	NeedsRebuild							= true;
+}
+
+void									BroadPhase::Update						()																						{
+	bool										moved									= false;
+	for(uint32_t iProxy = 0; iProxy < Proxies.size(); ++iProxy) {
+		CollisionProxy								& proxy									= Proxies[iProxy];
+		const CollisionPrimitive					* primitive								= proxy.Primitive;
+		if(0 == primitive)
+			continue;
+		if(proxy.Layer != primitive->CollisionLayer || proxy.Mask != primitive->CollisionMask) {
+			proxy.Layer								= primitive->CollisionLayer;
+			proxy.Mask								= primitive->CollisionMask;
+			moved									= true;
+		}
+		if(!NeedsRebuild && proxy.TransformGeneration == primitive->TransformGeneration)	// Only the primitives that moved need new bounds.
+			continue;
+		switch(proxy.Type) {
+		case SHAPE_TYPE_SPHERE	: proxy.Bounds = BoundingBox::FromSphere(*(const CollisionSphere*)primitive); break;
+		case SHAPE_TYPE_BOX		: proxy.Bounds = BoundingBox::FromBox	(*(const CollisionBox*)primitive);	break;
+		default: break;
+		}
+		proxy.TransformGeneration				= primitive->TransformGeneration;
+		moved									= true;
+	}
+
+	if(!NeedsRebuild) {
+		if(moved)
+			Refit();
+		return;
+	}
+
+	NeedsRebuild							= false;
+	Leaves.clear();
+	for(uint32_t iProxy = 0; iProxy < Proxies.size(); ++iProxy)
+		if(Proxies[iProxy].Primitive)
+			Leaves.push_back(iProxy);
+
+	Nodes.clear();
+	if(0 == Leaves.size())
+		return;
+	Nodes.push_back({});
+	Build(0, 0, (uint32_t)Leaves.size());
+}
+
+// Recalculates the node bounds from the current proxy bounds, keeping the shape of the tree. Children are always stored after their parent, so walking the nodes backwards visits the children first.
+void									BroadPhase::Refit						()																						{
+	for(uint32_t iNode = (uint32_t)Nodes.size(); iNode-- > 0; ) {
+		BVHNode										& node									= Nodes[iNode];
+		if(node.IsLeaf()) {
+			const CollisionProxy						& first									= Proxies[Leaves[node.First]];
+			node.Bounds								= first.Bounds;
+			node.Layers								= first.Layer;
+			for(uint32_t iLeaf = node.First + 1; iLeaf < node.First + node.Count; ++iLeaf) {
+				const CollisionProxy						& proxy									= Proxies[Leaves[iLeaf]];
+				node.Bounds.Merge(proxy.Bounds);
+				node.Layers								|= proxy.Layer;
+			}
+		}
+		else {
+			const BVHNode								& left									= Nodes[node.First];
+			const BVHNode								& right									= Nodes[node.First + 1];
+			node.Bounds								= left.Bounds;
+			node.Bounds.Merge(right.Bounds);
+			node.Layers								= left.Layers | right.Layers;
+		}
+	}
+}
+
+// Splits the given range of the leaf list at the median of the longest axis of the proxy centres. This keeps the tree balanced regardless of how the primitives are distributed.
+void									BroadPhase::Build						(uint32_t node, uint32_t begin, uint32_t end)											{
+	BoundingBox									bounds									= Proxies[Leaves[begin]].Bounds;
+	BoundingBox									centres									= {bounds.GetCentre(), bounds.GetCentre()};
+	uint32_t									layers									= Proxies[Leaves[begin]].Layer;
+	for(uint32_t iLeaf = begin + 1; iLeaf < end; ++iLeaf) {
+		const CollisionProxy						& proxy									= Proxies[Leaves[iLeaf]];
+		const Vector3								centre									= proxy.Bounds.GetCentre();
+		bounds.Merge(proxy.Bounds);
+		centres.Merge({centre, centre});
+		layers									|= proxy.Layer;
+	}
+	Nodes[node].Bounds						= bounds;
+	Nodes[node].Layers						= layers;
+	if(end - begin <= MaxLeafSize) {
+		Nodes[node].First						= begin;
+		Nodes[node].Count						= end - begin;
+		return;
+	}
+
+	const Vector3								spread									= centres.Max - centres.Min;
+	const uint32_t								axis									= (spread.x > spread.y && spread.x > spread.z) ? 0 : (spread.y > spread.z) ? 1 : 2;
+	const uint32_t								middle									= begin + (end - begin) / 2;
+	const ::std::vector<CollisionProxy>			& proxies								= Proxies;
+	::std::nth_element(Leaves.begin() + begin, Leaves.begin() + middle, Leaves.begin() + end, [&proxies, axis](uint32_t a, uint32_t b) { 
+		return proxies[a].Bounds.Min[axis] + proxies[a].Bounds.Max[axis] < proxies[b].Bounds.Min[axis] + proxies[b].Bounds.Max[axis]; 
+	});
+
+	const uint32_t								children								= (uint32_t)Nodes.size();
+	Nodes[node].First						= children;
+	Nodes[node].Count						= 0;
+	Nodes.push_back({});
+	Nodes.push_back({});
+	Build(children		, begin	, middle);
+	Build(children + 1	, middle, end);
+}
+
+uint32_t								BroadPhase::Query						(const BoundingBox &volume, uint32_t* proxies, uint32_t limit)					const	{
+	if(0 == Nodes.size() || 0 == limit)
+		return 0;
+
+	uint32_t									count									= 0;
+	uint32_t									stack	[64];
+	uint32_t									stackSize								= 0;
+	stack[stackSize++]						= 0;
+	while(stackSize) {
+		const BVHNode								& node									= Nodes[stack[--stackSize]];
+		if(!node.Bounds.Overlaps(volume))
+			continue;
+		if(node.IsLeaf()) {
+			for(uint32_t iLeaf = node.First; iLeaf < node.First + node.Count; ++iLeaf) {
+				const uint32_t								proxy									= Leaves[iLeaf];
+				if(!Proxies[proxy].Bounds.Overlaps(volume))
+					continue;
+				proxies[count++]						= proxy;
+				if(count >= limit)
+					return count;
+			}
+		}
+		else {
+			stack[stackSize++]						= node.First;
+			stack[stackSize++]						= node.First + 1;
+		}
+	}
+	return count;
+}
+
+static inline	BodyPair				makeBodyPair							(const RigidBody * one, const RigidBody * two)											{ return (one < two) ? BodyPair{{one, two}} : BodyPair{{two, one}}; }
+
+void									BroadPhase::ExcludePair					(const RigidBody * one, const RigidBody * two)											{
+	const BodyPair								pair									= makeBodyPair(one, two);
+	const ::std::vector<BodyPair>::iterator		position								= ::std::lower_bound(Exclusions.begin(), Exclusions.end(), pair);
+	if(position == Exclusions.end() || !(*position == pair))
+		Exclusions.insert(position, pair);
+}
+
+void									BroadPhase::IncludePair					(const RigidBody * one, const RigidBody * two)											{
+	const BodyPair								pair									= makeBodyPair(one, two);
+	const ::std::vector<BodyPair>::iterator		position								= ::std::lower_bound(Exclusions.begin(), Exclusions.end(), pair);
+	if(position != Exclusions.end() && *position == pair)
+		Exclusions.erase(position);
+}
+
+bool									BroadPhase::IsExcluded					(const RigidBody * one, const RigidBody * two)									const	{
+	const BodyPair								pair									= makeBodyPair(one, two);
+	return ::std::binary_search(Exclusions.begin(), Exclusions.end(), pair);
+}
+
+uint32_t								BroadPhase::GetPotentialContacts		(PotentialContact* contacts, uint32_t limit)											{
+	Stats									= {};
+	uint32_t									count									= 0;
+	uint32_t									stack	[64];
+	for(uint32_t iLeaf = 0; iLeaf < Leaves.size() && count < limit; ++iLeaf) {	// Walk the tree once for each proxy, only keeping the pairs where the other proxy has a higher index so each pair is reported once.
+		const uint32_t								proxy									= Leaves[iLeaf];
+		const CollisionProxy						& registration							= Proxies[proxy];
+		const BoundingBox							& volume								= registration.Bounds;
+		uint32_t									stackSize								= 0;
+		stack[stackSize++]						= 0;
+		while(stackSize && count < limit) {
+			const BVHNode								& node									= Nodes[stack[--stackSize]];
+			if(0 == (node.Layers & registration.Mask) || !node.Bounds.Overlaps(volume))
+				continue;
+			if(node.IsLeaf()) {
+				for(uint32_t iOther = node.First; iOther < node.First + node.Count; ++iOther) {
+					const uint32_t								other									= Leaves[iOther];
+					const CollisionProxy						& otherRegistration						= Proxies[other];
+					if(other <= proxy || !otherRegistration.Bounds.Overlaps(volume))
+						continue;
+					++Stats.PairsOverlapping;
+					if(0 == (registration.Layer & otherRegistration.Mask) || 0 == (otherRegistration.Layer & registration.Mask)) {
+						++Stats.PairsFilteredByLayer;
+						continue;
+					}
+					if(Exclusions.size() && IsExcluded(registration.Primitive->Body, otherRegistration.Primitive->Body)) {
+						++Stats.PairsExcluded;
+						continue;
+					}
+					++Stats.PairsReported;
+					contacts[count].Proxy[0]				= proxy;
+					contacts[count].Proxy[1]				= other;
+					if(++count >= limit)
+						break;
+				}
+			}
+			else {
+				stack[stackSize++]						= node.First;
+				stack[stackSize++]						= node.First + 1;
+			}
+		}
+	}
+	return count;
+}
@@ -1,7 +1,7 @@
 // This file contains the coarse collision detection system. It is used to return pairs of objects that may be in contact, which can then be tested using fined grained methods.
 // Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
-#include "contacts.h"
+#include "collide_fine.h"
 
 #include <vector>
 #include <cstddef>
@@ -28,142 +28,116 @@ namespace cyclone {
 		double						GetSize						()																const		{ return 1.333333 * R_PI * Radius * Radius * Radius; }
 	};
 
-	// Stores a potential contact to check later.
-	//struct PotentialContact {
-	//	RigidBody *					Body		[2]				= {};	// Holds the bodies that might be in contact.
-	//};
-
-	//// A base class for nodes in a bounding volume hierarchy. This class uses a binary tree to store the bounding volumes.
-	//template<class BoundingVolumeClass>
-	//struct BVHNode {
-	//	BVHNode *					Children	[2]				= {};	// Holds the child nodes of this node.
-	//	BoundingVolumeClass			Volume						= {};	// Holds a single bounding volume encompassing all the descendents of this node.
-
-	//	// Holds the rigid body at this node of the hierarchy. Only leaf nodes can have a rigid body defined (see isLeaf).
-	//	// Note that it is possible to rewrite the algorithms in this class to handle objects at all levels of the hierarchy, but the code provided ignores this vector unless firstChild is NULL.
-	//	RigidBody					* Body						= 0;
-	//	BVHNode						* Parent					= 0;	// Holds the node immediately above us in the tree.
-
-	//	// Creates a new node in the hierarchy with the given parameters.
-	//								BVHNode						(BVHNode *parent, const BoundingVolumeClass &volume, RigidBody* body=NULL)	: parent(parent), volume(volume), body(body)				{}
-	//	
-	//	// Checks if this node is at the bottom of the hierarchy.
-	//	bool						isLeaf						()																															const		{ return (body != NULL); }
-	//	
-	//	// Checks the potential contacts from this node downwards in the hierarchy, writing them to the given array (up to the given limit). Returns the number of potential contacts it found.
-	//	uint32_t					getPotentialContacts		(PotentialContact* contacts, uint32_t limit)																				const		{
-	//		if (isLeaf() || limit == 0)		// Early out if we don't have the room for contacts, or if we're a leaf node.
-	//			return 0;
-	//		return children[0]->getPotentialContactsWith(children[1], contacts, limit);	// Get the potential contacts of one of our children with the other
-	//	}
-	//	void						insert						(RigidBody* body, const BoundingVolumeClass &volume);	// Inserts the given rigid body, with the given bounding volume, into the hierarchy. This may involve the creation of further bounding volume nodes.
-
-	//	// Deletes this node, removing it first from the hierarchy, along with its associated rigid body and child nodes. This method deletes the node and all its children (but obviously not the rigid bodies). 
-	//	// This also has the effect of deleting the sibling of this node, and changing the parent node so that it contains the data currently in that sibling. Finally it forces the hierarchy above the current node to reconsider its bounding volume.
-	//								~BVHNode					();
-	//protected:
-	//	// Checks for overlapping between nodes in the hierarchy. Note that any bounding volume should have an overlaps method implemented that checks for overlapping with another object of its own type.
-	//	bool						overlaps					(const BVHNode<BoundingVolumeClass> *other)																					const			{ return volume->overlaps(other->volume); }	
-	//	uint32_t					getPotentialContactsWith	(const BVHNode<BoundingVolumeClass> *other, PotentialContact* contacts, uint32_t limit) const;	// Checks the potential contacts between this node and the given other node, writing them to the given array (up to the given limit). Returns the number of potential contacts it found.
-	//	void						recalculateBoundingVolume	(bool recurse = true);	// For non-leaf nodes, this method recalculates the bounding volume based on the bounding volumes of its children.
-	//};
-
-	//template<class BoundingVolumeClass>
-	//			BVHNode<BoundingVolumeClass>::~BVHNode						()																									{
-	//	// If we don't have a parent, then we ignore the sibling processing
-	//	if (parent) {	// Find our sibling
-	//		BVHNode<BoundingVolumeClass>		*sibling	= 0;
-	//		if (parent->children[0] == this) 
-	//			sibling = parent->children[1];
-	//		else 
-	//			sibling = parent->children[0];
-
-	//		// Write its data to our parent
-	//		parent->volume			= sibling->volume;
-	//		parent->body			= sibling->body;
-	//		parent->children[0]		= sibling->children[0];
-	//		parent->children[1]		= sibling->children[1];
-
-	//		// Delete the sibling (we blank its parent and children to avoid processing/deleting them)
-	//		*sibling				= {};
-	//		sibling->parent			= NULL;
-	//		sibling->body			= NULL;
-	//		sibling->children[0]	= NULL;
-	//		sibling->children[1]	= NULL;
-	//		delete sibling;
-
-	//		parent->recalculateBoundingVolume();	// Recalculate the parent's bounding volume
-	//	}
-
-	//	// Delete our children (again we remove their parent data so we don't try to process their siblings as they are deleted).
-	//	if (children[0]) {
-	//		children[0]->parent		= NULL;
-	//		delete children[0];
-	//	}
-	//	if (children[1]) {
-	//		children[1]->parent		= NULL;
-	//		delete children[1];
-	//	}
-	//}
-
-	//template<class BoundingVolumeClass>
-	//void		BVHNode<BoundingVolumeClass>::insert						(RigidBody* newBody, const BoundingVolumeClass &newVolume)											{
-	//	if (isLeaf()) {	// If we are a leaf, then the only option is to spawn two new children and place the new body in one.
-	//		children[0]				= new BVHNode<BoundingVolumeClass>(this, volume, body);			// Child one is a copy of us.
-	//		children[1]				= new BVHNode<BoundingVolumeClass>(this, newVolume, newBody);	// Child two holds the new body
-	//		this->body				= NULL;	// And we now loose the body (we're no longer a leaf)
-
-	//		recalculateBoundingVolume();	// We need to recalculate our bounding volume
-	//	}
-	//	else {	// Otherwise we need to work out which child gets to keep the inserted body. We give it to whoever would grow the least to incorporate it.
-	//		if (children[0]->volume.getGrowth(newVolume) < children[1]->volume.getGrowth(newVolume))
-	//			children[0]->insert(newBody, newVolume);
-	//		else
-	//			children[1]->insert(newBody, newVolume);
-	//	}
-	//}
-
-	//template<class BoundingVolumeClass>
-	//void		BVHNode<BoundingVolumeClass>::recalculateBoundingVolume		(bool recurse)																						{
-	//	if(isLeaf()) 
-	//		return;
-	//	volume = BoundingVolumeClass(children[0]->volume, children[1]->volume);	// Use the bounding volume combining constructor.
-	//	if(parent) // Recurse up the tree
-	//		parent->recalculateBoundingVolume(true);
-	//}
-
-	//template<class BoundingVolumeClass>
-	//uint32_t	BVHNode<BoundingVolumeClass>::getPotentialContactsWith		(const BVHNode<BoundingVolumeClass> *other, PotentialContact* contacts, uint32_t limit)		const	{
-	//	if (!overlaps(other) || limit == 0)		// Early out if we don't overlap or if we have no room to report contacts
-	//		return 0;
-
-	//	if (isLeaf() && other->isLeaf()) {	// If we're both at leaf nodes, then we have a potential contact
-	//		contacts->body[0] = body;
-	//		contacts->body[1] = other->body;
-	//		return 1;
-	//	}
-
-	//	// Determine which node to descend into. If either is a leaf, then we descend the other. If both are branches, then we use the one with the largest size.
-	//	if( other->isLeaf() 
-	//	 || (!isLeaf() && volume->getSize() >= other->volume->getSize())
-	//	 )
-	//	{
-	//		uint32_t count = children[0]->getPotentialContactsWith(other, contacts, limit);	// Recurse into ourself
-
-	//		if (limit > count) 	// Check we have enough slots to do the other side too
-	//			return count + children[1]->getPotentialContactsWith(other, contacts+count, limit-count);
-	//		else 
-	//			return count;
-	//	}
-	//	else {	// Recurse into the other node
-	//		uint32_t count = getPotentialContactsWith(other->children[0], contacts, limit);
-
-	//		if (limit > count) 	// Check we have enough slots to do the other side too
-	//			return count + getPotentialContactsWith(other->children[1], contacts+count, limit-count);
-	//		else 
-	//			return count;
-	//	}
-	//}
+	// Represents an axis-aligned bounding box that can be tested for overlap. This is the volume stored in the nodes of the broad phase tree.
+	struct BoundingBox {
+		Vector3						Min							= {};	// Holds the corner with the lowest coordinates.
+		Vector3						Max							= {};	// Holds the corner with the highest coordinates.
+
+		inline	bool				Overlaps					(const BoundingBox &other)										const		{ return Min <= other.Max && Max >= other.Min;											}	// Checks if the bounding box overlaps with the other given bounding box. Touching boxes are considered to overlap.
+		inline	Vector3				GetCentre					()																const		{ return (Min + Max) * 0.5;																}
+		inline	Vector3				GetHalfSize					()																const		{ return (Max - Min) * 0.5;																}
+		// Returns the surface area of the box, as a measure of its size like the volume of BoundingSphere::GetSize. The tree builder doesn't use it: it splits each node at the median centre along the axis its centres spread furthest.
+		inline	double				GetSize						()																const		{ const Vector3 d = Max - Min; return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);			}
+		inline	void				Expand						(const Vector3 &margin)														{ Min -= margin; Max += margin;															}	// Grows the box by the given amount along each axis, on both sides.
+		inline	void				Merge						(const BoundingBox &other)													{	// Grows the box so it encloses the given box.
+			if(other.Min.x < Min.x) Min.x = other.Min.x;
+			if(other.Min.y < Min.y) Min.y = other.Min.y;
+			if(other.Min.z < Min.z) Min.z = other.Min.z;
+			if(other.Max.x > Max.x) Max.x = other.Max.x;
+			if(other.Max.y > Max.y) Max.y = other.Max.y;
+			if(other.Max.z > Max.z) Max.z = other.Max.z;
+		}
+
+		static	BoundingBox			FromSphere					(const CollisionSphere &sphere);	// Returns the world space bounds of the given sphere. The sphere internals must be up to date.
+		static	BoundingBox			FromBox						(const CollisionBox &box);			// Returns the world space bounds of the given oriented box. The box internals must be up to date.
+	};
+
+	// Identifies the concrete type of a primitive registered with the broad phase, so the fine grained tests can be selected without virtual calls.
+	enum SHAPE_TYPE : uint8_t
+		{	SHAPE_TYPE_SPHERE		= 0
+		,	SHAPE_TYPE_BOX
+		,	SHAPE_TYPE_COUNT
+		};
+
+	// Holds a primitive registered with the broad phase, along with its type and its world space bounds as of the last update.
+	// The collision layer and mask are copied from the primitive on each update, so filtering pairs doesn't need to touch the primitives.
+	struct CollisionProxy {
+		CollisionPrimitive			* Primitive					= 0;	// The registered primitive. This is NULL for free slots.
+		SHAPE_TYPE					Type						= SHAPE_TYPE_SPHERE;
+		BoundingBox					Bounds						= {};
+		uint32_t					Layer						= 0;
+		uint32_t					Mask						= 0;
+		uint32_t					TransformGeneration			= 0;	// Holds the transform generation of the primitive when the bounds were last calculated.
+	};
+
+	// Holds a pair of bodies whose primitives must never be reported as potential contacts, such as the two bodies of a joint. The bodies are stored in address order so each pair has a single representation.
+	struct BodyPair {
+		const RigidBody				* Body		[2]				= {};
+
+		inline	bool				operator<					(const BodyPair &other)											const		{ return (Body[0] != other.Body[0]) ? Body[0] < other.Body[0] : Body[1] < other.Body[1];	}
+		inline	bool				operator==					(const BodyPair &other)											const		{ return Body[0] == other.Body[0] && Body[1] == other.Body[1];								}
+	};
+
+	// Holds the counters of the last search for potential contacts.
+	struct BroadPhaseStats {
+		uint32_t					PairsOverlapping			= 0;	// Holds the number of pairs whose bounds overlap.
+		uint32_t					PairsFilteredByLayer		= 0;	// Holds the number of overlapping pairs rejected because their layers and masks don't match. Subtrees skipped whole because none of their layers match aren't counted.
+		uint32_t					PairsExcluded				= 0;	// Holds the number of overlapping pairs rejected by the pair exclusion set.
+		uint32_t					PairsReported				= 0;	// Holds the number of potential contacts written.
+	};
+
+	// Stores a potential contact to check later. The indices refer to the proxies of the broad phase that reported the pair.
+	struct PotentialContact {
+		uint32_t					Proxy		[2]				= {};
+	};
+
+	// A node of the flattened bounding volume hierarchy. The children of a branch are always stored next to each other, so a single index is enough to find both of them.
+	struct BVHNode {
+		BoundingBox					Bounds						= {};	// Holds a single bounding volume encompassing all the descendents of this node.
+		uint32_t					First						= 0;	// For branches this is the index of the first child node. For leaves it is the index of the first entry in the leaf proxy list.
+		uint32_t					Count						= 0;	// Holds the number of proxies referenced by a leaf. This is zero for branches.
+		uint32_t					Layers						= 0;	// Holds the union of the collision layers of the proxies below this node, so subtrees that no mask can match are skipped whole.
+
+		inline	bool				IsLeaf						()																const		{ return Count > 0; }
+	};
+
+	// The coarse collision detection system. Primitives are registered once, and each update refits the hierarchy around the ones that moved. It is only rebuilt when primitives are inserted or removed, or when asked to.
+	// The tree is stored in flat arrays rather than as linked nodes, so walking it touches contiguous memory and it can be rebuilt without allocating once the arrays have grown to their working size.
+	class BroadPhase {
+	public:
+		static constexpr uint32_t	MaxLeafSize					= 4;	// Holds the maximum number of proxies stored in a single leaf of the tree.
+
+		::std::vector<CollisionProxy>	Proxies					= {};	// Holds the registered primitives. Indices into this array are stable until the proxy is removed.
+		::std::vector<BVHNode>			Nodes					= {};	// Holds the tree. The first node is the root.
+		::std::vector<uint32_t>			Leaves					= {};	// Holds the proxy indices referenced by the leaves, ordered so each leaf references a contiguous range.
+		::std::vector<uint32_t>			FreeProxies				= {};	// Holds the indices of the proxy slots released by Remove, for reuse.
+		::std::vector<BodyPair>			Exclusions				= {};	// Holds the pairs of bodies that never collide, sorted so they can be searched by bisection.
+		BroadPhaseStats					Stats					= {};	// Holds the counters of the last call to GetPotentialContacts.
+		bool							NeedsRebuild			= true;	// Set when proxies are inserted or removed, so the next update rebuilds the tree instead of refitting it.
+
+		uint32_t					Insert						(CollisionSphere	* sphere);	// Registers the given sphere and returns the index of its proxy. The primitive must outlive its registration.
+		uint32_t					Insert						(CollisionBox		* box);		// Registers the given box and returns the index of its proxy. The primitive must outlive its registration.
+		void						Remove						(uint32_t proxy);				// Releases the given proxy. Its index may be reused by a later insertion.
+		// Recalculates the bounds of the primitives that moved since the last update and refits the tree around them. This must be called after the primitives have had their internals calculated for the frame, and before any query.
+		// The tree is only rebuilt after proxies are inserted or removed. Refitting keeps the tree valid but not tight, so Rebuild should be called now and then if many primitives travel far from where they were when the tree was built.
+		void						Update						();
+		inline	void				Rebuild						()																			{ NeedsRebuild = true; Update(); }
+
+		void						ExcludePair					(const RigidBody * one, const RigidBody * two);	// Stops the primitives of the given bodies from being reported as potential contacts with each other.
+		void						IncludePair					(const RigidBody * one, const RigidBody * two);	// Undoes a previous call to ExcludePair.
+		bool						IsExcluded					(const RigidBody * one, const RigidBody * two)					const;
+
+		// Checks the potential contacts between all the registered primitives, writing them to the given array (up to the given limit). Returns the number of potential contacts it found. Each pair is reported once.
+		// Pairs are rejected here, before any fine grained test, if their collision layers and masks don't match or if their bodies are in the exclusion set. The rejections are counted in Stats.
+		uint32_t					GetPotentialContacts		(PotentialContact* contacts, uint32_t limit);
+		// Writes the indices of the proxies whose bounds overlap the given box (up to the given limit). Returns the number of proxies found.
+		uint32_t					Query						(const BoundingBox &volume, uint32_t* proxies, uint32_t limit)	const;
+
+	protected:
+		uint32_t					InsertProxy					(CollisionPrimitive * primitive, SHAPE_TYPE type);
+		void						Build						(uint32_t node, uint32_t begin, uint32_t end);
+		void						Refit						();
+	};
 } // namespace cyclone
 
-#endif // CYCLONE_COLLISION_FINE_H
+#endif // CYCLONE_COLLISION_COARSE_H
@@ -557,3 +557,95 @@ uint32_t CollisionDetector::boxAndHalfSpace(
 	data->AddContacts(contactsUsed);
 	return contactsUsed;
 }
+
+static inline	uint32_t				sphereBlockLength						(uint32_t first, uint32_t count)											{ return (count - first < CollisionDetector::SphereBlockSize) ? count - first : CollisionDetector::SphereBlockSize; }
+
+uint32_t								IntersectionTests::SpheresAndSpheres	(const SphereBatch &spheres, const uint32_t *first, const uint32_t *second, uint32_t pairCount, uint32_t *intersecting)	{
+	uint32_t									count									= 0;
+	double										squaredSize	[CollisionDetector::SphereBlockSize];
+	double										reach		[CollisionDetector::SphereBlockSize];
+	for (uint32_t iBlock = 0; iBlock < pairCount; iBlock += CollisionDetector::SphereBlockSize) {
+		const uint32_t								blockLength								= sphereBlockLength(iBlock, pairCount);
+		for (uint32_t iPair = 0; iPair < blockLength; ++iPair) {
+			const uint32_t								one										= first	[iBlock + iPair];
+			const uint32_t								two										= second[iBlock + iPair];
+			const double								x										= spheres.CentreX[one] - spheres.CentreX[two];
+			const double								y										= spheres.CentreY[one] - spheres.CentreY[two];
+			const double								z										= spheres.CentreZ[one] - spheres.CentreZ[two];
+			squaredSize[iPair]						= x * x + y * y + z * z;
+			reach[iPair]							= spheres.Radius[one] + spheres.Radius[two];
+		}
+		for (uint32_t iPair = 0; iPair < blockLength; ++iPair)
+			if (squaredSize[iPair] < reach[iPair] * reach[iPair])
+				intersecting[count++]					= iBlock + iPair;
+	}
+	return count;
+}
+
+uint32_t								CollisionDetector::spheresAndSpheres	(const SphereBatch &spheres, const uint32_t *first, const uint32_t *second, uint32_t pairCount, CollisionData *data)			{
+	const uint32_t								start									= data->ContactCount;
+	double										midlineX	[SphereBlockSize];
+	double										midlineY	[SphereBlockSize];
+	double										midlineZ	[SphereBlockSize];
+	double										squaredSize	[SphereBlockSize];
+	double										reach		[SphereBlockSize];
+	for (uint32_t iBlock = 0; iBlock < pairCount; iBlock += SphereBlockSize) {
+		const uint32_t								blockLength								= sphereBlockLength(iBlock, pairCount);
+		for (uint32_t iPair = 0; iPair < blockLength; ++iPair) {	// Find the vector between each pair of spheres.
+			const uint32_t								one										= first	[iBlock + iPair];
+			const uint32_t								two										= second[iBlock + iPair];
+			midlineX	[iPair]						= spheres.CentreX[one] - spheres.CentreX[two];
+			midlineY	[iPair]						= spheres.CentreY[one] - spheres.CentreY[two];
+			midlineZ	[iPair]						= spheres.CentreZ[one] - spheres.CentreZ[two];
+			squaredSize	[iPair]						= midlineX[iPair] * midlineX[iPair] + midlineY[iPair] * midlineY[iPair] + midlineZ[iPair] * midlineZ[iPair];
+			reach		[iPair]						= spheres.Radius[one] + spheres.Radius[two];
+		}
+		for (uint32_t iPair = 0; iPair < blockLength; ++iPair) {
+			if (squaredSize[iPair] <= 0 || squaredSize[iPair] >= reach[iPair] * reach[iPair])
+				continue;
+			if (data->ContactsLeft <= 0)	// Make sure we have contacts
+				return data->ContactCount - start;
+
+			const uint32_t								one										= first	[iBlock + iPair];
+			const uint32_t								two										= second[iBlock + iPair];
+			const double								size									= real_sqrt(squaredSize[iPair]);
+			const Vector3								midline									= {midlineX[iPair], midlineY[iPair], midlineZ[iPair]};
+			Contact										* contact								= data->Contacts;
+			contact->ContactNormal					= midline * (1.0 / size);
+			contact->ContactPoint					= Vector3{spheres.CentreX[one], spheres.CentreY[one], spheres.CentreZ[one]} + midline * 0.5;
+			contact->Penetration					= reach[iPair] - size;
+			contact->setBodyData(spheres.Body[one], spheres.Body[two], data->Friction, data->Restitution);
+			data->AddContacts(1);
+		}
+	}
+	return data->ContactCount - start;
+}
+
+uint32_t								CollisionDetector::spheresAndHalfSpace	(const SphereBatch &spheres, const CollisionPlane &plane, CollisionData *data)												{
+	const uint32_t								start									= data->ContactCount;
+	double										distance	[SphereBlockSize];
+	for (uint32_t iBlock = 0; iBlock < spheres.Count; iBlock += SphereBlockSize) {
+		const uint32_t								blockLength								= sphereBlockLength(iBlock, spheres.Count);
+		const double								* x										= spheres.CentreX	+ iBlock;
+		const double								* y										= spheres.CentreY	+ iBlock;
+		const double								* z										= spheres.CentreZ	+ iBlock;
+		const double								* radius								= spheres.Radius	+ iBlock;
+		for (uint32_t iSphere = 0; iSphere < blockLength; ++iSphere)	// Find the distance of each sphere from the plane.
+			distance[iSphere]						= plane.Direction.x * x[iSphere] + plane.Direction.y * y[iSphere] + plane.Direction.z * z[iSphere] - radius[iSphere] - plane.Offset;
+		for (uint32_t iSphere = 0; iSphere < blockLength; ++iSphere) {
+			if (distance[iSphere] >= 0)
+				continue;
+			if (data->ContactsLeft <= 0)	// Make sure we have contacts
+				return data->ContactCount - start;
+
+			// Create the contact - it has a normal in the plane direction.
+			Contact										* contact								= data->Contacts;
+			contact->ContactNormal					= plane.Direction;
+			contact->Penetration					= -distance[iSphere];
+			contact->ContactPoint					= Vector3{x[iSphere], y[iSphere], z[iSphere]} - plane.Direction * (distance[iSphere] + radius[iSphere]);
+			contact->setBodyData(spheres.Body[iBlock + iSphere], NULL, data->Friction, data->Restitution);
+			data->AddContacts(1);
+		}
+	}
+	return data->ContactCount - start;
+}
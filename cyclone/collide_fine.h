@@ -15,8 +15,24 @@ namespace cyclone {
 		RigidBody					* Body								= 0;		// The rigid body that is represented by this primitive.
 		Matrix4						Offset								= {};		// The offset of this primitive from the given rigid body.
 		Matrix4						Transform;	// The resultant transform of the primitive. This is calculated by combining the offset of the primitive with the transform of the rigid body.
+		uint32_t					CollisionLayer						= 1;			// Holds the layer bits this primitive belongs to.
+		uint32_t					CollisionMask						= 0xFFFFFFFFU;	// Holds the layer bits this primitive collides with. Two primitives are only tested for contact if each one's layer is in the other's mask.
+		uint32_t					TransformGeneration					= 0;			// Holds a counter incremented each time the transform is recalculated. The broad phase compares it with the value it last saw to find the primitives that moved.
+		const RigidBody				* CachedBody						= 0;			// Holds the body the transform was last calculated from, or NULL if the transform has to be recalculated.
+		uint32_t					CachedBodyGeneration				= 0;			// Holds the transform generation of the body when the transform was last calculated.
 
-		void						CalculateInternals					()									noexcept	{ Transform = Body->TransformMatrix * Offset;	}	// Calculates the internals for the primitive.
+		// Calculates the internals for the primitive. The transform is only recalculated when the body has moved since the last call, and primitives without an offset copy the body transform instead of multiplying by the identity.
+		// Returns true if the transform changed. InvalidateTransform must be called after changing the Offset or the size of the primitive.
+		bool						CalculateInternals					()									noexcept	{
+			if (CachedBody == Body && CachedBodyGeneration == Body->TransformGeneration)
+				return false;
+			Transform					= Offset.isIdentity() ? Body->TransformMatrix : Body->TransformMatrix * Offset;
+			CachedBody					= Body;
+			CachedBodyGeneration		= Body->TransformGeneration;
+			++TransformGeneration;
+			return true;
+		}
+		inline void					InvalidateTransform					()									noexcept	{ CachedBody = 0;								}	// Forces the next call to CalculateInternals to recalculate the transform.
 		inline Vector3				GetAxis								(uint32_t index)			const	noexcept	{ return Transform.getAxisVector(index);		} // This is a convenience function to allow access to the axis vectors in the transform for this primitive.
 	};
 	
@@ -36,10 +52,23 @@ namespace cyclone {
 		Vector3						HalfSize;	// Holds the half-sizes of the box along each of its local axes.
 	};
 
+	// Holds a set of spheres in structure of arrays form for the batched sphere routines. A sphere only needs its centre and radius, and keeping each coordinate in its own contiguous array lets the batched routines process several spheres per instruction.
+	// The batch doesn't own the arrays: it points into storage kept by the caller, indexed by sphere slot.
+	struct SphereBatch {
+		const double				* CentreX							= 0;
+		const double				* CentreY							= 0;
+		const double				* CentreZ							= 0;
+		const double				* Radius							= 0;
+		RigidBody * const			* Body								= 0;
+		uint32_t					Count								= 0;
+	};
+
 	// A wrapper class that holds fast intersection tests. These can be used to drive the coarse collision detection system or as an early out in the full collision tests below.
 	struct IntersectionTests {
 		static bool					SphereAndHalfSpace					(const CollisionSphere	& sphere	, const CollisionPlane	& plane	);
 		static bool					SphereAndSphere						(const CollisionSphere	& one		, const CollisionSphere	& two	);
+		// Tests the candidate pairs given as two lists of sphere slots, writing the positions in the lists of the pairs that intersect. Returns the number of intersecting pairs.
+		static uint32_t				SpheresAndSpheres					(const SphereBatch		& spheres	, const uint32_t * first, const uint32_t * second, uint32_t pairCount, uint32_t * intersecting);
 		static bool					BoxAndBox							(const CollisionBox		& one		, const CollisionBox	& two	);
 		static bool					BoxAndHalfSpace						(const CollisionBox		& box		, const CollisionPlane	& plane	);
 	};
@@ -81,6 +110,12 @@ namespace cyclone {
 		static uint32_t				boxAndBox							(const CollisionBox		& one		, const CollisionBox	& two	, CollisionData *data);
 		static uint32_t				boxAndPoint							(const CollisionBox		& box		, const Vector3			& point	, CollisionData *data);
 		static uint32_t				boxAndSphere						(const CollisionBox		& box		, const CollisionSphere & sphere, CollisionData *data);
+
+		// Batched versions of sphereAndSphere and sphereAndHalfSpace. The distances are calculated for a block of spheres at a time in loops without branches, and the contacts are written afterwards for the ones that touch.
+		// The contacts are the same as the ones the single sphere routines would write, in the same order.
+		static constexpr uint32_t	SphereBlockSize						= 64;
+		static uint32_t				spheresAndSpheres					(const SphereBatch		& spheres	, const uint32_t * first, const uint32_t * second, uint32_t pairCount, CollisionData *data);	// Tests the candidate pairs given as two lists of sphere slots.
+		static uint32_t				spheresAndHalfSpace					(const SphereBatch		& spheres	, const CollisionPlane	& plane	, CollisionData *data);	// Tests all the spheres of the batch against the plane.
 	};
 } // namespace cyclone
 
@@ -0,0 +1,444 @@
+// Implementation file for the scene queries.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_query.h"
+
+using namespace cyclone;
+
+static constexpr	double				CAST_TOLERANCE							= 0.0001;	// Shape casts stop advancing once the shapes are closer than this distance.
+static constexpr	uint32_t			CAST_MAX_STEPS							= 32;		// Shape casts that haven't converged after this many steps are considered to graze past the primitive.
+
+// Returns the reciprocal of each component. Zero components get the largest representable value instead, so the slab tests never produce (0 * infinity).
+static inline		Vector3				safeInverse								(const Vector3 &direction)																								{
+	return
+		{ (real_abs(direction.x) > real_epsilon) ? 1.0 / direction.x : REAL_MAX
+		, (real_abs(direction.y) > real_epsilon) ? 1.0 / direction.y : REAL_MAX
+		, (real_abs(direction.z) > real_epsilon) ? 1.0 / direction.z : REAL_MAX
+		};
+}
+
+static inline		double				minReal									(double a, double b)																									{ return (a < b) ? a : b; }
+static inline		double				maxReal									(double a, double b)																									{ return (a > b) ? a : b; }
+
+// Clips the segment against the box slabs. Returns true if the segment enters the box before the given fraction, writing the fraction at which it does so.
+static inline		bool				segmentAndBounds						(const BoundingBox &bounds, const Vector3 &origin, const Vector3 &inverse, double maxFraction, double *entry)			{
+	const double								t0x										= (bounds.Min.x - origin.x) * inverse.x;
+	const double								t1x										= (bounds.Max.x - origin.x) * inverse.x;
+	const double								t0y										= (bounds.Min.y - origin.y) * inverse.y;
+	const double								t1y										= (bounds.Max.y - origin.y) * inverse.y;
+	const double								t0z										= (bounds.Min.z - origin.z) * inverse.z;
+	const double								t1z										= (bounds.Max.z - origin.z) * inverse.z;
+	const double								tmin									= maxReal(maxReal(minReal(t0x, t1x), minReal(t0y, t1y)), maxReal(minReal(t0z, t1z), 0.0));
+	const double								tmax									= minReal(minReal(maxReal(t0x, t1x), maxReal(t0y, t1y)), minReal(maxReal(t0z, t1z), maxFraction));
+	*entry									= tmin;
+	return tmin <= tmax;
+}
+
+static inline		Vector3				clampToBox								(const Vector3 &point, const Vector3 &halfSize)																			{
+	return
+		{ (point.x > halfSize.x) ? halfSize.x : (point.x < -halfSize.x) ? -halfSize.x : point.x
+		, (point.y > halfSize.y) ? halfSize.y : (point.y < -halfSize.y) ? -halfSize.y : point.y
+		, (point.z > halfSize.z) ? halfSize.z : (point.z < -halfSize.z) ? -halfSize.z : point.z
+		};
+}
+
+static inline		double				projectOntoAxis							(const CollisionBox &box, const Vector3 &axis)																			{
+	return
+		box.HalfSize.x * real_abs(axis * box.GetAxis(0)) +
+		box.HalfSize.y * real_abs(axis * box.GetAxis(1)) +
+		box.HalfSize.z * real_abs(axis * box.GetAxis(2));
+}
+
+static				bool				rayAndSphere							(const Vector3 &origin, const Vector3 &direction, const Vector3 &centre, double radius, double maxFraction, double *fraction, Vector3 *normal)		{
+	const Vector3								offset									= origin - centre;
+	const double								c										= offset.squareMagnitude() - radius * radius;
+	if (c <= 0) {	// We start inside the sphere.
+		*fraction								= 0;
+		*normal									= direction.unit() * -1;
+		return true;
+	}
+	const double								b										= offset * direction;
+	if (b >= 0)	// Moving away from the sphere.
+		return false;
+	const double								a										= direction.squareMagnitude();
+	const double								discriminant							= b * b - a * c;
+	if (discriminant < 0)
+		return false;
+	const double								t										= (-b - real_sqrt(discriminant)) / a;
+	if (t > maxFraction)
+		return false;
+	*fraction								= t;
+	*normal									= (offset + direction * t) * (1.0 / radius);
+	return true;
+}
+
+static				bool				rayAndBox								(const Vector3 &origin, const Vector3 &direction, const CollisionBox &box, double maxFraction, double *fraction, Vector3 *normal)					{
+	// Work in box coordinates, where the box is aligned with the axes.
+	const Vector3								localOrigin								= box.Transform.transformInverse			(origin);
+	const Vector3								localDirection							= box.Transform.transformInverseDirection	(direction);
+	double										tEnter									= 0;
+	double										tExit									= maxFraction;
+	int32_t										enterAxis								= -1;
+	double										enterSign								= 0;
+	for (uint32_t axis = 0; axis < 3; ++axis) {
+		const double								o										= localOrigin		[axis];
+		const double								d										= localDirection	[axis];
+		const double								h										= box.HalfSize		[axis];
+		if (real_abs(d) <= real_epsilon) {	// Parallel to this slab: either always inside or never.
+			if (o < -h || o > h)
+				return false;
+			continue;
+		}
+		double										t0										= (-h - o) / d;
+		double										t1										= ( h - o) / d;
+		double										sign									= -1;	// Entering through the negative face.
+		if (t0 > t1) {
+			const double								temp									= t0;
+			t0										= t1;
+			t1										= temp;
+			sign									= 1;
+		}
+		if (t0 > tEnter) {
+			tEnter									= t0;
+			enterAxis								= axis;
+			enterSign								= sign;
+		}
+		if (t1 < tExit)
+			tExit									= t1;
+		if (tEnter > tExit)
+			return false;
+	}
+	*fraction								= tEnter;
+	*normal									= (enterAxis < 0) ? direction.unit() * -1 : box.GetAxis(enterAxis) * enterSign;
+	return true;
+}
+
+// Sweeps a sphere against a box by conservative advancement: the sphere can always be moved by its distance to the box without touching it, and the box is convex so the distance only grows once the sphere moves away.
+static				bool				sphereCastAndBox						(const Vector3 &origin, const Vector3 &direction, double radius, const CollisionBox &box, double maxFraction, double *fraction, Vector3 *normal, Vector3 *point)	{
+	const Vector3								localOrigin								= box.Transform.transformInverse			(origin);
+	const Vector3								localDirection							= box.Transform.transformInverseDirection	(direction);
+	const double								length									= localDirection.magnitude();
+	double										t										= 0;
+	for (uint32_t iStep = 0; iStep < CAST_MAX_STEPS; ++iStep) {
+		const Vector3								centre									= localOrigin + localDirection * t;
+		const Vector3								closest									= clampToBox(centre, box.HalfSize);
+		const Vector3								separation								= centre - closest;
+		const double								distance								= separation.magnitude();
+		if (distance <= radius + CAST_TOLERANCE) {
+			*fraction								= t;
+			*normal									= (distance > 0) ? box.Transform.transformDirection(separation * (1.0 / distance)) : direction.unit() * -1;
+			*point									= box.Transform.transform(closest);
+			return true;
+		}
+		if (length <= 0 || separation * localDirection >= 0)	// Moving away from the box.
+			return false;
+		t										+= (distance - radius) / length;
+		if (t > maxFraction)
+			return false;
+	}
+	return false;
+}
+
+// Sweeps a box against a box with the separating axis test: along each axis the projections overlap during an interval of the sweep, and the boxes touch when all the intervals overlap.
+// The contact normal is the axis whose interval starts last.
+static				bool				boxCastAndBox							(const CollisionBox &moving, const Vector3 &direction, const CollisionBox &box, double maxFraction, double *fraction, Vector3 *normal)				{
+	const Vector3								toCentre								= box.GetAxis(3) - moving.GetAxis(3);
+	const Vector3								axes	[15]							=
+		{ moving.GetAxis(0), moving.GetAxis(1), moving.GetAxis(2)
+		, box.GetAxis(0), box.GetAxis(1), box.GetAxis(2)
+		, moving.GetAxis(0) % box.GetAxis(0), moving.GetAxis(0) % box.GetAxis(1), moving.GetAxis(0) % box.GetAxis(2)
+		, moving.GetAxis(1) % box.GetAxis(0), moving.GetAxis(1) % box.GetAxis(1), moving.GetAxis(1) % box.GetAxis(2)
+		, moving.GetAxis(2) % box.GetAxis(0), moving.GetAxis(2) % box.GetAxis(1), moving.GetAxis(2) % box.GetAxis(2)
+		};
+	double										tEnter									= 0;
+	double										tExit									= maxFraction;
+	Vector3										enterAxis								= direction.unit() * -1;
+	for (uint32_t iAxis = 0; iAxis < 15; ++iAxis) {
+		Vector3										axis									= axes[iAxis];
+		if (axis.squareMagnitude() < 0.0001)	// Don't check almost parallel edge axes.
+			continue;
+		axis.normalise();
+
+		const double								reach									= projectOntoAxis(moving, axis) + projectOntoAxis(box, axis);
+		const double								distance								= toCentre	* axis;
+		const double								speed									= direction	* axis;
+		if (real_abs(speed) <= real_epsilon) {
+			if (real_abs(distance) > reach)
+				return false;
+			continue;
+		}
+		double										t0										= (distance - reach) / speed;
+		double										t1										= (distance + reach) / speed;
+		if (t0 > t1) {
+			const double								temp									= t0;
+			t0										= t1;
+			t1										= temp;
+		}
+		if (t0 > tEnter) {
+			tEnter									= t0;
+			enterAxis								= (distance - speed * t0 > 0) ? axis * -1 : axis;	// Point from the box back towards the moving box.
+		}
+		if (t1 < tExit)
+			tExit									= t1;
+		if (tEnter > tExit)
+			return false;
+	}
+	*fraction								= tEnter;
+	*normal									= enterAxis;
+	return true;
+}
+
+static				bool				rayAndProxy								(const CollisionProxy &proxy, const Vector3 &origin, const Vector3 &direction, double maxFraction, double *fraction, Vector3 *normal)				{
+	switch (proxy.Type) {
+	case SHAPE_TYPE_SPHERE	: { const CollisionSphere & sphere = *(const CollisionSphere*)proxy.Primitive; return rayAndSphere(origin, direction, sphere.GetAxis(3), sphere.Radius, maxFraction, fraction, normal); }
+	case SHAPE_TYPE_BOX		: return rayAndBox(origin, direction, *(const CollisionBox*)proxy.Primitive, maxFraction, fraction, normal);
+	default:
+		return false;
+	}
+}
+
+// Walks the tree front to back along the cast. Nodes are tested against the cast segment after growing them by the extent of the cast shape, and only the leaves the swept volume goes through have their primitives tested.
+// The primitive test is given the closest fraction found so far so it can reject farther hits, and it updates the hit when it finds a closer one.
+template<typename _tPrimitiveTest>
+static				bool				castThroughTree							(const BroadPhase &broadPhase, const Vector3 &origin, const Vector3 &direction, const Vector3 &extent, _tPrimitiveTest &primitiveTest, QueryHit *hit)	{
+	*hit									= {};
+	if (0 == broadPhase.Nodes.size())
+		return false;
+
+	const Vector3								inverse									= safeInverse(direction);
+	uint32_t									stack	[64];
+	uint32_t									stackSize								= 0;
+	stack[stackSize++]						= 0;
+	while (stackSize) {
+		const BVHNode								& node									= broadPhase.Nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			for (uint32_t iLeaf = node.First; iLeaf < node.First + node.Count; ++iLeaf) {
+				const uint32_t								proxy									= broadPhase.Leaves[iLeaf];
+				BoundingBox									bounds									= broadPhase.Proxies[proxy].Bounds;
+				double										entry;
+				bounds.Expand(extent);
+				if (segmentAndBounds(bounds, origin, inverse, hit->Fraction, &entry))
+					primitiveTest(proxy, hit);
+			}
+			continue;
+		}
+		// Visit the nearest child first, so the closest hit is found early and prunes the rest of the walk.
+		double										entry	[2];
+		bool										enters	[2];
+		for (uint32_t iChild = 0; iChild < 2; ++iChild) {
+			BoundingBox									bounds									= broadPhase.Nodes[node.First + iChild].Bounds;
+			bounds.Expand(extent);
+			enters[iChild]							= segmentAndBounds(bounds, origin, inverse, hit->Fraction, &entry[iChild]);
+		}
+		const uint32_t								nearChild								= (entry[1] < entry[0]) ? 1 : 0;
+		if (enters[1 - nearChild])	stack[stackSize++] = node.First + 1 - nearChild;
+		if (enters[nearChild])		stack[stackSize++] = node.First + nearChild;
+	}
+	return hit->Proxy != QueryHit::NoProxy;
+}
+
+bool									SceneQuery::RayCast						(const BroadPhase &broadPhase, const Ray &ray, QueryHit *hit)																{
+	auto										primitiveTest							= [&broadPhase, &ray](uint32_t proxy, QueryHit *best) {
+		double										fraction;
+		Vector3										normal;
+		const CollisionProxy						& registration							= broadPhase.Proxies[proxy];
+		if (!rayAndProxy(registration, ray.Origin, ray.Direction, best->Fraction, &fraction, &normal))
+			return;
+		best->Body								= registration.Primitive->Body;
+		best->Proxy								= proxy;
+		best->Fraction							= fraction;
+		best->Normal							= normal;
+		best->Point								= ray.Origin + ray.Direction * fraction;
+	};
+	return castThroughTree(broadPhase, ray.Origin, ray.Direction, {}, primitiveTest, hit);
+}
+
+bool									SceneQuery::SphereCast					(const BroadPhase &broadPhase, const Ray &ray, double radius, QueryHit *hit)												{
+	auto										primitiveTest							= [&broadPhase, &ray, radius](uint32_t proxy, QueryHit *best) {
+		double										fraction;
+		Vector3										normal;
+		Vector3										point;
+		const CollisionProxy						& registration							= broadPhase.Proxies[proxy];
+		if (SHAPE_TYPE_SPHERE == registration.Type) {	// Casting a sphere against a sphere is casting a ray against a sphere with the summed radius.
+			const CollisionSphere						& sphere								= *(const CollisionSphere*)registration.Primitive;
+			const Vector3								centre									= sphere.GetAxis(3);
+			if (!rayAndSphere(ray.Origin, ray.Direction, centre, sphere.Radius + radius, best->Fraction, &fraction, &normal))
+				return;
+			point									= centre + normal * sphere.Radius;
+		}
+		else if (SHAPE_TYPE_BOX == registration.Type) {
+			if (!sphereCastAndBox(ray.Origin, ray.Direction, radius, *(const CollisionBox*)registration.Primitive, best->Fraction, &fraction, &normal, &point))
+				return;
+		}
+		else
+			return;
+		best->Body								= registration.Primitive->Body;
+		best->Proxy								= proxy;
+		best->Fraction							= fraction;
+		best->Normal							= normal;
+		best->Point								= point;
+	};
+	return castThroughTree(broadPhase, ray.Origin, ray.Direction, {radius, radius, radius}, primitiveTest, hit);
+}
+
+bool									SceneQuery::BoxCast						(const BroadPhase &broadPhase, const CollisionBox &box, const Vector3 &direction, QueryHit *hit)							{
+	auto										primitiveTest							= [&broadPhase, &box, &direction](uint32_t proxy, QueryHit *best) {
+		double										fraction;
+		Vector3										normal;
+		Vector3										point;
+		const CollisionProxy						& registration							= broadPhase.Proxies[proxy];
+		if (SHAPE_TYPE_SPHERE == registration.Type) {	// A box moving towards a sphere is a sphere moving away from the box the other way.
+			const CollisionSphere						& sphere								= *(const CollisionSphere*)registration.Primitive;
+			const Vector3								centre									= sphere.GetAxis(3);
+			if (!sphereCastAndBox(centre, direction * -1, sphere.Radius, box, best->Fraction, &fraction, &normal, &point))
+				return;
+			normal									*= -1;
+			point									= centre + normal * sphere.Radius;
+		}
+		else if (SHAPE_TYPE_BOX == registration.Type) {
+			const CollisionBox							& other									= *(const CollisionBox*)registration.Primitive;
+			if (!boxCastAndBox(box, direction, other, best->Fraction, &fraction, &normal))
+				return;
+			const Vector3								centre									= box.GetAxis(3) + direction * fraction;
+			point									= other.Transform.transform(clampToBox(other.Transform.transformInverse(centre), other.HalfSize));
+		}
+		else
+			return;
+		best->Body								= registration.Primitive->Body;
+		best->Proxy								= proxy;
+		best->Fraction							= fraction;
+		best->Normal							= normal;
+		best->Point								= point;
+	};
+	const BoundingBox							bounds									= BoundingBox::FromBox(box);
+	return castThroughTree(broadPhase, box.GetAxis(3), direction, bounds.GetHalfSize(), primitiveTest, hit);
+}
+
+uint32_t								SceneQuery::OverlapSphere				(const BroadPhase &broadPhase, const Vector3 &centre, double radius, uint32_t *proxies, uint32_t limit)						{
+	const uint32_t								candidates								= broadPhase.Query({centre - Vector3{radius, radius, radius}, centre + Vector3{radius, radius, radius}}, proxies, limit);
+	uint32_t									count									= 0;
+	for (uint32_t iCandidate = 0; iCandidate < candidates; ++iCandidate) {	// Keep the candidates that pass the fine test, compacting them in place.
+		const CollisionProxy						& registration							= broadPhase.Proxies[proxies[iCandidate]];
+		bool										overlaps								= false;
+		if (SHAPE_TYPE_SPHERE == registration.Type) {
+			const CollisionSphere						& sphere								= *(const CollisionSphere*)registration.Primitive;
+			overlaps								= (sphere.GetAxis(3) - centre).squareMagnitude() <= (sphere.Radius + radius) * (sphere.Radius + radius);
+		}
+		else if (SHAPE_TYPE_BOX == registration.Type) {
+			const CollisionBox							& box									= *(const CollisionBox*)registration.Primitive;
+			const Vector3								relCentre								= box.Transform.transformInverse(centre);
+			overlaps								= (clampToBox(relCentre, box.HalfSize) - relCentre).squareMagnitude() <= radius * radius;
+		}
+		if (overlaps)
+			proxies[count++]						= proxies[iCandidate];
+	}
+	return count;
+}
+
+uint32_t								SceneQuery::OverlapBox					(const BroadPhase &broadPhase, const CollisionBox &box, uint32_t *proxies, uint32_t limit)									{
+	const uint32_t								candidates								= broadPhase.Query(BoundingBox::FromBox(box), proxies, limit);
+	uint32_t									count									= 0;
+	for (uint32_t iCandidate = 0; iCandidate < candidates; ++iCandidate) {
+		const CollisionProxy						& registration							= broadPhase.Proxies[proxies[iCandidate]];
+		bool										overlaps								= false;
+		if (SHAPE_TYPE_SPHERE == registration.Type) {
+			const CollisionSphere						& sphere								= *(const CollisionSphere*)registration.Primitive;
+			const Vector3								relCentre								= box.Transform.transformInverse(sphere.GetAxis(3));
+			overlaps								= (clampToBox(relCentre, box.HalfSize) - relCentre).squareMagnitude() <= sphere.Radius * sphere.Radius;
+		}
+		else if (SHAPE_TYPE_BOX == registration.Type)
+			overlaps								= IntersectionTests::BoxAndBox(box, *(const CollisionBox*)registration.Primitive);
+		if (overlaps)
+			proxies[count++]						= proxies[iCandidate];
+	}
+	return count;
+}
+
+// The rays of a packet are stored as structures of arrays and every lane runs the same slab arithmetic, so the node test compiles to packed instructions.
+// Lanes that are not in use or that have already hit something closer than the node are masked out by their fraction instead of by branching.
+uint32_t								SceneQuery::RayCastBatch				(const BroadPhase &broadPhase, const Ray *rays, uint32_t count, QueryHit *hits)												{
+	uint32_t									hitCount								= 0;
+	for (uint32_t iFirst = 0; iFirst < count; iFirst += PacketSize) {
+		const uint32_t								lanes									= (count - iFirst < PacketSize) ? count - iFirst : PacketSize;
+		double										originX		[PacketSize]				= {};
+		double										originY		[PacketSize]				= {};
+		double										originZ		[PacketSize]				= {};
+		double										inverseX	[PacketSize]				= {};
+		double										inverseY	[PacketSize]				= {};
+		double										inverseZ	[PacketSize]				= {};
+		double										best		[PacketSize]				= {};
+		for (uint32_t iLane = 0; iLane < PacketSize; ++iLane) {
+			if (iLane >= lanes) {
+				best[iLane]								= -1;	// Unused lanes can never enter a node.
+				continue;
+			}
+			const Ray									& ray									= rays[iFirst + iLane];
+			const Vector3								inverse									= safeInverse(ray.Direction);
+			originX		[iLane]						= ray.Origin.x;
+			originY		[iLane]						= ray.Origin.y;
+			originZ		[iLane]						= ray.Origin.z;
+			inverseX	[iLane]						= inverse.x;
+			inverseY	[iLane]						= inverse.y;
+			inverseZ	[iLane]						= inverse.z;
+			best		[iLane]						= 1;
+			hits[iFirst + iLane]					= {};
+		}
+		if (0 == broadPhase.Nodes.size())
+			continue;
+
+		uint32_t									stack	[64];
+		uint32_t									stackSize								= 0;
+		stack[stackSize++]						= 0;
+		while (stackSize) {
+			const BVHNode								& node									= broadPhase.Nodes[stack[--stackSize]];
+			const BoundingBox							& bounds								= node.Bounds;
+			bool										enters		[PacketSize];
+			for (uint32_t iLane = 0; iLane < PacketSize; ++iLane) {
+				const double								t0x										= (bounds.Min.x - originX[iLane]) * inverseX[iLane];
+				const double								t1x										= (bounds.Max.x - originX[iLane]) * inverseX[iLane];
+				const double								t0y										= (bounds.Min.y - originY[iLane]) * inverseY[iLane];
+				const double								t1y										= (bounds.Max.y - originY[iLane]) * inverseY[iLane];
+				const double								t0z										= (bounds.Min.z - originZ[iLane]) * inverseZ[iLane];
+				const double								t1z										= (bounds.Max.z - originZ[iLane]) * inverseZ[iLane];
+				const double								tmin									= maxReal(maxReal(minReal(t0x, t1x), minReal(t0y, t1y)), maxReal(minReal(t0z, t1z), 0.0));
+				const double								tmax									= minReal(minReal(maxReal(t0x, t1x), maxReal(t0y, t1y)), minReal(maxReal(t0z, t1z), best[iLane]));
+				enters[iLane]							= tmin <= tmax;
+			}
+			bool										any										= false;
+			for (uint32_t iLane = 0; iLane < PacketSize; ++iLane)
+				any										|= enters[iLane];
+			if (!any)
+				continue;
+
+			if (!node.IsLeaf()) {
+				stack[stackSize++]						= node.First;
+				stack[stackSize++]						= node.First + 1;
+				continue;
+			}
+			for (uint32_t iLeaf = node.First; iLeaf < node.First + node.Count; ++iLeaf) {
+				const uint32_t								proxy									= broadPhase.Leaves[iLeaf];
+				const CollisionProxy						& registration							= broadPhase.Proxies[proxy];
+				for (uint32_t iLane = 0; iLane < lanes; ++iLane) {
+					if (!enters[iLane])
+						continue;
+					const Ray									& ray									= rays[iFirst + iLane];
+					double										fraction;
+					Vector3										normal;
+					if (!rayAndProxy(registration, ray.Origin, ray.Direction, best[iLane], &fraction, &normal))
+						continue;
+					QueryHit									& hit									= hits[iFirst + iLane];
+					hit.Body								= registration.Primitive->Body;
+					hit.Proxy								= proxy;
+					hit.Fraction							= fraction;
+					hit.Normal								= normal;
+					hit.Point								= ray.Origin + ray.Direction * fraction;
+					best[iLane]								= fraction;
+				}
+			}
+		}
+		for (uint32_t iLane = 0; iLane < lanes; ++iLane)
+			if (hits[iFirst + iLane].Proxy != QueryHit::NoProxy)
+				++hitCount;
+	}
+	return hitCount;
+}
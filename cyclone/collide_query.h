@@ -0,0 +1,46 @@
+// This file contains the scene queries: ray casts, shape casts and overlap tests run against the primitives registered with the broad phase.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_coarse.h"
+
+#ifndef CYCLONE_COLLISION_QUERY_H
+#define CYCLONE_COLLISION_QUERY_H
+
+namespace cyclone {
+	// Holds a segment to cast through the scene. The segment starts at the origin and ends at Origin + Direction, so the fraction reported by a hit is the proportion of the direction travelled before the hit.
+	struct Ray {
+		Vector3						Origin								= {};
+		Vector3						Direction							= {};
+	};
+
+	// Holds the closest hit found by a cast.
+	struct QueryHit {
+		static constexpr uint32_t	NoProxy								= 0xFFFFFFFFU;
+
+		RigidBody					* Body								= 0;		// The rigid body of the primitive that was hit, or NULL if nothing was hit.
+		uint32_t					Proxy								= NoProxy;	// The broad phase proxy of the primitive that was hit.
+		Vector3						Point								= {};		// The point of contact in world coordinates, on the surface of the primitive that was hit.
+		Vector3						Normal								= {};		// The surface normal of the primitive that was hit at the point of contact, pointing back towards the cast shape.
+		double						Fraction							= 1;		// The proportion of the cast direction travelled before the hit. Shapes that overlap at the start of the cast report zero.
+	};
+
+	// A wrapper class that holds the scene queries. These use the broad phase tree to cull the primitives, so the broad phase must have been updated since the primitives last moved.
+	// Casts return true if something was hit and fill the given hit structure with the closest hit. Overlap queries write the indices of the overlapping proxies and return how many they found.
+	struct SceneQuery {
+		static constexpr uint32_t	PacketSize							= 4;		// Holds the number of rays traversed together by the batched ray cast.
+
+		static bool					RayCast								(const BroadPhase & broadPhase, const Ray & ray, QueryHit * hit);
+		static bool					SphereCast							(const BroadPhase & broadPhase, const Ray & ray, double radius, QueryHit * hit);	// Sweeps a sphere centred on the ray origin along the ray.
+		// Sweeps a box along the ray. The box is given with its transform already calculated; its centre is the origin of the sweep and its orientation is kept through the sweep.
+		static bool					BoxCast								(const BroadPhase & broadPhase, const CollisionBox & box, const Vector3 & direction, QueryHit * hit);
+
+		static uint32_t				OverlapSphere						(const BroadPhase & broadPhase, const Vector3 & centre, double radius	, uint32_t * proxies, uint32_t limit);
+		static uint32_t				OverlapBox							(const BroadPhase & broadPhase, const CollisionBox & box				, uint32_t * proxies, uint32_t limit);	// The box is given with its transform already calculated.
+
+		// Casts a set of rays, writing one hit for each of them. The rays are traversed in packets of PacketSize, so each node of the tree is fetched and tested once for the whole packet.
+		// The batch is most efficient when neighbouring rays are coherent (similar origins and directions), as is usual for line of sight checks issued from the same agent or volley. Returns the number of rays that hit something.
+		static uint32_t				RayCastBatch						(const BroadPhase & broadPhase, const Ray * rays, uint32_t count, QueryHit * hits);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_COLLISION_QUERY_H
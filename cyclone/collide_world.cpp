@@ -0,0 +1,177 @@
+// Implementation file for the collision world.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_world.h"
+#include "profile.h"
+
+using namespace cyclone;
+
+// The pair table calls the detector with the lower shape type first, which is the reverse of the detector's own order for this pair.
+static				uint32_t			sphereAndBox							(const CollisionSphere &sphere, const CollisionBox &box, CollisionData *data)									{ return CollisionDetector::boxAndSphere(box, sphere, data); }
+
+template<typename _tFirst, typename _tSecond, uint32_t (*_fnDetector)(const _tFirst &, const _tSecond &, CollisionData *)>
+static				uint32_t			pairBatch								(const CollisionWorld &world, const PotentialContact *pairs, uint32_t count, CollisionData *data)				{
+	const CollisionProxy						* proxies								= world.Coarse.Proxies.data();
+	const uint32_t								start									= data->ContactCount;
+	for (uint32_t iPair = 0; iPair < count && data->HasMoreContacts(); ++iPair) {
+		const PotentialContact						& pair									= pairs[iPair];
+		_fnDetector(*(const _tFirst*)proxies[pair.Proxy[0]].Primitive, *(const _tSecond*)proxies[pair.Proxy[1]].Primitive, data);
+	}
+	return data->ContactCount - start;
+}
+
+template<typename _tPrimitive, SHAPE_TYPE _shapeType, uint32_t (*_fnDetector)(const _tPrimitive &, const CollisionPlane &, CollisionData *)>
+static				uint32_t			halfSpaceBatch							(const CollisionWorld &world, const CollisionPlane &plane, CollisionData *data)									{
+	const CollisionProxy						* proxies								= world.Coarse.Proxies.data();
+	const ::std::vector<uint32_t>				& proxyIndices							= world.ProxiesByType[_shapeType];
+	const uint32_t								start									= data->ContactCount;
+	for (uint32_t iProxy = 0; iProxy < proxyIndices.size() && data->HasMoreContacts(); ++iProxy)
+		_fnDetector(*(const _tPrimitive*)proxies[proxyIndices[iProxy]].Primitive, plane, data);
+	return data->ContactCount - start;
+}
+
+// Spheres go through the batched routines, which work on the sphere slots rather than on the primitives. The pairs are translated to slots a block at a time.
+static				uint32_t			sphereAndSphereBatch					(const CollisionWorld &world, const PotentialContact *pairs, uint32_t count, CollisionData *data)				{
+	const SphereBatch							spheres									= world.GetSpheres();
+	const uint32_t								start									= data->ContactCount;
+	uint32_t									first	[CollisionDetector::SphereBlockSize];
+	uint32_t									second	[CollisionDetector::SphereBlockSize];
+	for (uint32_t iBlock = 0; iBlock < count && data->HasMoreContacts(); iBlock += CollisionDetector::SphereBlockSize) {
+		const uint32_t								blockLength								= (count - iBlock < CollisionDetector::SphereBlockSize) ? count - iBlock : CollisionDetector::SphereBlockSize;
+		for (uint32_t iPair = 0; iPair < blockLength; ++iPair) {
+			first	[iPair]							= world.SphereSlots[pairs[iBlock + iPair].Proxy[0]];
+			second	[iPair]							= world.SphereSlots[pairs[iBlock + iPair].Proxy[1]];
+		}
+		CollisionDetector::spheresAndSpheres(spheres, first, second, blockLength, data);
+	}
+	return data->ContactCount - start;
+}
+
+static				uint32_t			sphereAndHalfSpaceBatch					(const CollisionWorld &world, const CollisionPlane &plane, CollisionData *data)									{ return CollisionDetector::spheresAndHalfSpace(world.GetSpheres(), plane, data); }
+
+const PairBatchFunction					CollisionWorld::PairBatches				[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT]	=
+	{ {sphereAndSphereBatch	, pairBatch<CollisionSphere, CollisionBox, sphereAndBox>				}
+	, {0					, pairBatch<CollisionBox, CollisionBox, CollisionDetector::boxAndBox>	}
+	};
+
+const HalfSpaceBatchFunction			CollisionWorld::HalfSpaceBatches		[SHAPE_TYPE_COUNT]						=
+	{ sphereAndHalfSpaceBatch
+	, halfSpaceBatch<CollisionBox, SHAPE_TYPE_BOX, CollisionDetector::boxAndHalfSpace>
+	};
+
+void									CollisionWorld::Update					()																												{
+	for (uint32_t iType = 0; iType < SHAPE_TYPE_COUNT; ++iType)
+		ProxiesByType[iType].clear();
+	for (uint32_t iProxy = 0; iProxy < Coarse.Proxies.size(); ++iProxy) {
+		const CollisionProxy						& proxy									= Coarse.Proxies[iProxy];
+		if (0 == proxy.Primitive)
+			continue;
+		proxy.Primitive->CalculateInternals();
+		ProxiesByType[proxy.Type].push_back(iProxy);
+	}
+	{
+		CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_BROAD_PHASE);
+		Coarse.Update();
+	}
+
+	const ::std::vector<uint32_t>				& spheres								= ProxiesByType[SHAPE_TYPE_SPHERE];
+	SphereCentreX	.resize(spheres.size());
+	SphereCentreY	.resize(spheres.size());
+	SphereCentreZ	.resize(spheres.size());
+	SphereRadius	.resize(spheres.size());
+	SphereBody		.resize(spheres.size());
+	SphereSlots		.resize(Coarse.Proxies.size());
+	for (uint32_t iSlot = 0; iSlot < spheres.size(); ++iSlot) {
+		const CollisionSphere						& sphere								= *(const CollisionSphere*)Coarse.Proxies[spheres[iSlot]].Primitive;
+		SphereCentreX	[iSlot]					= sphere.Transform.data[3];
+		SphereCentreY	[iSlot]					= sphere.Transform.data[7];
+		SphereCentreZ	[iSlot]					= sphere.Transform.data[11];
+		SphereRadius	[iSlot]					= sphere.Radius;
+		SphereBody		[iSlot]					= sphere.Body;
+		SphereSlots		[spheres[iSlot]]		= iSlot;
+	}
+}
+
+#ifdef CYCLONE_PROFILE
+// Counts the half-space tests left from the given plane and shape type on, one per primitive of each type for each plane.
+static	uint32_t						countHalfSpaceTests						(const ::std::vector<uint32_t> (&proxiesByType)[SHAPE_TYPE_COUNT], uint32_t planeCount, uint32_t plane, uint32_t type)	{
+	uint32_t									count									= 0;
+	for (uint32_t iType = 0; iType < SHAPE_TYPE_COUNT; ++iType)
+		count									+= (uint32_t)proxiesByType[iType].size() * (planeCount - plane - 1) + ((iType >= type) ? (uint32_t)proxiesByType[iType].size() : 0);
+	return count;
+}
+#endif
+
+uint32_t								CollisionWorld::GenerateContacts		(CollisionData *data)																							{
+	const uint32_t								start									= data->ContactCount;
+	const CollisionProxy						* proxies								= Coarse.Proxies.data();
+	{
+		CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_NARROW_PHASE);
+		for (uint32_t iPlane = 0; iPlane < HalfSpaces.size(); ++iPlane)
+			for (uint32_t iType = 0; iType < SHAPE_TYPE_COUNT; ++iType) {
+				if (!data->HasMoreContacts()) {	// The pairs of primitives haven't been looked for yet, so only the half-space tests left are counted as skipped.
+					CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_PAIRS_SKIPPED		, countHalfSpaceTests(ProxiesByType, (uint32_t)HalfSpaces.size(), iPlane, iType));
+					CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_CONTACTS_GENERATED, data->ContactCount - start);
+					return data->ContactCount - start;
+				}
+				CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_PAIRS_TESTED, ProxiesByType[iType].size());
+				CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_NARROW_PHASE_BATCH);
+				HalfSpaceBatches[iType](*this, HalfSpaces[iPlane], data);
+			}
+	}
+
+	// Collect the potential contacts, growing the array until the broad phase finds fewer pairs than it can hold.
+	if (Pairs.size() < 64)
+		Pairs.resize(64);
+	uint32_t									pairCount								= 0;
+	{
+		CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_BROAD_PHASE);
+		while (true) {
+			pairCount								= Coarse.GetPotentialContacts(Pairs.data(), (uint32_t)Pairs.size());
+			if (pairCount < Pairs.size())
+				break;
+			Pairs.resize(Pairs.size() * 2);
+		}
+	}
+
+	// Sort the pairs by shape pair with a counting sort. There are only a handful of keys, so this is two linear passes.
+	uint32_t									counts	[SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT]	= {};
+	for (uint32_t iPair = 0; iPair < pairCount; ++iPair) {
+		PotentialContact							& pair									= Pairs[iPair];
+		if (proxies[pair.Proxy[0]].Type > proxies[pair.Proxy[1]].Type) {
+			const uint32_t								other									= pair.Proxy[0];
+			pair.Proxy[0]							= pair.Proxy[1];
+			pair.Proxy[1]							= other;
+		}
+		++counts[proxies[pair.Proxy[0]].Type * SHAPE_TYPE_COUNT + proxies[pair.Proxy[1]].Type];
+	}
+	PairRuns[0]								= 0;
+	for (uint32_t iKey = 0; iKey < SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT; ++iKey) {
+		PairRuns[iKey + 1]						= PairRuns[iKey] + counts[iKey];
+		counts[iKey]							= PairRuns[iKey];	// Reuse the counts as the write cursor of each run.
+	}
+	SortedPairs.resize(pairCount);
+	for (uint32_t iPair = 0; iPair < pairCount; ++iPair) {
+		const PotentialContact						& pair									= Pairs[iPair];
+		SortedPairs[counts[proxies[pair.Proxy[0]].Type * SHAPE_TYPE_COUNT + proxies[pair.Proxy[1]].Type]++] = pair;
+	}
+
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_NARROW_PHASE);
+	for (uint32_t iFirst = 0; iFirst < SHAPE_TYPE_COUNT; ++iFirst)
+		for (uint32_t iSecond = iFirst; iSecond < SHAPE_TYPE_COUNT; ++iSecond) {
+			const uint32_t								key										= iFirst * SHAPE_TYPE_COUNT + iSecond;
+			const uint32_t								runSize									= PairRuns[key + 1] - PairRuns[key];
+			if (0 == runSize)
+				continue;
+			if (!data->HasMoreContacts()) {	// The runs are tested in the order of their keys, so the pairs from this run on are the ones left.
+				CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_PAIRS_SKIPPED		, pairCount - PairRuns[key]);
+				CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_CONTACTS_GENERATED, data->ContactCount - start);
+				return data->ContactCount - start;
+			}
+			CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_PAIRS_TESTED, runSize);
+			CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_NARROW_PHASE_BATCH);
+			PairBatches[iFirst][iSecond](*this, &SortedPairs[PairRuns[key]], runSize, data);
+		}
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_CONTACTS_GENERATED, data->ContactCount - start);
+	return data->ContactCount - start;
+}
@@ -0,0 +1,52 @@
+// This file contains the collision world: a registry of primitives that generates all their contacts in one call, dispatching the fine grained tests by shape type instead of through hand-written loops or virtual calls.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_coarse.h"
+
+#ifndef CYCLONE_COLLISION_WORLD_H
+#define CYCLONE_COLLISION_WORLD_H
+
+namespace cyclone {
+	class CollisionWorld;
+
+	// Runs the fine grained test for a batch of potential contacts that all have the same pair of shape types, writing the contacts into the given data. Returns the number of contacts written.
+	typedef uint32_t			(*PairBatchFunction)				(const CollisionWorld & world, const PotentialContact * pairs, uint32_t count, CollisionData * data);
+	// Runs the fine grained test between a plane and all the registered proxies of a shape type. Returns the number of contacts written.
+	typedef uint32_t			(*HalfSpaceBatchFunction)			(const CollisionWorld & world, const CollisionPlane & plane, CollisionData * data);
+
+	// Holds the primitives of a simulation and the immovable half-spaces they rest on, and generates the contacts between all of them.
+	// Potential contacts come from the broad phase. They are sorted by the pair of shape types involved and each homogeneous run is sent through a table of batch functions into the CollisionDetector routines, so the same routine runs for the whole run.
+	class CollisionWorld {
+	public:
+		// Holds the batch functions indexed by the shape types of the pair. Pairs are always ordered so the first type is not greater than the second, so only the upper half of the table is used.
+		static const PairBatchFunction			PairBatches			[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT];
+		static const HalfSpaceBatchFunction		HalfSpaceBatches	[SHAPE_TYPE_COUNT];	// Holds the batch functions for testing the half-spaces, indexed by shape type.
+
+		BroadPhase								Coarse						= {};	// Holds the registered primitives.
+		::std::vector<CollisionPlane>			HalfSpaces					= {};	// Holds the planes representing the immovable world geometry. The normals point out of the solid side.
+		::std::vector<uint32_t>					ProxiesByType	[SHAPE_TYPE_COUNT]	= {};	// Holds the live proxies grouped by shape type, for the half-space batches.
+		::std::vector<PotentialContact>			Pairs						= {};	// Holds the potential contacts found by the broad phase on the last call to GenerateContacts.
+		::std::vector<PotentialContact>			SortedPairs					= {};	// Holds the potential contacts sorted by shape pair.
+		uint32_t								PairRuns		[SHAPE_TYPE_COUNT * SHAPE_TYPE_COUNT + 1]	= {};	// Holds the offset of each run of shape pairs within SortedPairs. Each run ends where the next one starts.
+
+		// Hold the registered spheres in structure of arrays form for the batched sphere routines, refreshed on each update. The slot of a sphere is its position in ProxiesByType[SHAPE_TYPE_SPHERE].
+		::std::vector<double>					SphereCentreX				= {};
+		::std::vector<double>					SphereCentreY				= {};
+		::std::vector<double>					SphereCentreZ				= {};
+		::std::vector<double>					SphereRadius				= {};
+		::std::vector<RigidBody*>				SphereBody					= {};
+		::std::vector<uint32_t>					SphereSlots					= {};	// Holds the sphere slot of each proxy, indexed by proxy.
+
+		inline	uint32_t						Register					(CollisionSphere	* sphere)			{ return Coarse.Insert(sphere);	}	// Registers the given primitive and returns the index of its proxy. The primitive must outlive its registration.
+		inline	uint32_t						Register					(CollisionBox		* box)				{ return Coarse.Insert(box);	}	// Registers the given primitive and returns the index of its proxy. The primitive must outlive its registration.
+		inline	void							Unregister					(uint32_t proxy)						{ Coarse.Remove(proxy);			}
+		inline	SphereBatch						GetSpheres					()								const	{ return {SphereCentreX.data(), SphereCentreY.data(), SphereCentreZ.data(), SphereRadius.data(), SphereBody.data(), (uint32_t)SphereBody.size()}; }
+
+		// Calculates the internals of all the registered primitives and updates the broad phase. Primitives whose bodies didn't move keep their cached transforms.
+		void									Update						();
+		// Generates the contacts between the registered primitives, and between them and the half-spaces, appending them to the given data. Update must have been called since the primitives last moved. Returns the number of contacts generated.
+		uint32_t								GenerateContacts			(CollisionData * data);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_COLLISION_WORLD_H
@@ -1,9 +1,12 @@
 // Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "contacts.h"
+#include "profile.h"
 
 #include <memory.h>
 #include <assert.h>
+#include <algorithm>
+#include <vector>
 
 using namespace cyclone;
 
@@ -356,6 +359,42 @@ void Contact::applyPositionChange	( Vector3 linearChange	[2]
 		}
 }
 
+#ifdef CYCLONE_PROFILE
+// Counts the groups of bodies connected by the given contacts, with a union-find over the bodies. Contacts with the scenery don't connect anything.
+static	uint32_t						countIslands					(const Contact *contacts, uint32_t numContacts)					{
+	thread_local ::std::vector<RigidBody*>		bodies;
+	thread_local ::std::vector<uint32_t>		parents;
+	bodies.clear();
+	for (uint32_t iContact = 0; iContact < numContacts; ++iContact)
+		for (uint32_t iBody = 0; iBody < 2; ++iBody)
+			if (contacts[iContact].Body[iBody])
+				bodies.push_back(contacts[iContact].Body[iBody]);
+	::std::sort(bodies.begin(), bodies.end());
+	bodies.erase(::std::unique(bodies.begin(), bodies.end()), bodies.end());
+	parents.resize(bodies.size());
+	for (uint32_t iBody = 0; iBody < parents.size(); ++iBody)
+		parents[iBody]							= iBody;
+
+	const auto									findRoot						= [](uint32_t node) {
+		while (parents[node] != node)
+			node									= parents[node] = parents[parents[node]];
+		return node;
+	};
+	uint32_t									islands							= (uint32_t)bodies.size();
+	for (uint32_t iContact = 0; iContact < numContacts; ++iContact) {
+		if (0 == contacts[iContact].Body[0] || 0 == contacts[iContact].Body[1])
+			continue;
+		const uint32_t								first							= findRoot((uint32_t)(::std::lower_bound(bodies.begin(), bodies.end(), contacts[iContact].Body[0]) - bodies.begin()));
+		const uint32_t								second							= findRoot((uint32_t)(::std::lower_bound(bodies.begin(), bodies.end(), contacts[iContact].Body[1]) - bodies.begin()));
+		if (first != second) {
+			parents[second]							= first;
+			--islands;
+		}
+	}
+	return islands;
+}
+#endif // CYCLONE_PROFILE
+
 // Contact resolver implementation
 void ContactResolver::resolveContacts(Contact *contacts,
                                       uint32_t numContacts,
@@ -369,9 +408,13 @@ void ContactResolver::resolveContacts(Contact *contacts,
     prepareContacts(contacts, numContacts, duration);	// Prepare the contacts for processing
     adjustPositions(contacts, numContacts, duration);	// Resolve the interpenetration problems with the contacts.
     adjustVelocities(contacts, numContacts, duration);	// Resolve the velocity problems with the contacts.
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_ISLANDS				, countIslands(contacts, numContacts));
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_POSITION_ITERATIONS	, PositionIterationsUsed);
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_VELOCITY_ITERATIONS	, VelocityIterationsUsed);
 }
 
 void ContactResolver::prepareContacts(Contact* contacts, uint32_t numContacts, double duration) {
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_RESOLVE_PREPARE);
 	// Generate contact velocity and axis information.
 	Contact* lastContact = contacts + numContacts;
 	for (Contact* contact=contacts; contact < lastContact; ++contact)
@@ -379,6 +422,7 @@ void ContactResolver::prepareContacts(Contact* contacts, uint32_t numContacts, d
 }
 
 void ContactResolver::adjustVelocities(Contact *c, uint32_t numContacts, double duration) {
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_RESOLVE_VELOCITIES);
 	Vector3							velocityChange[2], rotationChange[2];
 	Vector3							deltaVel;
 
@@ -413,6 +457,7 @@ void ContactResolver::adjustVelocities(Contact *c, uint32_t numContacts, double
 }
 
 void ContactResolver::adjustPositions(Contact *c, uint32_t numContacts, double duration) {
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_RESOLVE_POSITIONS);
 	uint32_t	i, index;
 	Vector3		linearChange[2], angularChange[2];
 	double		max;
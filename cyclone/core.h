@@ -261,6 +261,16 @@ namespace cyclone {
 
 		void			setInverse					(const Matrix4 &matrixToInvert);		// Sets the matrix to be the inverse of the given matrix. matrixToInvert: The matrix to invert and use to set this.
 		void			invert						()																															{ setInverse(*this);		}
+		bool			isIdentity					()																													const	{	// Checks if this matrix is exactly the identity, as created by the default constructor.
+			return data[0] == 1 && data[5] == 1 && data[10] == 1
+				&& data[1] == 0 && data[2] == 0 && data[3] == 0 && data[4] == 0 && data[6] == 0 && data[7] == 0 && data[8] == 0 && data[9] == 0 && data[11] == 0;
+		}
+		bool			operator==					(const Matrix4 &o)																									const	{
+			for (uint32_t i = 0; i < 12; ++i)
+				if (data[i] != o.data[i])
+					return false;
+			return true;
+		}
 		Vector3			transform					(const Vector3 &vector)																								const	{ return (*this) * vector;	}	// Transform the given vector by this matrix.
 		double			getDeterminant				()																													const;
 		Matrix4			inverse						()																													const	{ // Returns a new matrix containing the inverse of this matrix. 
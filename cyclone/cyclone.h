@@ -3,10 +3,23 @@
 #include "precision.h"
 #include "core.h"
 #include "random.h"
+#include "damping.h"
 #include "particle.h"
 #include "body.h"
 #include "pcontacts.h"
+#include "parallel.h"
+#include "profile.h"
+#include "psystem.h"
+#include "psoft.h"
+#include "pemitter.h"
 #include "pworld.h"
 #include "collide_fine.h"
+#include "collide_coarse.h"
+#include "collide_query.h"
+#include "collide_world.h"
+#include "scene.h"
+#include "trajectory.h"
 #include "contacts.h"
+#include "vgrid.h"
 #include "fgen.h"
+#include "ffield.h"
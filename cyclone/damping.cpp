@@ -0,0 +1,25 @@
+// Implementation file for the damping table.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "damping.h"
+
+using namespace cyclone;
+
+uint16_t								DampingTable::AddClass					(double damping)																						{
+	for (uint32_t iClass = 0; iClass < Dampings.size(); ++iClass)
+		if (Dampings[iClass] == damping)
+			return (uint16_t)iClass;
+	if (Dampings.size() >= MaxClasses)
+		return InvalidClass;
+	Dampings.push_back(damping);
+	Factors	.push_back(real_pow(damping, Duration));	// Keep the factors in step with the classes, so updating never allocates.
+	return (uint16_t)(Dampings.size() - 1);
+}
+
+void									DampingTable::Update					(double duration)																						{
+	if (duration == Duration)
+		return;
+	Duration								= duration;
+	for (uint32_t iClass = 0; iClass < Dampings.size(); ++iClass)
+		Factors[iClass]							= real_pow(Dampings[iClass], duration);
+}
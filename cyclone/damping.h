@@ -0,0 +1,32 @@
+// This file contains the damping table: the damping values shared by the objects of a simulation, with their damping factors for the duration being integrated.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "core.h"
+
+#include <vector>
+
+#ifndef CYCLONE_DAMPING_H
+#define CYCLONE_DAMPING_H
+
+namespace cyclone {
+	// Holds a small number of damping classes, each with a damping value: the proportion of velocity kept after one second. Objects refer to a class instead of holding their own value.
+	// Integrating scales velocities by the damping raised to the power of the duration. The table calculates that factor once per class, and only again when the duration changes, so with a fixed step the powers are calculated once.
+	struct DampingTable {
+		typedef	::std::vector<double>		TReals;
+
+		TReals								Dampings				= {};	// Holds the damping value of each class.
+		TReals								Factors					= {};	// Holds the damping factor of each class for Duration.
+		double								Duration				= 0;	// Holds the duration the factors are for. The factors of a zero duration are all one.
+
+		inline	uint32_t					Size					()									const	{ return (uint32_t)Dampings.size(); }
+		inline	double						GetFactor				(uint16_t dampingClass)				const	{ return Factors[dampingClass]; }
+		static constexpr	uint32_t		MaxClasses				= 1024;	// Holds the largest number of classes, which keeps the indices within 16 bits and the search of AddClass short.
+		static constexpr	uint16_t		InvalidClass			= 0xFFFF;	// Returned by AddClass when the table is full. Objects without a class need the factor of their own damping calculated.
+
+		// Returns the class with the given damping value, adding it if there isn't one yet. Returns InvalidClass if the value is new and the table already holds MaxClasses.
+		uint16_t							AddClass				(double damping);
+		void								Update					(double duration);	// Calculates the factors for the given duration, unless they are already for it.
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_DAMPING_H
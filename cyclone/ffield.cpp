@@ -0,0 +1,138 @@
+// Implementation file for the force fields.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "ffield.h"
+
+#include <algorithm>
+
+using namespace cyclone;
+
+static inline	bool					contains								(const BoundingBox &bounds, const Vector3 &point)														{ return point >= bounds.Min && point <= bounds.Max; }
+
+// Returns the force the field applies to an object with the given state. The switch is on a value that doesn't change during a pass, so the branch it takes is always predicted.
+static inline	Vector3					fieldForce								(const ForceField &field, const Vector3 &position, const Vector3 &velocity, double inverseMass)			{
+	switch (field.Type) {
+	case FORCE_FIELD_TYPE_GRAVITY		: return field.Direction * (1.0 / inverseMass);
+	case FORCE_FIELD_TYPE_ATTRACTOR		: {
+		const Vector3								offset									= field.Origin - position;
+		const double								distanceSquared							= offset.squareMagnitude();
+		if (0 == distanceSquared)
+			return {};
+		const double								radiusSquared							= field.Radius * field.Radius;
+		const double								falloff									= radiusSquared / ((distanceSquared > radiusSquared) ? distanceSquared : radiusSquared);
+		return offset * (field.Strength * falloff / (real_sqrt(distanceSquared) * inverseMass));
+	}
+	case FORCE_FIELD_TYPE_VORTEX		: {
+		Vector3										radial									= position - field.Origin;
+		radial									-= field.Direction * (radial * field.Direction);
+		const double								distanceSquared							= radial.squareMagnitude();
+		const double								radiusSquared							= field.Radius * field.Radius;
+		const double								scale									= (distanceSquared < radiusSquared) ? 1.0 / field.Radius : field.Radius / distanceSquared;	// The tangent below has the length of the distance to the axis.
+		return (field.Direction % radial) * (field.Strength * scale / inverseMass);
+	}
+	case FORCE_FIELD_TYPE_WIND			:
+	case FORCE_FIELD_TYPE_DRAG			: {
+		const Vector3								relative								= ((FORCE_FIELD_TYPE_WIND == field.Type) ? field.Direction : Vector3{}) - velocity;
+		return relative * (field.Strength + field.QuadraticDrag * relative.magnitude());
+	}
+	default								: return {};
+	}
+}
+
+// Collects the bodies whose primitives overlap the given box, once each, skipping the immovable ones and optionally the sleeping ones.
+static			void					gatherBodies							(const BroadPhase &coarse, const BoundingBox &bounds, bool sleeping, ::std::vector<uint32_t> &proxies, ::std::vector<RigidBody*> &bodies)	{
+	bodies.clear();
+	proxies.resize(coarse.Proxies.size());
+	if (0 == proxies.size())
+		return;
+	const uint32_t								proxyCount								= coarse.Query(bounds, proxies.data(), (uint32_t)proxies.size());
+	for (uint32_t iProxy = 0; iProxy < proxyCount; ++iProxy) {
+		const CollisionPrimitive					* primitive								= coarse.Proxies[proxies[iProxy]].Primitive;
+		RigidBody									* body									= primitive ? primitive->Body : 0;
+		if (body && (sleeping || body->IsAwake) && body->Mass.InverseMass > 0)
+			bodies.push_back(body);
+	}
+	::std::sort(bodies.begin(), bodies.end());	// A body with several primitives is found once for each of them.
+	bodies.erase(::std::unique(bodies.begin(), bodies.end()), bodies.end());
+}
+
+void									ForceFields::Apply						(const BroadPhase &coarse)																				{
+	for (uint32_t iField = 0; iField < Fields.size(); ++iField) {
+		const ForceField							& field									= Fields[iField];
+		gatherBodies(coarse, field.Bounds, false, ProxyScratch, BodyScratch);
+		for (uint32_t iBody = 0; iBody < BodyScratch.size(); ++iBody) {
+			RigidBody									& body									= *BodyScratch[iBody];
+			if (contains(field.Bounds, body.Pivot.Position))
+				body.AccumulatedForce					+= fieldForce(field, body.Pivot.Position, body.Force.Velocity, body.Mass.InverseMass);
+		}
+	}
+}
+
+void									ForceFields::Apply						(Particle * const *particles, uint32_t count)															{
+	for (uint32_t iField = 0; iField < Fields.size(); ++iField) {
+		const ForceField							& field									= Fields[iField];
+		for (uint32_t iParticle = 0; iParticle < count; ++iParticle) {
+			Particle									& particle								= *particles[iParticle];
+			if (particle.InverseMass > 0 && contains(field.Bounds, particle.Position))
+				particle.AccumulatedForce				+= fieldForce(field, particle.Position, particle.Velocity, particle.InverseMass);
+		}
+	}
+}
+
+void									ForceFields::Apply						(ParticleSystem &particles, uint32_t begin, uint32_t end)												{
+	for (uint32_t iField = 0; iField < Fields.size(); ++iField) {
+		const ForceField							& field									= Fields[iField];
+		for (uint32_t iParticle = begin; iParticle < end; ++iParticle) {
+			const double								inverseMass								= particles.InverseMass[iParticle];
+			const Vector3								position								= particles.GetPosition(iParticle);
+			if (inverseMass > 0 && contains(field.Bounds, position))
+				particles.AddForce(iParticle, fieldForce(field, position, particles.GetVelocity(iParticle), inverseMass));
+		}
+	}
+}
+
+void									ExplosionSet::Advance					(double duration)																						{
+	uint32_t									kept									= 0;
+	for (uint32_t iExplosion = 0; iExplosion < Explosions.size(); ++iExplosion) {
+		Explosions[iExplosion].Advance(duration);
+		if (!Explosions[iExplosion].IsFinished())
+			Explosions[kept++]						= Explosions[iExplosion];
+	}
+	Explosions.resize(kept);
+}
+
+static inline	BoundingBox				explosionBounds							(const Explosion &explosion)																			{
+	const double								reach									= explosion.GetReach();
+	return {explosion.Detonation - Vector3{reach, reach, reach}, explosion.Detonation + Vector3{reach, reach, reach}};
+}
+
+void									ExplosionSet::Apply						(const BroadPhase &coarse)																				{
+	for (uint32_t iExplosion = 0; iExplosion < Explosions.size(); ++iExplosion) {
+		Explosion									& explosion								= Explosions[iExplosion];
+		gatherBodies(coarse, explosionBounds(explosion), true, ProxyScratch, BodyScratch);
+		for (uint32_t iBody = 0; iBody < BodyScratch.size(); ++iBody)
+			explosion.Explosion::UpdateForce(BodyScratch[iBody], 0);
+	}
+}
+
+void									ExplosionSet::Apply						(Particle * const *particles, uint32_t count)															{
+	for (uint32_t iExplosion = 0; iExplosion < Explosions.size(); ++iExplosion) {
+		Explosion									& explosion								= Explosions[iExplosion];
+		const BoundingBox							bounds									= explosionBounds(explosion);
+		for (uint32_t iParticle = 0; iParticle < count; ++iParticle)
+			if (contains(bounds, particles[iParticle]->Position))
+				explosion.Explosion::UpdateForce(particles[iParticle], 0);
+	}
+}
+
+void									ExplosionSet::Apply						(ParticleSystem &particles, uint32_t begin, uint32_t end)												{
+	for (uint32_t iExplosion = 0; iExplosion < Explosions.size(); ++iExplosion) {
+		const Explosion								& explosion								= Explosions[iExplosion];
+		const BoundingBox							bounds									= explosionBounds(explosion);
+		for (uint32_t iParticle = begin; iParticle < end; ++iParticle) {
+			const Vector3								position								= particles.GetPosition(iParticle);
+			if (particles.InverseMass[iParticle] > 0 && contains(bounds, position))
+				particles.AddForce(iParticle, explosion.GetForce(position, particles.GetVelocity(iParticle)));
+		}
+	}
+}
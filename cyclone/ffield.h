@@ -0,0 +1,68 @@
+// This file contains the force fields and the explosion sets: forces that apply to every object inside a region of the world, without registering the objects one by one.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_coarse.h"
+#include "fgen.h"
+#include "psystem.h"
+#include "particle.h"
+
+#include <vector>
+
+#ifndef CYCLONE_FFIELD_H
+#define CYCLONE_FFIELD_H
+
+namespace cyclone {
+	// Identifies the kind of force a field applies.
+	enum FORCE_FIELD_TYPE : uint8_t
+		{	FORCE_FIELD_TYPE_GRAVITY		= 0	// Accelerates objects by Direction.
+		,	FORCE_FIELD_TYPE_ATTRACTOR			// Accelerates objects towards Origin. The acceleration is Strength at Radius and falls with the square of the distance. It is capped at Strength inside Radius. A negative Strength repels.
+		,	FORCE_FIELD_TYPE_VORTEX				// Accelerates objects around the axis through Origin along Direction, which must be a unit vector. The acceleration is Strength at Radius, grows linearly up to it and falls with the distance beyond it.
+		,	FORCE_FIELD_TYPE_WIND				// Pushes objects towards the velocity Direction, with a drag of Strength times the relative speed plus QuadraticDrag times its square.
+		,	FORCE_FIELD_TYPE_DRAG				// Slows objects down with a drag of Strength times the speed plus QuadraticDrag times its square. This is a wind of zero velocity.
+		,	FORCE_FIELD_TYPE_COUNT
+		};
+
+	// Holds a force that applies to every object inside the given bounds. Acceleration fields scale with the mass of each object, drag fields don't. Objects with infinite mass are never affected.
+	struct ForceField {
+		FORCE_FIELD_TYPE			Type						= FORCE_FIELD_TYPE_GRAVITY;
+		BoundingBox					Bounds						= {{-REAL_MAX, -REAL_MAX, -REAL_MAX}, {REAL_MAX, REAL_MAX, REAL_MAX}};	// Objects whose centre lies outside this box are not affected. The default box covers the whole world.
+		Vector3						Origin						= {};	// Holds the centre of an attractor or a point on the axis of a vortex.
+		Vector3						Direction					= {};	// Holds the acceleration of gravity, the velocity of a wind or the axis of a vortex.
+		double						Strength					= 0;
+		double						Radius						= 1;	// Holds the radius of the core of an attractor or a vortex. It must be greater than zero.
+		double						QuadraticDrag				= 0;
+	};
+
+	// Holds a set of force fields and applies them to bodies and particles. Each field makes a single pass over the objects inside its bounds.
+	// Bodies are found through the broad phase, so a small field only visits the bodies near it however many there are in the world. Sleeping bodies are skipped, and fields don't wake them.
+	struct ForceFields {
+		::std::vector<ForceField>	Fields						= {};
+		::std::vector<uint32_t>		ProxyScratch				= {};	// Holds the results of the broad phase queries.
+		::std::vector<RigidBody*>	BodyScratch					= {};	// Holds the bodies found by a query, once each.
+
+		inline	uint32_t			Add							(const ForceField &field)													{ Fields.push_back(field); return (uint32_t)Fields.size() - 1;	}	// Adds a field and returns its index.
+
+		// Applies the fields to the awake bodies of the primitives registered with the given broad phase. The broad phase must have been updated for the frame.
+		void						Apply						(const BroadPhase &coarse);
+		void						Apply						(Particle * const *particles, uint32_t count);	// Applies the fields to the given particles.
+		void						Apply						(ParticleSystem &particles, uint32_t begin, uint32_t end);	// Applies the fields to the particles of the given system in the range [begin, end).
+	};
+
+	// Holds any number of explosions at once and applies them. Each explosion only visits the bodies the broad phase finds within its current reach, so an explosion costs in proportion to the objects near its wavefront rather than to the objects in the world.
+	// Unlike force fields, explosions wake the sleeping bodies they hit.
+	struct ExplosionSet {
+		::std::vector<Explosion>	Explosions					= {};
+		::std::vector<uint32_t>		ProxyScratch				= {};	// Holds the results of the broad phase queries.
+		::std::vector<RigidBody*>	BodyScratch					= {};	// Holds the bodies found by a query, once each.
+
+		inline	void				Add							(const Explosion &explosion)												{ Explosions.push_back(explosion); }	// Detonates the given explosion.
+		void						Advance						(double duration);	// Moves all the explosions forward in time by the given duration, and removes the ones that have finished.
+
+		// Applies the explosions to the bodies of the primitives registered with the given broad phase. The broad phase must have been updated for the frame.
+		void						Apply						(const BroadPhase &coarse);
+		void						Apply						(Particle * const *particles, uint32_t count);				// Applies the explosions to the given particles.
+		void						Apply						(ParticleSystem &particles, uint32_t begin, uint32_t end);	// Applies the explosions to the particles of the given system in the range [begin, end).
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_FFIELD_H
@@ -2,8 +2,71 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "fgen.h"
 
+#include <algorithm>
+
 using namespace cyclone;
 
+// Drops the bodies added to the batch more than once since it was last checked, keeping the order of the others. Sorting a copy finds them without a search per Add, and the batch is only rewritten if there are any.
+static	void					removeDuplicates				(ForceBatch &batch)																												{
+	if (batch.IsChecked)
+		return;
+	batch.IsChecked					= true;
+	::std::vector<RigidBody*>			sorted							= batch.Bodies;
+	::std::sort(sorted.begin(), sorted.end(), ::std::less<RigidBody*>());
+	if (::std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end())
+		return;
+	sorted.erase(::std::unique(sorted.begin(), sorted.end()), sorted.end());
+	::std::vector<bool>					kept							(sorted.size(), false);
+	uint32_t							keptCount						= 0;
+	for (uint32_t iBody = 0; iBody < batch.Bodies.size(); ++iBody) {
+		RigidBody							* body							= batch.Bodies[iBody];
+		const size_t						index							= ::std::lower_bound(sorted.begin(), sorted.end(), body, ::std::less<RigidBody*>()) - sorted.begin();
+		if (!kept[index]) {	// The first occurrence keeps its place, and the ones after it are dropped.
+			kept[index]						= true;
+			batch.Bodies[keptCount++]		= body;
+		}
+	}
+	batch.Bodies.resize(keptCount);
+}
+
+void							ForceRegistry::UpdateForces		(double duration)																												{
+	for (TRegistry::iterator i = Registrations.begin(); i != Registrations.end(); i++)
+		i->ForceGenerator->UpdateForce(i->Body, duration);
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch) {
+		removeDuplicates(Batches[iBatch]);
+		Batches[iBatch].ForceGenerator->ApplyBatch(Batches[iBatch].Bodies.data(), (uint32_t)Batches[iBatch].Bodies.size(), duration);
+	}
+}
+
+void							ForceRegistry::Add				(RigidBody *body, ForceGenerator *generator)																					{
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch)
+		if (Batches[iBatch].ForceGenerator == generator) {
+			Batches[iBatch].Bodies.push_back(body);
+			Batches[iBatch].IsChecked		= false;
+			return;
+		}
+	Batches.push_back({generator, {body}, true});
+}
+
+bool							ForceRegistry::Remove			(RigidBody *body, ForceGenerator *generator)																					{
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch) {
+		if (Batches[iBatch].ForceGenerator != generator)
+			continue;
+		removeDuplicates(Batches[iBatch]);	// So a pair added twice is gone after a single removal, as it is registered once.
+		::std::vector<RigidBody*>			& bodies						= Batches[iBatch].Bodies;
+		for (uint32_t iBody = 0; iBody < bodies.size(); ++iBody)
+			if (bodies[iBody] == body) {
+				bodies[iBody]					= bodies.back();
+				bodies.pop_back();
+				if (bodies.empty())
+					Batches.erase(Batches.begin() + iBatch);
+				return true;
+			}
+		return false;
+	}
+	return false;
+}
+
 								Buoyancy::Buoyancy				(const Vector3 &centreOfBuoyancy, double maxDepth, double volume, double waterHeight, double liquidDensity /* = 1000.0f */)		{
 	CentreOfBuoyancy	= centreOfBuoyancy;
 	LiquidDensity		= liquidDensity;
@@ -13,23 +76,28 @@ using namespace cyclone;
 }
 
 void							Buoyancy::UpdateForce			(RigidBody *body, double duration)																								{
+	const Vector3						pointInWorld					= body->getPointInWorldSpace(CentreOfBuoyancy);
+	UpdateForceInCurrent(body, pointInWorld, Current ? Current->Sample(pointInWorld) : Vector3{});
+}
+
+void							Buoyancy::UpdateForceInCurrent	(RigidBody *body, const Vector3 &pointInWorld, const Vector3 &current)															{
 	// Calculate the submersion depth
-	Vector3								pointInWorld					= body->getPointInWorldSpace(CentreOfBuoyancy);
 	double								depth							= pointInWorld.y;
 
 	if (depth >= WaterHeight + MaxDepth)	// Check if we're out of the water
 		return;
 
 	Vector3								force							= {};
-	if (depth <= WaterHeight - MaxDepth) {	// Check if we're at maximum depth
+	double								submerged						= 1;
+	if (depth <= WaterHeight - MaxDepth)	// Check if we're at maximum depth
 		force.y							= LiquidDensity * Volume;
-		body->addForceAtBodyPoint(force, CentreOfBuoyancy);
-		return;
+	else {	// Otherwise we are partly submerged
+		force.y							= LiquidDensity * Volume * (depth - MaxDepth - WaterHeight) / 2 * MaxDepth;
+		submerged						= (WaterHeight + MaxDepth - depth) / (2 * MaxDepth);
 	}
-
-	// Otherwise we are partly submerged
-	force.y							= LiquidDensity * Volume * (depth - MaxDepth - WaterHeight) / 2 * MaxDepth;
 	body->addForceAtBodyPoint(force, CentreOfBuoyancy);
+	if (Current && CurrentDrag)	// The current drags the body along at its centre, so it doesn't make it turn.
+		body->addForce((current - body->Force.Velocity) * (CurrentDrag * submerged));
 }
 
 								Spring::Spring
@@ -63,10 +131,16 @@ void							Spring::UpdateForce				(RigidBody* body, double duration)
 	body->addForceAtPoint(force, lws);
 }
 
-void							 Aero::UpdateForceFromTensor	(RigidBody *body, double duration, const Matrix3 &tensor)																		{
+void							Aero::UpdateForceFromTensor		(RigidBody *body, double duration, const Matrix3 &tensor)																		{
+	UpdateForceFromTensor(body, tensor, WindField ? WindField->Sample(body->getPointInWorldSpace(Position)) : Vector3{});
+}
+
+void							Aero::UpdateForceFromTensor		(RigidBody *body, const Matrix3 &tensor, const Vector3 &wind)																	{
 	// Calculate total velocity (windspeed and body's velocity).
 	Vector3								velocity						= body->Force.Velocity;
-	velocity						+= *Windspeed;
+	velocity						+= wind;
+	if (Windspeed)
+		velocity						+= *Windspeed;
 
 	Vector3								bodyVel							= body->TransformMatrix.transformInverseDirection(velocity);		// Calculate the velocity in body coordinates
 
@@ -77,6 +151,21 @@ void							 Aero::UpdateForceFromTensor	(RigidBody *body, double duration, const
 	body->addForceAtBodyPoint(force, Position);		// Apply the force
 }
 
+void							Aero::ApplyBatchFromTensor		(RigidBody * const *bodies, uint32_t count, const Matrix3 &tensor)																{
+	Vector3								points	[SampleBlockSize];
+	Vector3								winds	[SampleBlockSize]		= {};
+	for (uint32_t iBlock = 0; iBlock < count; iBlock += SampleBlockSize) {
+		const uint32_t						blockLength						= (count - iBlock < SampleBlockSize) ? count - iBlock : SampleBlockSize;
+		if (WindField) {
+			for (uint32_t iBody = 0; iBody < blockLength; ++iBody)
+				points[iBody]					= bodies[iBlock + iBody]->getPointInWorldSpace(Position);
+			WindField->Sample(points, winds, blockLength);
+		}
+		for (uint32_t iBody = 0; iBody < blockLength; ++iBody)
+			UpdateForceFromTensor(bodies[iBlock + iBody], tensor, winds[iBody]);
+	}
+}
+
 Matrix3							AeroControl::GetTensor			()																																{
 		 if (ControlSetting <= -1.0f)	return MinTensor;
 	else if (ControlSetting >= 1.0f)	return MaxTensor;
@@ -85,3 +174,97 @@ Matrix3							AeroControl::GetTensor			()																																{
 	else 
 		return Tensor;
 }
+
+void							Buoyancy::ApplyBatch			(RigidBody * const *bodies, uint32_t count, double /*duration*/)																{
+	Vector3								points		[Aero::SampleBlockSize];
+	Vector3								currents	[Aero::SampleBlockSize]	= {};
+	for (uint32_t iBlock = 0; iBlock < count; iBlock += Aero::SampleBlockSize) {
+		const uint32_t						blockLength						= (count - iBlock < Aero::SampleBlockSize) ? count - iBlock : Aero::SampleBlockSize;
+		for (uint32_t iBody = 0; iBody < blockLength; ++iBody)
+			points[iBody]					= bodies[iBlock + iBody]->getPointInWorldSpace(CentreOfBuoyancy);
+		if (Current)
+			Current->Sample(points, currents, blockLength);
+		for (uint32_t iBody = 0; iBody < blockLength; ++iBody)
+			UpdateForceInCurrent(bodies[iBlock + iBody], points[iBody], currents[iBody]);
+	}
+}
+
+void							Spring::ApplyBatch				(RigidBody * const *bodies, uint32_t count, double duration)																	{
+	for (uint32_t iBody = 0; iBody < count; ++iBody)
+		Spring::UpdateForce(bodies[iBody], duration);
+}
+
+double							Explosion::GetReach				()																																const	{
+	double								reach							= 0;
+	if (TimePassed < ImplosionDuration)
+		reach							= ImplosionMaxRadius;
+	else {
+		const double						time							= TimePassed - ImplosionDuration;
+		if (time < ConcussionDuration)
+			reach							= ShockwaveSpeed * time + ShockwaveThickness * 0.5;
+		if (time < ConvectionDuration) {
+			const double						chimneyReach					= real_sqrt(ChimneyRadius * ChimneyRadius + ChimneyHeight * ChimneyHeight);
+			if (chimneyReach > reach)
+				reach							= chimneyReach;
+		}
+	}
+	return reach;
+}
+
+Vector3							Explosion::GetForce				(const Vector3 &position, const Vector3 &velocity)																				const	{
+	const Vector3						offset							= position - Detonation;
+	const double						distance						= offset.magnitude();
+	if (TimePassed < ImplosionDuration) {	// The implosion pulls in the objects in its ring with a constant force.
+		if (distance <= ImplosionMinRadius || distance > ImplosionMaxRadius)
+			return {};
+		return offset * (-ImplosionForce / distance);
+	}
+
+	Vector3								force							= {};
+	const double						time							= TimePassed - ImplosionDuration;
+	if (time < ConcussionDuration && distance > 0) {	// The concussion pushes the objects in the shell around the wavefront outwards, less so towards the edges of the shell and as the wave dies out.
+		const double						halfThickness					= ShockwaveThickness * 0.5;
+		const double						shell							= real_abs(distance - ShockwaveSpeed * time);
+		if (shell < halfThickness) {
+			const Vector3						outwards						= offset * (1.0 / distance);
+			double								relativeSpeed					= (ShockwaveSpeed > 0) ? 1 - (velocity * outwards) / ShockwaveSpeed : 1;	// Objects already moving outwards feel less of the wave, objects moving in feel more.
+			if (relativeSpeed < 0)
+				relativeSpeed					= 0;
+			force							+= outwards * (PeakConcussionForce * (1 - shell / halfThickness) * (1 - time / ConcussionDuration) * relativeSpeed);
+		}
+	}
+	if (time < ConvectionDuration && offset.y >= 0 && offset.y < ChimneyHeight) {	// The convection lifts the objects in the chimney, most in its centre.
+		const double						horizontal						= real_sqrt(offset.x * offset.x + offset.z * offset.z);
+		if (horizontal < ChimneyRadius)
+			force.y							+= PeakConvectionForce * (1 - horizontal / ChimneyRadius) * (1 - time / ConvectionDuration);
+	}
+	return force;
+}
+
+void							Explosion::UpdateForce			(RigidBody *body, double /*duration*/)																							{
+	if (body->Mass.InverseMass <= 0)
+		return;
+	const Vector3						force							= GetForce(body->Pivot.Position, body->Force.Velocity);
+	if (force.x || force.y || force.z)
+		body->addForce(force);	// This wakes the body up.
+}
+
+void							Explosion::UpdateForce			(Particle *particle, double /*duration*/)																						{
+	if (particle->InverseMass <= 0)
+		return;
+	particle->AccumulatedForce		+= GetForce(particle->Position, particle->Velocity);
+}
+
+void							Explosion::ApplyBatch			(RigidBody * const *bodies, uint32_t count, double duration)																	{
+	if (IsFinished())
+		return;
+	for (uint32_t iBody = 0; iBody < count; ++iBody)
+		Explosion::UpdateForce(bodies[iBody], duration);
+}
+
+void							Explosion::ApplyBatch			(Particle * const *particles, uint32_t count, double duration)																	{
+	if (IsFinished())
+		return;
+	for (uint32_t iParticle = 0; iParticle < count; ++iParticle)
+		Explosion::UpdateForce(particles[iParticle], duration);
+}
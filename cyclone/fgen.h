@@ -3,6 +3,7 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems, improductivity and underperformance originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "body.h"
 #include "pfgen.h"
+#include "vgrid.h"
 
 #include <vector>
 
@@ -15,9 +16,20 @@ namespace cyclone {
 	public:
 		// Overload this in implementations of the interface to calculate and update the force applied to the given rigid body.
 		virtual				void								UpdateForce						(RigidBody *body, double duration)													= 0;
+		// Updates the force of each of the given bodies. Implementations override this with a loop that calls their own UpdateForce directly, so a batch costs a single virtual call.
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double duration)						{ for (uint32_t iBody = 0; iBody < count; ++iBody) UpdateForce(bodies[iBody], duration); }
+	};
+
+	// Holds one force generator and all the bodies it applies to, so the generator can be applied to all of them with a single call.
+	struct ForceBatch {
+							ForceGenerator						* ForceGenerator				= 0;
+							::std::vector<RigidBody*>			Bodies							= {};	// A body added more than once is applied once: the duplicates are removed before the forces are next updated.
+							bool								IsChecked						= true;	// Cleared by Add, so the batch is checked for duplicates before it is next used.
 	};
 
 	// Holds all the force generators and the bodies they apply to.
+	// Registrations can be pushed into Registrations one pair at a time, which costs one virtual call per pair, or added with Add, which groups them by generator into batches.
+	// Each batch makes its own pass over its bodies, so batching pays off for generators applied to many bodies rather than for several generators sharing the same few.
 	struct ForceRegistry {
 		// Keeps track of one force generator and the body it applies to.
 		struct ForceRegistration {
@@ -26,12 +38,11 @@ namespace cyclone {
 		};
 		typedef				::std::vector<ForceRegistration>	TRegistry;
 							TRegistry							Registrations;	// Holds the list of registrations.
-		
-		// Calls all the force generators to update the forces of their corresponding bodies.
-							void								UpdateForces					(double duration)																	{
-			for (TRegistry::iterator i = Registrations.begin(); i != Registrations.end(); i++)
-				i->ForceGenerator->UpdateForce(i->Body, duration);
-		}
+							::std::vector<ForceBatch>			Batches							= {};	// Holds the registrations added with Add, grouped by generator.
+
+							void								Add								(RigidBody *body, ForceGenerator *generator);	// Registers the generator to apply to the body, in the batch of the generator. Adding a pair that is already registered has no effect.
+							bool								Remove							(RigidBody *body, ForceGenerator *generator);	// Removes a registration added with Add. The order of the batch changes. Returns false if it wasn't found.
+							void								UpdateForces					(double duration);	// Calls all the force generators to update the forces of their corresponding bodies. Each batch costs a single virtual call.
 	};
 
 	// A force generator that applies a Spring force.
@@ -53,19 +64,28 @@ namespace cyclone {
 		);
 
 		virtual				void								UpdateForce						(RigidBody *body, double duration);	// Applies the spring force to the given rigid body.
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies an aerodynamic force.
+	// The wind can be uniform, read through the Windspeed pointer, or vary across the world, sampled from a velocity grid at the position of the surface. When both are given they add up.
 	class Aero : public ForceGenerator {
 	protected:
 							Matrix3								Tensor							= {};	// Holds the aerodynamic tensor for the surface in body space.
 							Vector3								Position						= {};	// Holds the relative position of the aerodynamic surface in body coordinates.
 							const Vector3						* Windspeed						= 0;	// Holds a pointer to a vector containing the windspeed of the environment. This is easier than managing a separate windspeed vector per generator and having to update it manually as the wind changes.
+							const VelocityGrid					* WindField						= 0;	// Holds the grid the wind is sampled from, if any.
 	public:
+		static constexpr	uint32_t							SampleBlockSize					= 64;	// Holds the number of surfaces whose wind is sampled from the grid at once when applying a batch.
+
 		inline constexpr										Aero							(const Matrix3 &tensor, const Vector3 &position, const Vector3 *windspeed)			: Tensor(tensor), Position(position), Windspeed(windspeed)		{}
+		inline				void								SetWindField					(const VelocityGrid *windField)														{ WindField = windField; }	// Sets the grid to sample the wind from. Null stops sampling.
 		virtual				void								UpdateForce						(RigidBody *body, double duration)													{ Aero::UpdateForceFromTensor(body, duration, Tensor);			}
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double /*duration*/)					{ Aero::ApplyBatchFromTensor(bodies, count, Tensor);			}
 	protected:
 							void								UpdateForceFromTensor			(RigidBody *body, double duration, const Matrix3 &tensor);	// Uses an explicit tensor matrix to update the force on the given rigid body. This is exactly the same as for UpdateForce only it takes an explicit tensor.
+							void								UpdateForceFromTensor			(RigidBody *body, const Matrix3 &tensor, const Vector3 &wind);	// Applies the force for the given tensor and wind velocity at the surface.
+							void								ApplyBatchFromTensor			(RigidBody * const *bodies, uint32_t count, const Matrix3 &tensor);	// Applies the force to each of the given bodies, sampling the wind for a block of surfaces at a time.
 	};
 
 	// A force generator with a control aerodynamic surface. This requires three inertia tensors, for the two extremes and 'resting' position of the control surface. The latter tensor is the one inherited from the base class, the two extremes are defined in this class.
@@ -91,15 +111,18 @@ namespace cyclone {
 		{}
 		inline				void								SetControl						(double value)						{ ControlSetting = value; }	// Sets the control position of this control. This should range between -1 (in which case the minTensor value is used), through 0 (where the base-class tensor value is used) to +1 (where the maxTensor value is used). Values outside that range give undefined results.
 		virtual				void								UpdateForce						(RigidBody *body, double duration)	{ Aero::UpdateForceFromTensor(body, duration, GetTensor()); }
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double /*duration*/)	{ Aero::ApplyBatchFromTensor(bodies, count, GetTensor()); }	// Calculates the tensor for the control setting once for the whole batch.
 	};
 
-	// A force generator to apply a buoyant force to a rigid body.
+	// A force generator to apply a buoyant force to a rigid body. The water can also carry the body along with a current sampled from a velocity grid at the centre of buoyancy.
 	class Buoyancy : public ForceGenerator {
 							Vector3								CentreOfBuoyancy				= {};		// The centre of buoyancy of the rigid body, in body coordinates.
 							double								MaxDepth						= 0;		// The maximum submersion depth of the object before it generates its maximum buoyancy force.
 							double								Volume							= 0;		// The volume of the object.
 							double								WaterHeight						= 0;		// The height of the water plane above y=0. The plane will be parallel to the XZ plane.
 							double								LiquidDensity					= 1000.0f;	// The density of the liquid. Pure water has a density of 1000kg per cubic meter.
+							const VelocityGrid					* Current						= 0;		// Holds the grid the water current is sampled from, if any.
+							double								CurrentDrag						= 0;		// Holds the force pulling the body towards the velocity of the current, per unit of relative speed, when fully submerged. It scales down with the submerged fraction.
 	public:
 																Buoyancy
 			(	const Vector3	& centreOfBuoyancy
@@ -109,7 +132,12 @@ namespace cyclone {
 			,	double			liquidDensity	= 1000.0f
 			);
 
+		// Sets the grid to sample the water current from, and the drag towards it. Null stops sampling.
+		inline				void								SetCurrent						(const VelocityGrid *current, double currentDrag)									{ Current = current; CurrentDrag = currentDrag; }
 		virtual				void								UpdateForce						(RigidBody *body, double duration);	// Applies the force to the given rigid body.
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double duration);	// Applies the force to each of the given bodies, sampling the current for a block of bodies at a time.
+	protected:
+							void								UpdateForceInCurrent			(RigidBody *body, const Vector3 &pointInWorld, const Vector3 &current);	// Applies the force for the given centre of buoyancy in world space and current velocity there.
 	};
 	//// A force generator that applies a gravitational force. One instance can be used for multiple rigid bodies.
 	//class ForceGravity : public ForceGenerator {
@@ -131,33 +159,39 @@ namespace cyclone {
 	//
 	//	virtual				void								UpdateForce						(RigidBody *body, double duration);	// Applies the force to the given rigid body.
 	//};
-	//
-	//// A force generator showing a three component explosion effect. This force generator is intended to represent a single explosion effect for multiple rigid bodies. The force generator can also act as a particle force generator.
-	//class Explosion : public ForceGenerator,
-	//                  public ParticleForceGenerator
-	//{
-	//						double								timePassed;	// Tracks how long the explosion has been in operation, used for time-sensitive effects.
-	//public:
-	//	// Properties of the explosion, these are public because there are so many and providing a suitable constructor would be cumbersome:
-	//						Vector3								detonation					= {};	// The location of the detonation of the weapon.
-	//						double								implosionMaxRadius			= 0;	// The radius up to which objects implode in the first stage of the explosion.
-	//						double								implosionMinRadius			= 0;	// The radius within which objects don't feel the implosion force. Objects near to the detonation aren't sucked in by the air implosion.
-	//						double								implosionDuration			= 0;	// The length of time that objects spend imploding before the concussion phase kicks in.
-	//						double								implosionForce				= 0;	// The maximal force that the implosion can apply. This should be relatively small to avoid the implosion pulling objects through the detonation point and out the other side before the concussion wave kicks in.
-	//						double								shockwaveSpeed				= 0;	// The speed that the shock wave is traveling, this is related to the thickness below in the relationship: thickness >= speed * minimum frame duration
-	//						double								shockwaveThickness			= 0;	// The shock wave applies its force over a range of distances, this controls how thick. Faster waves require larger thicknesses.
-	//						double								peakConcussionForce			= 0;	// This is the force that is applied at the very centre of the concussion wave on an object that is stationary. Objects that are in front or behind of the wavefront, or that are already moving outwards, get proportionally less force. Objects moving in towards the centre get proportionally more force.
-	//						double								concussionDuration			= 0;	// The length of time that the concussion wave is active. As the wave nears this, the forces it applies reduces.
-	//						double								peakConvectionForce			= 0;	// This is the peak force for stationary objects in the centre of the convection chimney. Force calculations for this value are the same as for peakConcussionForce.
-	//						double								chimneyRadius				= 0;	// The radius of the chimney cylinder in the xz plane.
-	//						double								chimneyHeight				= 0;	// The maximum height of the chimney.
-	//						double								convectionDuration			= 0;	// The length of time the convection chimney is active. Typically this is the longest effect to be in operation, as the heat from the explosion outlives the shock wave and implosion itself.
-	//
-	//public:
-	//	virtual				void								UpdateForce					(RigidBody * body, double duration)		= 0;	// Calculates and applies the force that the explosion has on the given rigid body.
-	//	virtual				void								UpdateForce					(Particle *particle, double duration)	= 0;	// Calculates and applies the force that the explosion has on the given particle.
-	//
-	//};
+
+	// A force generator showing a three component explosion effect. This force generator is intended to represent a single explosion effect for multiple rigid bodies. The force generator can also act as a particle force generator.
+	// The explosion first implodes, pulling in the objects around it, then sends out a concussion wave and finally leaves a convection chimney that lifts the objects above it. The concussion and the convection start together when the implosion ends.
+	// Applying the force doesn't advance the explosion, so it can be applied to any number of objects in a frame. Call Advance once per frame instead.
+	class Explosion : public ForceGenerator, public ParticleForceGenerator {
+	public:
+		// Properties of the explosion, these are public because there are so many and providing a suitable constructor would be cumbersome:
+							Vector3								Detonation						= {};	// The location of the detonation of the weapon.
+							double								ImplosionMaxRadius				= 0;	// The radius up to which objects implode in the first stage of the explosion.
+							double								ImplosionMinRadius				= 0;	// The radius within which objects don't feel the implosion force. Objects near to the detonation aren't sucked in by the air implosion.
+							double								ImplosionDuration				= 0;	// The length of time that objects spend imploding before the concussion phase kicks in.
+							double								ImplosionForce					= 0;	// The maximal force that the implosion can apply. This should be relatively small to avoid the implosion pulling objects through the detonation point and out the other side before the concussion wave kicks in.
+							double								ShockwaveSpeed					= 0;	// The speed that the shock wave is traveling, this is related to the thickness below in the relationship: thickness >= speed * minimum frame duration
+							double								ShockwaveThickness				= 0;	// The shock wave applies its force over a range of distances, this controls how thick. Faster waves require larger thicknesses.
+							double								PeakConcussionForce				= 0;	// This is the force that is applied at the very centre of the concussion wave on an object that is stationary. Objects that are in front or behind of the wavefront, or that are already moving outwards, get proportionally less force. Objects moving in towards the centre get proportionally more force.
+							double								ConcussionDuration				= 0;	// The length of time that the concussion wave is active. As the wave nears this, the forces it applies reduces.
+							double								PeakConvectionForce				= 0;	// This is the peak force for stationary objects in the centre of the convection chimney. Force calculations for this value are the same as for peakConcussionForce.
+							double								ChimneyRadius					= 0;	// The radius of the chimney cylinder in the xz plane.
+							double								ChimneyHeight					= 0;	// The maximum height of the chimney.
+							double								ConvectionDuration				= 0;	// The length of time the convection chimney is active. Typically this is the longest effect to be in operation, as the heat from the explosion outlives the shock wave and implosion itself.
+							double								TimePassed						= 0;	// Tracks how long the explosion has been in operation, used for time-sensitive effects.
+
+		inline				void								Advance							(double duration)									{ TimePassed += duration; }	// Moves the explosion forward in time by the given duration.
+		// Returns true once all three phases are over and the explosion applies no more force.
+		inline				bool								IsFinished						()											const	{ return TimePassed >= ImplosionDuration + ((ConcussionDuration > ConvectionDuration) ? ConcussionDuration : ConvectionDuration); }
+							double								GetReach						()											const;	// Returns the distance from the detonation beyond which no object feels the explosion at its current time.
+							Vector3								GetForce						(const Vector3 &position, const Vector3 &velocity)	const;	// Calculates the force the explosion applies at its current time to an object at the given position, moving with the given velocity.
+
+		virtual				void								UpdateForce						(RigidBody *body, double duration);		// Calculates and applies the force that the explosion has on the given rigid body.
+		virtual				void								UpdateForce						(Particle *particle, double duration);	// Calculates and applies the force that the explosion has on the given particle.
+		virtual				void								ApplyBatch						(RigidBody * const *bodies, uint32_t count, double duration);		// Applies the force to each of the given bodies, or to none once the explosion is finished.
+		virtual				void								ApplyBatch						(Particle * const *particles, uint32_t count, double duration);	// Applies the force to each of the given particles, or to none once the explosion is finished.
+	};
 }
 
 #endif // CYCLONE_FGEN_H
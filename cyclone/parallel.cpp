@@ -0,0 +1,81 @@
+// Implementation file for the thread pool.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "parallel.h"
+#include "profile.h"
+
+using namespace cyclone;
+
+										ThreadPool::ThreadPool					(uint32_t workerCount)																					{
+	if (0 == workerCount) {
+		const uint32_t								hardwareThreads							= ::std::thread::hardware_concurrency();
+		workerCount								= (hardwareThreads > 1) ? hardwareThreads - 1 : 0;
+	}
+	for (uint32_t iWorker = 0; iWorker < workerCount; ++iWorker)
+		Workers.push_back(::std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+										ThreadPool::~ThreadPool					()																										{
+	{
+		::std::lock_guard<::std::mutex>				lock									(Mutex);
+		Stopping								= true;
+	}
+	JobReady.notify_all();
+	for (uint32_t iWorker = 0; iWorker < Workers.size(); ++iWorker)
+		Workers[iWorker].join();
+}
+
+void									ThreadPool::RunChunks					()																										{
+	while (true) {
+		const uint32_t								chunk									= NextChunk.fetch_add(1);
+		const uint64_t								begin									= (uint64_t)chunk * JobChunkSize;
+		if (begin >= JobCount)
+			return;
+		const uint64_t								end										= begin + JobChunkSize;
+		CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_PARALLEL_CHUNK);
+		(*Job)((uint32_t)begin, (end < JobCount) ? (uint32_t)end : JobCount);
+	}
+}
+
+void									ThreadPool::WorkerLoop					()																										{
+	uint64_t									lastGeneration							= 0;
+	while (true) {
+		{
+			::std::unique_lock<::std::mutex>			lock									(Mutex);
+			JobReady.wait(lock, [this, lastGeneration]() { return Stopping || JobGeneration != lastGeneration; });
+			if (Stopping)
+				return;
+			lastGeneration							= JobGeneration;
+		}
+		RunChunks();
+		{
+			::std::lock_guard<::std::mutex>				lock									(Mutex);
+			if (0 == --BusyWorkers)
+				JobDone.notify_one();
+		}
+	}
+}
+
+void									ThreadPool::ParallelFor					(uint32_t count, uint32_t chunkSize, const TRangeJob &job)												{
+	if (0 == chunkSize)
+		chunkSize								= 1;
+	if (0 == Workers.size() || count <= chunkSize) {
+		if (count)
+			job(0, count);
+		return;
+	}
+	{
+		::std::lock_guard<::std::mutex>				lock									(Mutex);
+		Job										= &job;
+		JobCount								= count;
+		JobChunkSize							= chunkSize;
+		NextChunk								= 0;
+		BusyWorkers								= (uint32_t)Workers.size();
+		++JobGeneration;
+	}
+	JobReady.notify_all();
+	RunChunks();
+	::std::unique_lock<::std::mutex>			lock									(Mutex);
+	JobDone.wait(lock, [this]() { return 0 == BusyWorkers; });
+	Job										= 0;
+}
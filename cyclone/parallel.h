@@ -0,0 +1,51 @@
+// This file contains the thread pool used to run the simulation phases that are independent for each object over several threads.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "precision.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#ifndef CYCLONE_PARALLEL_H
+#define CYCLONE_PARALLEL_H
+
+namespace cyclone {
+	// Holds a set of worker threads that split ranges of work between them. The workers are started once and sleep between jobs, so a job only costs a wake up.
+	// The thread calling ParallelFor works on the job too, and returns when the whole range has been processed.
+	class ThreadPool {
+		typedef	::std::function<void(uint32_t begin, uint32_t end)>	TRangeJob;
+
+		::std::vector<::std::thread>		Workers					= {};
+		::std::mutex						Mutex					;
+		::std::condition_variable			JobReady				;
+		::std::condition_variable			JobDone					;
+		const TRangeJob						* Job					= 0;
+		uint32_t							JobCount				= 0;	// Holds the size of the range of the current job.
+		uint32_t							JobChunkSize			= 0;	// Holds the number of elements taken by a thread at a time.
+		::std::atomic<uint32_t>				NextChunk				= {0};	// Holds the index of the next chunk to be taken.
+		uint32_t							BusyWorkers				= 0;	// Holds the number of workers that haven't finished the current job.
+		uint64_t							JobGeneration			= 0;	// Incremented for each job, so the workers can tell a new job from a spurious wake up.
+		bool								Stopping				= false;
+
+		void								RunChunks				();
+		void								WorkerLoop				();
+	public:
+		// Starts the given number of worker threads. Zero starts one less than the number of hardware threads, so together with the calling thread every hardware thread is used.
+											ThreadPool				(uint32_t workerCount = 0);
+											~ThreadPool				();
+											ThreadPool				(const ThreadPool &)								= delete;
+		ThreadPool&							operator=				(const ThreadPool &)								= delete;
+
+		inline	uint32_t					GetThreadCount			()									const			{ return (uint32_t)Workers.size() + 1; }	// Returns the number of threads that work on a job, including the calling one.
+		// Splits the range [0, count) into chunks of the given size and calls the job with the bounds of each chunk, from all the threads at once. The job must be safe to run concurrently on disjoint chunks.
+		// Which thread runs a chunk changes from run to run. Jobs that write each result from a single element, with no sums across chunks, give the same results with any number of threads, as all the jobs of the engine do.
+		// Ranges no longer than a chunk run directly on the calling thread.
+		void								ParallelFor				(uint32_t count, uint32_t chunkSize, const TRangeJob & job);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_PARALLEL_H
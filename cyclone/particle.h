@@ -19,7 +19,9 @@ namespace cyclone {
 		void							SetMass							(const double mass)					{ InverseMass = ((double)1.0) / mass;						}
 		double							GetMass							()							const	{ return (InverseMass == 0) ? REAL_MAX : 1.0 / InverseMass;	}
 		bool							HasFiniteMass					()							const	{ return InverseMass >= 0.0f;								}
-		void							Integrate						(double duration)					{
+		void							Integrate						(double duration)					{ Integrate(duration, real_pow(Damping, duration)); }
+		// Integrates the particle with the given damping factor instead of raising Damping to the power of the duration.
+		void							Integrate						(double duration, double dampingFactor)	{
 			if (InverseMass <= 0.0f)	// We don't integrate things with infinite mass.
 				return;
 		
@@ -30,7 +32,7 @@ namespace cyclone {
 			resultingAcceleration			+= AccumulatedForce * InverseMass;
 
 			Velocity						+= resultingAcceleration * duration;	// Update linear velocity from the acceleration.
-			Velocity						*= real_pow(Damping, duration);			// Impose drag.
+			Velocity						*= dampingFactor;						// Impose drag.
 			
 			AccumulatedForce				= {};	// Clear the forces.
 		}
@@ -42,6 +42,7 @@ namespace cyclone {
 		inline	constexpr					ParticleContactResolver				(uint32_t iterations)															: Iterations(iterations)	{}
 											
 				void						SetIterations						(uint32_t iterations)															{ Iterations = iterations;	}
+		inline	uint32_t					GetIterationsUsed					()																		const	{ return IterationsUsed;	}	// Returns the number of iterations used by the last call to ResolveContacts.
 		// Resolves a set of particle contacTs for both penetration and velocity.
 		// Contacts that cannot interact witH each other should be passed to separate calls to resolveContacts, as the resolution algorithm takes much longer for lots of contacts than it does for the same number of contacts in small sets.
 		// contactArray		: Pointer to an Array of particle contact objects.
@@ -0,0 +1,135 @@
+// Implementation file for the particle emitter.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "pemitter.h"
+
+#include <assert.h>
+
+using namespace cyclone;
+
+uint32_t								ParticleEmitter::AddRule				(const ParticleEmitterRule &rule, const ParticleEmitterPayload *payloads, uint32_t payloadCount)		{
+	ParticleEmitterRule							added									= rule;
+	added.FirstPayload						= (uint32_t)Payloads.size();
+	added.PayloadCount						= payloads ? payloadCount : 0;
+	added.DampingClass						= Particles.AddDampingClass(rule.Damping);
+	assert(added.DampingClass != DampingTable::InvalidClass && "The damping table of the emitter is full.");
+	if (payloads)
+		Payloads.insert(Payloads.end(), payloads, payloads + payloadCount);
+	Rules.push_back(added);
+	return (uint32_t)Rules.size() - 1;
+}
+
+void									ParticleEmitter::Reserve				(uint32_t capacity)																						{
+	if (Size() > capacity) {
+		Particles.Resize(capacity);
+		Age.resize(capacity);
+		Rule.resize(capacity);
+	}
+	Capacity								= capacity;
+	Particles		.Reserve(capacity);
+	Age				.reserve(capacity);
+	Rule			.reserve(capacity);
+	DeadX			.reserve(capacity);
+	DeadY			.reserve(capacity);
+	DeadZ			.reserve(capacity);
+	DeadVelocityX	.reserve(capacity);
+	DeadVelocityY	.reserve(capacity);
+	DeadVelocityZ	.reserve(capacity);
+	DeadRule		.reserve(capacity);
+}
+
+void									ParticleEmitter::Clear					()																										{
+	Particles.Clear();
+	Age.clear();
+	Rule.clear();
+}
+
+uint32_t								ParticleEmitter::Emit					(uint32_t rule, uint32_t count, const Vector3 &position, const Vector3 &velocity)						{
+	const uint32_t								first									= Size();
+	if (rule >= Rules.size() || first >= Capacity)
+		return 0;
+	if (count > Capacity - first)
+		count									= Capacity - first;
+
+	const ParticleEmitterRule					& emitted								= Rules[rule];
+	Particles.Resize(first + count);
+	Age.resize(first + count);
+	Rule.resize(first + count, rule);
+	for (uint32_t iParticle = first; iParticle < first + count; ++iParticle) {
+		Particles.SetPosition		(iParticle, position);
+		Particles.SetAcceleration	(iParticle, emitted.Acceleration);
+		Particles.InverseMass		[iParticle]	= emitted.InverseMass;
+		Particles.DampingClass		[iParticle]	= emitted.DampingClass;
+	}
+
+	// The random values of a block are drawn in bulk first and then turned into ages and velocities by loops with no calls in them, which the compiler can process several particles at a time.
+	const double								ageRange								= emitted.MaxAge - emitted.MinAge;
+	const Vector3								minVelocity								= velocity + emitted.MinVelocity;
+	const Vector3								velocityRange							= emitted.MaxVelocity - emitted.MinVelocity;
+	double										randoms	[4 * SpawnBlock];
+	for (uint32_t blockBegin = 0; blockBegin < count; blockBegin += SpawnBlock) {
+		const uint32_t								blockCount								= (count - blockBegin < SpawnBlock) ? count - blockBegin : SpawnBlock;
+		Generator.FillReal(randoms, blockCount * 4);
+
+		const uint32_t								blockFirst								= first + blockBegin;
+		double										* age									= &Age					[blockFirst];
+		double										* velocityX								= &Particles.VelocityX	[blockFirst];
+		double										* velocityY								= &Particles.VelocityY	[blockFirst];
+		double										* velocityZ								= &Particles.VelocityZ	[blockFirst];
+		for (uint32_t iParticle = 0; iParticle < blockCount; ++iParticle) {
+			age			[iParticle]					= emitted.MinAge	+ randoms[iParticle]					* ageRange;
+			velocityX	[iParticle]					= minVelocity.x		+ randoms[blockCount		+ iParticle]	* velocityRange.x;
+			velocityY	[iParticle]					= minVelocity.y		+ randoms[blockCount * 2	+ iParticle]	* velocityRange.y;
+			velocityZ	[iParticle]					= minVelocity.z		+ randoms[blockCount * 3	+ iParticle]	* velocityRange.z;
+		}
+	}
+	return count;
+}
+
+void									ParticleEmitter::Update					(double duration)																						{
+	if (duration <= 0)
+		return;
+	Particles.Integrate(duration);
+
+	DeadX			.clear();
+	DeadY			.clear();
+	DeadZ			.clear();
+	DeadVelocityX	.clear();
+	DeadVelocityY	.clear();
+	DeadVelocityZ	.clear();
+	DeadRule		.clear();
+	const uint32_t								count									= Size();
+	uint32_t									kept									= 0;
+	for (uint32_t iParticle = 0; iParticle < count; ++iParticle) {
+		Age[iParticle]							-= duration;
+		if (Age[iParticle] < 0 || Particles.PositionY[iParticle] < FloorHeight) {
+			if (Rules[Rule[iParticle]].PayloadCount) {	// Keep what the payload needs, as the particle is about to be overwritten.
+				DeadX			.push_back(Particles.PositionX[iParticle]);
+				DeadY			.push_back(Particles.PositionY[iParticle]);
+				DeadZ			.push_back(Particles.PositionZ[iParticle]);
+				DeadVelocityX	.push_back(Particles.VelocityX[iParticle]);
+				DeadVelocityY	.push_back(Particles.VelocityY[iParticle]);
+				DeadVelocityZ	.push_back(Particles.VelocityZ[iParticle]);
+				DeadRule		.push_back(Rule[iParticle]);
+			}
+			continue;
+		}
+		if (kept != iParticle) {
+			Particles.Move(iParticle, kept);
+			Age[kept]								= Age[iParticle];
+			Rule[kept]								= Rule[iParticle];
+		}
+		++kept;
+	}
+	Particles.Resize(kept);
+	Age.resize(kept);
+	Rule.resize(kept);
+
+	for (uint32_t iDead = 0; iDead < DeadRule.size(); ++iDead) {
+		const ParticleEmitterRule					& rule									= Rules[DeadRule[iDead]];
+		const Vector3								position								= {DeadX[iDead], DeadY[iDead], DeadZ[iDead]};
+		const Vector3								velocity								= {DeadVelocityX[iDead], DeadVelocityY[iDead], DeadVelocityZ[iDead]};
+		for (uint32_t iPayload = rule.FirstPayload; iPayload < rule.FirstPayload + rule.PayloadCount; ++iPayload)
+			Emit(Payloads[iPayload].Rule, Payloads[iPayload].Count, position, velocity);
+	}
+}
@@ -0,0 +1,70 @@
+// This file contains the particle emitter: a fixed capacity pool of short lived particles, created in bulk from rules and removed when their time runs out.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "psystem.h"
+#include "random.h"
+
+#include <vector>
+
+#ifndef CYCLONE_PEMITTER_H
+#define CYCLONE_PEMITTER_H
+
+namespace cyclone {
+	// Holds the particles a rule creates when one of its particles dies.
+	struct ParticleEmitterPayload {
+		uint32_t							Rule					= 0;	// Holds the index of the rule of the new particles.
+		uint32_t							Count					= 0;
+	};
+
+	// Holds how the particles of a kind are created: how long they live and how fast they start, relative to the velocity they are emitted with.
+	struct ParticleEmitterRule {
+		double								MinAge					= 1;	// Holds the shortest life of a particle, in seconds.
+		double								MaxAge					= 1;
+		Vector3								MinVelocity				= {};
+		Vector3								MaxVelocity				= {};
+		Vector3								Acceleration			= Vector3::GRAVITY;
+		double								Damping					= 1;
+		double								InverseMass				= 1;
+		uint32_t							FirstPayload			= 0;	// Holds the index of the first payload of this rule in the Payloads of the emitter.
+		uint32_t							PayloadCount			= 0;
+		uint16_t							DampingClass			= 0;	// Set by AddRule.
+	};
+
+	// Holds a pool of particles created by rules. The live particles are packed at the start of the arrays, so integrating them streams through contiguous memory with no gaps.
+	// All the memory is reserved by Reserve, so creating and removing particles never allocates. Particles that don't fit in the capacity are not created.
+	// Update ages the particles and removes the dead ones in the same pass that packs the survivors, then creates the payloads of the dead particles from their last position and velocity.
+	struct ParticleEmitter {
+		typedef	::std::vector<double>		TReals;
+
+		static constexpr	uint32_t		SpawnBlock				= 256;	// Holds the number of particles whose random values are generated at a time.
+
+		ParticleSystem						Particles				= {};
+		TReals								Age						= {};	// Holds the time left to live of each particle, in seconds.
+		::std::vector<uint32_t>				Rule					= {};	// Holds the index of the rule that created each particle.
+		::std::vector<ParticleEmitterRule>	Rules					= {};
+		::std::vector<ParticleEmitterPayload>	Payloads			= {};
+		RandomStream						Generator				= {};	// Holds the stream the random ages and velocities are drawn from. Seed it to make the particles repeatable.
+		double								FloorHeight				= -REAL_MAX;	// Particles that fall below this height die.
+		uint32_t							Capacity				= 0;
+		TReals								DeadX					= {};	// Holds the last position and velocity of the dead particles with payloads, for creating their payloads.
+		TReals								DeadY					= {};
+		TReals								DeadZ					= {};
+		TReals								DeadVelocityX			= {};
+		TReals								DeadVelocityY			= {};
+		TReals								DeadVelocityZ			= {};
+		::std::vector<uint32_t>				DeadRule				= {};
+
+		inline	uint32_t					Size					()															const	{ return Particles.Size(); }
+		// Adds a rule, with the given payloads, and returns its index. Rules and payloads should be added before Reserve, as adding them may allocate.
+		uint32_t							AddRule					(const ParticleEmitterRule &rule, const ParticleEmitterPayload *payloads = 0, uint32_t payloadCount = 0);
+		void								Reserve					(uint32_t capacity);	// Sets the largest number of particles and reserves all the memory for them.
+		void								Clear					();	// Removes all the particles.
+
+		// Creates up to the given number of particles of the given rule at the given position, with their velocity relative to the given one. Returns the number of particles created.
+		uint32_t							Emit					(uint32_t rule, uint32_t count, const Vector3 &position, const Vector3 &velocity = {});
+		// Integrates the particles forward in time by the given duration, removes the ones that died and creates their payloads.
+		void								Update					(double duration);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_PEMITTER_H
@@ -2,13 +2,108 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "pfgen.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace cyclone;
 
+// Drops the particles added to the batch more than once since it was last checked, keeping the order of the others. Sorting a copy finds them without a search per Add, and the batch is only rewritten if there are any.
+static	void							removeDuplicates						(ParticleForceBatch &batch)																				{
+	if (batch.IsChecked)
+		return;
+	batch.IsChecked							= true;
+	::std::vector<Particle*>					sorted									= batch.Particles;
+	::std::sort(sorted.begin(), sorted.end(), ::std::less<Particle*>());
+	if (::std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end())
+		return;
+	sorted.erase(::std::unique(sorted.begin(), sorted.end()), sorted.end());
+	::std::vector<bool>							kept									(sorted.size(), false);
+	uint32_t									keptCount								= 0;
+	for (uint32_t iParticle = 0; iParticle < batch.Particles.size(); ++iParticle) {
+		Particle									* particle								= batch.Particles[iParticle];
+		const size_t								index									= ::std::lower_bound(sorted.begin(), sorted.end(), particle, ::std::less<Particle*>()) - sorted.begin();
+		if (!kept[index]) {	// The first occurrence keeps its place, and the ones after it are dropped.
+			kept[index]								= true;
+			batch.Particles[keptCount++]			= particle;
+		}
+	}
+	batch.Particles.resize(keptCount);
+}
+
 void ParticleForceRegistry::UpdateForces(double duration)
 {
-    TRegistry::iterator i = Registrations.begin();
-    for (; i != Registrations.end(); i++)
-        i->ForceGenerator->UpdateForce(i->Particle, duration);
+	TRegistry::iterator i = Registrations.begin();
+	for (; i != Registrations.end(); i++) {
+		i->ForceGenerator->UpdateForce(i->Particle, duration);
+	}
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch) {
+		removeDuplicates(Batches[iBatch]);
+		Batches[iBatch].ForceGenerator->ApplyBatch(Batches[iBatch].Particles.data(), (uint32_t)Batches[iBatch].Particles.size(), duration);
+	}
+}
+
+void									ParticleForceRegistry::Add				(Particle *particle, ParticleForceGenerator *generator)													{
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch)
+		if (Batches[iBatch].ForceGenerator == generator) {
+			Batches[iBatch].Particles.push_back(particle);
+			Batches[iBatch].IsChecked				= false;
+			return;
+		}
+	Batches.push_back({generator, {particle}, true});
+}
+
+bool									ParticleForceRegistry::Remove			(Particle *particle, ParticleForceGenerator *generator)													{
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch) {
+		if (Batches[iBatch].ForceGenerator != generator)
+			continue;
+		removeDuplicates(Batches[iBatch]);	// So a pair added twice is gone after a single removal, as it is registered once.
+		::std::vector<Particle*>					& particles								= Batches[iBatch].Particles;
+		for (uint32_t iParticle = 0; iParticle < particles.size(); ++iParticle)
+			if (particles[iParticle] == particle) {
+				particles[iParticle]					= particles.back();
+				particles.pop_back();
+				if (particles.empty())
+					Batches.erase(Batches.begin() + iBatch);
+				return true;
+			}
+		return false;
+	}
+	return false;
+}
+
+void									ParticleForceRegistry::UpdateSchedule	()																										{
+	const uint32_t								count									= (uint32_t)Registrations.size();
+	if (ScheduledRegistrations.size() == count && (0 == count || 0 == memcmp(ScheduledRegistrations.data(), Registrations.data(), count * sizeof(ParticleForceRegistration))))
+		return;
+	ScheduledRegistrations					= Registrations;
+	const ParticleForceRegistration				* registrations							= Registrations.data();
+
+	// Group the registrations by particle, for splitting them between threads.
+	ParticleOrder.resize(count);
+	for (uint32_t iRegistration = 0; iRegistration < count; ++iRegistration)
+		ParticleOrder[iRegistration]			= iRegistration;
+	::std::stable_sort(ParticleOrder.begin(), ParticleOrder.end(), [registrations](uint32_t a, uint32_t b) { return ::std::less<const Particle*>()(registrations[a].Particle, registrations[b].Particle); });
+	ParticleGroups.clear();
+	for (uint32_t iOrder = 0; iOrder < count; ++iOrder)
+		if (0 == iOrder || registrations[ParticleOrder[iOrder]].Particle != registrations[ParticleOrder[iOrder - 1]].Particle)
+			ParticleGroups.push_back(iOrder);
+	ParticleGroups.push_back(count);
+}
+
+void									ParticleForceRegistry::UpdateForces		(double duration, ThreadPool &threads, uint32_t chunkSize)												{
+	UpdateSchedule();
+	if (ParticleGroups.size() > 1)
+		threads.ParallelFor((uint32_t)ParticleGroups.size() - 1, chunkSize, [this, duration](uint32_t begin, uint32_t end) {
+			for (uint32_t iOrder = ParticleGroups[begin]; iOrder < ParticleGroups[end]; ++iOrder) {
+				const ParticleForceRegistration				& registration							= Registrations[ParticleOrder[iOrder]];
+				registration.ForceGenerator->UpdateForce(registration.Particle, duration);
+			}
+		});
+	for (uint32_t iBatch = 0; iBatch < Batches.size(); ++iBatch) {	// A particle appears once per batch after removing the duplicates, so the chunks of a batch touch different particles.
+		ParticleForceBatch							& batch									= Batches[iBatch];
+		removeDuplicates(batch);
+		threads.ParallelFor((uint32_t)batch.Particles.size(), chunkSize, [&batch, duration](uint32_t begin, uint32_t end) { batch.ForceGenerator->ApplyBatch(&batch.Particles[begin], end - begin, duration); });
+	}
 }
 
 void ParticleGravity::UpdateForce(Particle* particle, double duration) {
@@ -152,3 +247,19 @@ void ParticleAnchoredSpring::UpdateForce(Particle* particle, double duration)
     force								*= magnitude;
     particle->AccumulatedForce			+= force;
 }
+
+// Calls the generator's own UpdateForce for each particle. The call is qualified with the generator type, so it is bound at compile time and can be inlined into the loop.
+template<typename _tGenerator>
+static inline	void					applyBatch								(_tGenerator &generator, Particle * const *particles, uint32_t count, double duration)					{
+	for (uint32_t iParticle = 0; iParticle < count; ++iParticle)
+		generator._tGenerator::UpdateForce(particles[iParticle], duration);
+}
+
+void									ParticleGravity			::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleDrag			::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleAnchoredSpring	::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleAnchoredBungee	::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleFakeSpring		::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleSpring			::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleBungee			::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
+void									ParticleBuoyancy		::ApplyBatch	(Particle * const *particles, uint32_t count, double duration)											{ applyBatch(*this, particles, count, duration); }
@@ -2,6 +2,7 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices, obsolete tools and OOP vices.
 #include "core.h"
 #include "particle.h"
+#include "parallel.h"
 
 #include <vector>
 
@@ -13,10 +14,21 @@ namespace cyclone {
 	class ParticleForceGenerator {
 	public:
 		virtual	void									UpdateForce						(Particle *particle, double duration)													= 0;	// Overload this in implementations of the interface to calculate and update the force applied to the given particle.
+		// Updates the force of each of the given particles. Implementations override this with a loop that calls their own UpdateForce directly, so a batch costs a single virtual call.
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration)							{ for (uint32_t iParticle = 0; iParticle < count; ++iParticle) UpdateForce(particles[iParticle], duration); }
 	};
 	
 	
+	// Holds one force generator and all the particles it applies to, so the generator can be applied to all of them with a single call.
+	struct ParticleForceBatch {
+				ParticleForceGenerator					* ForceGenerator				= 0;
+				::std::vector<Particle*>				Particles						= {};				// A particle added more than once is applied once: the duplicates are removed before the forces are next updated.
+				bool									IsChecked						= true;				// Cleared by Add, so the batch is checked for duplicates before it is next used.
+	};
+
 	// Holds all the force generators and the particles they apply to.
+	// Registrations can be pushed into Registrations one pair at a time, which costs one virtual call per pair, or added with Add, which groups them by generator into batches.
+	// Each batch makes its own pass over its particles, so batching pays off for generators applied to many particles rather than for several generators sharing the same few.
 	struct ParticleForceRegistry {
 		// Keeps track of one force generator and the particle it applies to.
 		struct ParticleForceRegistration {
@@ -26,8 +38,20 @@ namespace cyclone {
 		
 		typedef	std::vector<ParticleForceRegistration>	TRegistry;	
 				TRegistry								Registrations;										// Holds the list of registrations.
-	
-				void									UpdateForces					(double duration);									// Calls all the force generators to update the forces of their corresponding particles.
+				::std::vector<ParticleForceBatch>		Batches							= {};				// Holds the registrations added with Add, grouped by generator.
+				TRegistry								ScheduledRegistrations			= {};				// Holds a copy of the registrations the schedule below was built for, to tell when it has to be rebuilt.
+				::std::vector<uint32_t>					ParticleOrder					= {};				// Holds the indices of the registrations sorted by particle, so the forces of a particle are all applied by the same thread.
+				::std::vector<uint32_t>					ParticleGroups					= {};				// Holds the offset in ParticleOrder where the registrations of each particle begin, followed by the total count.
+
+				void									Add								(Particle *particle, ParticleForceGenerator *generator);	// Registers the generator to apply to the particle, in the batch of the generator. Adding a pair that is already registered has no effect.
+				bool									Remove							(Particle *particle, ParticleForceGenerator *generator);	// Removes a registration added with Add. The order of the batch changes. Returns false if it wasn't found.
+
+				void									UpdateSchedule					();													// Rebuilds the grouping of the registrations by particle if the registrations changed since it was built.
+				void									UpdateForces					(double duration);									// Calls all the force generators to update the forces of their corresponding particles. Each batch costs a single virtual call.
+				// Calls all the force generators from the threads of the given pool. Generators only write the force accumulator of the particle they are called for, so the registrations are split
+				// between the threads by particle, and the given number of particles is taken at a time. Each batch is split in chunks of particles in the same way after the registrations.
+				// The registrations can be changed between calls, but not during one.
+				void									UpdateForces					(double duration, ThreadPool &threads, uint32_t chunkSize);
 	};
 
 	// A force generator that applies a gravitational force. One instance can be used for multiple particles.
@@ -38,6 +62,7 @@ namespace cyclone {
 														ParticleGravity					(const Vector3& gravity)																: Gravity(gravity)																				{}
 
 		virtual	void									UpdateForce						(Particle *particle, double duration);	// Applies the gravitational force to the given particle. 
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies a drag force. One instance can be used for multiple particles.
@@ -49,6 +74,7 @@ namespace cyclone {
 														ParticleDrag					(double k1, double k2)																	: k1(k1), k2(k2)																				{}
 
 		virtual	void									UpdateForce						(Particle *particle, double duration);	// Applies the drag force to the given particle. 
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies a Spring force, where one end is attached to a fixed point in space.
@@ -66,12 +92,14 @@ namespace cyclone {
 				void									Init							(Vector3 *anchor, double springConstant, double restLength);	// Set the spring's properties. 
 
 		virtual	void									UpdateForce						(Particle *particle, double duration);							// Applies the spring force to the given particle.
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies a bungee force, where one end is attached to a fixed point in space.
 	class ParticleAnchoredBungee : public ParticleAnchoredSpring {
 	public:
 		virtual	void									UpdateForce						(Particle *particle, double duration);	// Applies the spring force to the given particle.
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that fakes a stiff spring force, and where one end is attached to a fixed point in space.
@@ -84,6 +112,7 @@ namespace cyclone {
 														ParticleFakeSpring				(Vector3 *anchor, double springConstant, double damping)								: Anchor(anchor), SpringConstant(springConstant), Damping(damping)								{}
 	
 		virtual void									UpdateForce						(Particle *particle, double duration);	// Applies the spring force to the given particle. 
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies a Spring force.
@@ -96,6 +125,7 @@ namespace cyclone {
 														ParticleSpring					(Particle *other, double springConstant, double restLength)								: Other(other), SpringConstant(springConstant), RestLength(restLength)							{}
 
 		virtual void									UpdateForce						(Particle *particle, double duration);						// Applies the spring force to the given particle. 
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 	
 	// A force generator that applies a spring force only when extended.
@@ -108,6 +138,7 @@ namespace cyclone {
 														ParticleBungee					(Particle *other, double springConstant, double restLength)								: Other(other), SpringConstant(springConstant), RestLength(restLength)							{}
 
 		virtual void									UpdateForce						(Particle *particle, double duration);	// Applies the spring force to the given particle.
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 
 	// A force generator that applies a buoyancy force for a plane of liquid parrallel to XZ plane.
@@ -121,6 +152,7 @@ namespace cyclone {
 														ParticleBuoyancy				(double maxDepth, double volume, double waterHeight, double liquidDensity = 1000.0f)	: MaxDepth(maxDepth), Volume(volume), WaterHeight(waterHeight), LiquidDensity(liquidDensity)	{}
 	
 		virtual	void									UpdateForce						(Particle *particle, double duration);	// Applies the buoyancy force to the given particle.
+		virtual	void									ApplyBatch						(Particle * const *particles, uint32_t count, double duration);
 	};
 }
 
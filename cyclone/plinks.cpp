@@ -100,4 +100,97 @@ uint32_t							ParticleRodConstraint::AddContact		(ParticleContact *contact, uin
 	}
 	contact->Restitution				= 0;	// Always use zero restitution (no bounciness)
 	return 1;
-}
\ No newline at end of file
+}
+
+static inline	uint32_t			addLink									(ParticleLinkSet &links, uint32_t particleA, uint32_t particleB, double length, double restitution, PARTICLE_LINK_TYPE type)	{
+	links.ParticleA.push_back(particleA);
+	links.ParticleB.push_back(particleB);
+	links.Length.push_back(length);
+	links.Restitution.push_back(restitution);
+	links.Type.push_back(type);
+	return links.Size() - 1;
+}
+
+uint32_t							ParticleLinkSet::AddCable				(uint32_t particleA, uint32_t particleB, double maxLength, double restitution)		{ return addLink(*this, particleA, particleB, maxLength, restitution, PARTICLE_LINK_TYPE_CABLE); }
+uint32_t							ParticleLinkSet::AddRod					(uint32_t particleA, uint32_t particleB, double length)								{ return addLink(*this, particleA, particleB, length, 0, PARTICLE_LINK_TYPE_ROD); }
+uint32_t							ParticleLinkSet::AddAnchoredCable		(uint32_t particle, const Vector3 &anchor, double maxLength, double restitution)	{ Anchors.push_back(anchor); return addLink(*this, particle, (uint32_t)Anchors.size() - 1, maxLength, restitution, PARTICLE_LINK_TYPE_ANCHORED_CABLE); }
+uint32_t							ParticleLinkSet::AddAnchoredRod			(uint32_t particle, const Vector3 &anchor, double length)							{ Anchors.push_back(anchor); return addLink(*this, particle, (uint32_t)Anchors.size() - 1, length, 0, PARTICLE_LINK_TYPE_ANCHORED_ROD); }
+
+void								ParticleLinkSet::Clear					()																					{
+	ParticleA.clear();
+	ParticleB.clear();
+	Length.clear();
+	Restitution.clear();
+	Type.clear();
+	Anchors.clear();
+}
+
+uint32_t							ParticleLinkSet::AddContact				(ParticleContact *contact, uint32_t limit)									const	{
+	uint32_t								used									= 0;
+	for (uint32_t iLink = 0, linkCount = Size(); iLink < linkCount && used < limit; ++iLink) {
+		const PARTICLE_LINK_TYPE				type									= Type[iLink];
+		const bool								anchored								= type & PARTICLE_LINK_TYPE_ANCHORED_CABLE;
+		::cyclone::Particle						* first									= &Particles[ParticleA[iLink]];
+		::cyclone::Particle						* second								= anchored ? 0 : &Particles[ParticleB[iLink]];
+		Vector3									normal									= (anchored ? Anchors[ParticleB[iLink]] : second->Position) - first->Position;
+		const double							lengthSquared							= normal.squareMagnitude();
+		const double							linkLength								= Length[iLink];
+		if (0 == (type & PARTICLE_LINK_TYPE_ROD) && lengthSquared < linkLength * linkLength)
+			continue;	// Slack cables are the common case, and are skipped without a square root.
+
+		const double							length									= real_sqrt(lengthSquared);
+		const bool								isRod									= 0 != (type & PARTICLE_LINK_TYPE_ROD);
+		if (isRod && length == linkLength)
+			continue;	// Rods at their length need no contact. Taut cables get one with no penetration, as ParticleCable does.
+
+		if (length > 0)
+			normal									*= 1.0 / length;
+		contact->Particle[0]				= first;
+		contact->Particle[1]				= second;
+		if (length > linkLength || !isRod) {	// The contact normal depends on whether we're extending or compressing
+			contact->ContactNormal				= normal;
+			contact->Penetration				= length - linkLength;
+		} else {
+			contact->ContactNormal				= normal * -1;
+			contact->Penetration				= linkLength - length;
+		}
+		contact->Restitution				= Restitution[iLink];
+		++contact;
+		++used;
+	}
+	return used;
+}
+
+void								ParticleLinkSet::Project				(uint32_t iterations, double duration)												{
+	if (duration <= 0)
+		return;
+	const double							inverseDuration							= 1.0 / duration;
+	for (uint32_t iIteration = 0; iIteration < iterations; ++iIteration) {
+		for (uint32_t iLink = 0, linkCount = Size(); iLink < linkCount; ++iLink) {
+			const PARTICLE_LINK_TYPE				type									= Type[iLink];
+			const bool								anchored								= type & PARTICLE_LINK_TYPE_ANCHORED_CABLE;
+			::cyclone::Particle						& first									= Particles[ParticleA[iLink]];
+			::cyclone::Particle						* second								= anchored ? 0 : &Particles[ParticleB[iLink]];
+			const double							inverseMassA							= first.InverseMass;
+			const double							inverseMassB							= anchored ? 0 : second->InverseMass;
+			const double							totalInverseMass						= inverseMassA + inverseMassB;
+			if (totalInverseMass <= 0)
+				continue;
+
+			Vector3									normal									= (anchored ? Anchors[ParticleB[iLink]] : second->Position) - first.Position;
+			const double							lengthSquared							= normal.squareMagnitude();
+			const double							linkLength								= Length[iLink];
+			if ((0 == (type & PARTICLE_LINK_TYPE_ROD) && lengthSquared <= linkLength * linkLength) || 0 == lengthSquared)
+				continue;
+
+			const double							length									= real_sqrt(lengthSquared);
+			const Vector3							correction								= normal * ((length - linkLength) / (length * totalInverseMass));	// Moves the particles together when positive and apart when negative.
+			first.Position							+= correction * inverseMassA;
+			first.Velocity							+= correction * (inverseMassA * inverseDuration);
+			if (second) {
+				second->Position						-= correction * inverseMassB;
+				second->Velocity						-= correction * (inverseMassB * inverseDuration);
+			}
+		}
+	}
+}
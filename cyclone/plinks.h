@@ -3,6 +3,8 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "pcontacts.h"
 
+#include <vector>
+
 #ifndef CYCLONE_PLINKS_H
 #define CYCLONE_PLINKS_H
 
@@ -60,6 +62,39 @@ namespace cyclone {
 		double								Length;	// Holds the length of the rod.
 		virtual uint32_t					AddContact					(ParticleContact *contact, uint32_t limit)					const;	// Fills the given contact structure with the contact needed to keep the rod from extending or compressing.
 	};
+
+	// Identifies the kind of each link of a ParticleLinkSet. The first bit tells rods from cables and the second bit tells links to an anchor point from links between two particles.
+	enum PARTICLE_LINK_TYPE : uint8_t
+		{	PARTICLE_LINK_TYPE_CABLE			= 0	// Keeps two particles from straying further apart than the length of the link.
+		,	PARTICLE_LINK_TYPE_ROD				= 1	// Keeps two particles at exactly the length of the link.
+		,	PARTICLE_LINK_TYPE_ANCHORED_CABLE	= 2	// Keeps a particle from straying further from an anchor point than the length of the link.
+		,	PARTICLE_LINK_TYPE_ANCHORED_ROD		= 3	// Keeps a particle at exactly the length of the link from an anchor point.
+		};
+
+	// Holds any number of cables and rods between the particles of a single array, as flat arrays with one entry per link, so a whole structure is a single contact generator rather than one object per link.
+	// Particles are referred to by their index in the array, and anchored links refer to their anchor point by its index in Anchors.
+	struct ParticleLinkSet : public ParticleContactGenerator {
+		::cyclone::Particle					* Particles					= 0;	// Holds the array the particle indices refer to.
+		::std::vector<uint32_t>				ParticleA					= {};	// Holds the index of the first particle of each link.
+		::std::vector<uint32_t>				ParticleB					= {};	// Holds the index of the second particle of each link, or the index of its anchor point for anchored links.
+		::std::vector<double>				Length						= {};	// Holds the maximum length of each cable and the length of each rod.
+		::std::vector<double>				Restitution					= {};	// Holds the restitution of each link. It is always zero for rods.
+		::std::vector<PARTICLE_LINK_TYPE>	Type						= {};
+		::std::vector<Vector3>				Anchors						= {};	// Holds the anchor points.
+
+		inline	uint32_t					Size						()															const	{ return (uint32_t)Type.size(); }
+		uint32_t							AddCable					(uint32_t particleA, uint32_t particleB, double maxLength, double restitution);	// Adds a cable between two particles and returns the index of the link.
+		uint32_t							AddRod						(uint32_t particleA, uint32_t particleB, double length);	// Adds a rod between two particles and returns the index of the link.
+		uint32_t							AddAnchoredCable			(uint32_t particle, const Vector3 &anchor, double maxLength, double restitution);	// Adds a cable from a particle to a new anchor point and returns the index of the link.
+		uint32_t							AddAnchoredRod				(uint32_t particle, const Vector3 &anchor, double length);	// Adds a rod from a particle to a new anchor point and returns the index of the link.
+		void								Clear						();
+
+		// Generates the contacts for every violated link in a single pass over the arrays, stopping when the limit is reached. The contacts are the same ones the separate cable, rod and constraint classes generate.
+		virtual uint32_t					AddContact					(ParticleContact *contact, uint32_t limit)					const;
+		// Moves the particles of each violated link directly to the length of the link, weighted by their inverse masses, instead of generating contacts for the resolver. The links are visited in order the given number of times.
+		// The velocities are changed as though the particles had moved to the corrected positions during the frame of the given duration, so the links don't drift apart again. Restitution is ignored on this path.
+		void								Project						(uint32_t iterations, double duration);
+	};
 } // namespace cyclone
 
 #endif // CYCLONE_CONTACTS_H
\ No newline at end of file
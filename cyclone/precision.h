@@ -9,6 +9,10 @@
 #ifndef CYCLONE_PRECISION_H
 #define CYCLONE_PRECISION_H
 
+#if defined(CYCLONE_DETERMINISTIC) && (defined(__FAST_MATH__) || defined(_M_FP_FAST))	// Fast math lets the compiler reorder and fuse operations differently in each build, so the same inputs stop giving the same results.
+#	error "CYCLONE_DETERMINISTIC builds need strict floating point: remove -ffast-math or /fp:fast."
+#endif
+
 #define REAL_MAX		DBL_MAX				// Defines the highest value for the real number. 
 #define real_sqrt		sqrt				// Defines the precision of the square root operator. 
 #define real_abs		fabs				// Defines the precision of the absolute magnitude operator. 
@@ -0,0 +1,158 @@
+// Implementation file for the instrumentation of the physics step.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "profile.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+
+using namespace cyclone;
+
+// Holds the measurements of the current frame, added to from any thread, and the ones of the last frame, read by the host.
+static	::std::atomic<uint64_t>			currentScopeTime	[PROFILE_SCOPE_COUNT]		= {};
+static	::std::atomic<uint32_t>			currentScopeCalls	[PROFILE_SCOPE_COUNT]		= {};
+static	::std::atomic<uint64_t>			currentCounters		[PROFILE_COUNTER_COUNT]		= {};
+static	::std::mutex					lastFrameMutex;
+static	FrameStats						lastFrame										= {};
+static	uint64_t						frameCount										= 0;
+
+// Holds the phases recorded by a thread. Only that thread writes it, so the count of written events is published with a release store for WriteTrace to read.
+struct ProfileTraceBuffer {
+	uint32_t								ThreadId										= 0;
+	::std::atomic<uint64_t>					Written											= {0};
+	ProfileEvent							Events	[Profile::TraceCapacity]				= {};
+};
+
+static	::std::atomic<bool>				tracing											= {false};
+static	uint64_t						traceStart										= 0;
+static	::std::mutex					traceBuffersMutex;
+static	::std::vector<::std::unique_ptr<ProfileTraceBuffer>>	traceBuffers;	// Keeps the buffers of the threads that ended, so their phases can still be written.
+static	thread_local ProfileTraceBuffer	* threadTraceBuffer								= 0;
+
+uint64_t								Profile::GetTimestamp					()																{
+	return (uint64_t)::std::chrono::duration_cast<::std::chrono::nanoseconds>(::std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void									Profile::AddTime						(PROFILE_SCOPE scope, uint64_t nanoseconds)						{
+	currentScopeTime	[scope].fetch_add(nanoseconds	, ::std::memory_order_relaxed);
+	currentScopeCalls	[scope].fetch_add(1				, ::std::memory_order_relaxed);
+}
+
+void									Profile::Count							(PROFILE_COUNTER counter, uint64_t value)						{
+	currentCounters[counter].fetch_add(value, ::std::memory_order_relaxed);
+}
+
+FrameStats								Profile::EndFrame						()																{
+	const ::std::lock_guard<::std::mutex>		lock									(lastFrameMutex);
+	FrameStats									ended									= {};
+	ended.Frame								= frameCount++;
+	for (uint32_t iScope = 0; iScope < PROFILE_SCOPE_COUNT; ++iScope) {
+		ended.ScopeTime		[iScope]			= currentScopeTime	[iScope].exchange(0, ::std::memory_order_relaxed);
+		ended.ScopeCalls	[iScope]			= currentScopeCalls	[iScope].exchange(0, ::std::memory_order_relaxed);
+	}
+	for (uint32_t iCounter = 0; iCounter < PROFILE_COUNTER_COUNT; ++iCounter)
+		ended.Counters[iCounter]				= currentCounters[iCounter].exchange(0, ::std::memory_order_relaxed);
+	lastFrame								= ended;
+	return ended;
+}
+
+FrameStats								Profile::GetLastFrame					()																{
+	const ::std::lock_guard<::std::mutex>		lock									(lastFrameMutex);
+	return lastFrame;
+}
+
+void									Profile::StartTrace						()																{
+	const ::std::lock_guard<::std::mutex>		lock									(traceBuffersMutex);
+	for (uint32_t iBuffer = 0; iBuffer < traceBuffers.size(); ++iBuffer)
+		traceBuffers[iBuffer]->Written.store(0, ::std::memory_order_relaxed);
+	traceStart								= GetTimestamp();
+	tracing.store(true, ::std::memory_order_release);
+}
+
+void									Profile::StopTrace						()																{ tracing.store(false, ::std::memory_order_release); }
+
+void									Profile::TraceScope						(PROFILE_SCOPE scope, uint64_t begin, uint64_t end)				{
+	if (!tracing.load(::std::memory_order_relaxed))
+		return;
+	ProfileTraceBuffer							* buffer								= threadTraceBuffer;
+	if (0 == buffer) {
+		const ::std::lock_guard<::std::mutex>		lock									(traceBuffersMutex);
+		traceBuffers.emplace_back(new ProfileTraceBuffer());
+		buffer									= threadTraceBuffer						= traceBuffers.back().get();
+		buffer->ThreadId						= (uint32_t)traceBuffers.size();
+	}
+	const uint64_t								written									= buffer->Written.load(::std::memory_order_relaxed);
+	buffer->Events[written % TraceCapacity]	= {begin, end, scope};
+	buffer->Written.store(written + 1, ::std::memory_order_release);
+}
+
+bool									Profile::WriteTrace						(const char *fileName)											{
+	FILE										* file									= fopen(fileName, "w");
+	if (0 == file)
+		return false;
+
+	const ::std::lock_guard<::std::mutex>		lock									(traceBuffersMutex);
+	::std::vector<ProfileEvent>					events;
+	fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+	bool										first									= true;
+	for (uint32_t iBuffer = 0; iBuffer < traceBuffers.size(); ++iBuffer) {
+		const ProfileTraceBuffer					& buffer								= *traceBuffers[iBuffer];
+		const uint64_t								written									= buffer.Written.load(::std::memory_order_acquire);
+		if (0 == written)
+			continue;
+		fprintf(file, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"Thread %u\"}}", first ? "" : ",", buffer.ThreadId, buffer.ThreadId);
+		first									= false;
+
+		// The phases are recorded when they end, so the inner ones come before the outer ones. Viewers nest them more reliably when the outer ones come first.
+		const uint64_t								oldest									= (written > TraceCapacity) ? written - TraceCapacity : 0;
+		events.clear();
+		for (uint64_t iEvent = oldest; iEvent < written; ++iEvent)
+			events.push_back(buffer.Events[iEvent % TraceCapacity]);
+		::std::sort(events.begin(), events.end(), [](const ProfileEvent &a, const ProfileEvent &b) { return (a.Begin != b.Begin) ? a.Begin < b.Begin : a.End > b.End; });
+		for (uint32_t iEvent = 0; iEvent < events.size(); ++iEvent) {
+			const ProfileEvent							& event									= events[iEvent];
+			const uint64_t								begin									= (event.Begin > traceStart) ? event.Begin - traceStart : 0;
+			fprintf(file, ",\n{\"name\": \"%s\", \"cat\": \"cyclone\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}"
+				, GetScopeName(event.Scope), begin * 1e-3, (event.End - event.Begin) * 1e-3, buffer.ThreadId
+				);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return 0 == fclose(file);
+}
+
+const char*								Profile::GetScopeName					(PROFILE_SCOPE scope)											{
+	static const char							* names	[PROFILE_SCOPE_COUNT]			=
+		{ "step"
+		, "start_frame"
+		, "integrate"
+		, "generate_contacts"
+		, "broad_phase"
+		, "narrow_phase"
+		, "narrow_phase_batch"
+		, "resolve_prepare"
+		, "resolve_positions"
+		, "resolve_velocities"
+		, "parallel_chunk"
+		};
+	return (scope < PROFILE_SCOPE_COUNT) ? names[scope] : "unknown";
+}
+
+const char*								Profile::GetCounterName					(PROFILE_COUNTER counter)										{
+	static const char							* names	[PROFILE_COUNTER_COUNT]			=
+		{ "contacts_generated"
+		, "pairs_tested"
+		, "pairs_skipped"
+		, "generators_skipped"
+		, "awake_bodies"
+		, "islands"
+		, "velocity_iterations"
+		, "position_iterations"
+		};
+	return (counter < PROFILE_COUNTER_COUNT) ? names[counter] : "unknown";
+}
@@ -0,0 +1,103 @@
+// This file contains the instrumentation of the physics step: timers around its phases and counters of the work it does, collected into statistics for each frame that the host can read, and a recorder of the timed phases that writes them as a timeline.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "precision.h"
+
+#ifndef CYCLONE_PROFILE_H
+#define CYCLONE_PROFILE_H
+
+namespace cyclone {
+	// Identifies the timed phases of the step.
+	enum PROFILE_SCOPE : uint8_t
+		{	PROFILE_SCOPE_STEP					= 0	// Covers a whole step of a world, or of the host's update.
+		,	PROFILE_SCOPE_START_FRAME
+		,	PROFILE_SCOPE_INTEGRATE
+		,	PROFILE_SCOPE_GENERATE_CONTACTS
+		,	PROFILE_SCOPE_BROAD_PHASE
+		,	PROFILE_SCOPE_NARROW_PHASE
+		,	PROFILE_SCOPE_NARROW_PHASE_BATCH		// Covers the test of a run of pairs of the same shapes, or of a shape against a half-space, inside the narrow phase.
+		,	PROFILE_SCOPE_RESOLVE_PREPARE
+		,	PROFILE_SCOPE_RESOLVE_POSITIONS
+		,	PROFILE_SCOPE_RESOLVE_VELOCITIES
+		,	PROFILE_SCOPE_PARALLEL_CHUNK			// Covers a chunk of a job run by the thread pool, on whichever thread took it.
+		,	PROFILE_SCOPE_COUNT
+		};
+
+	// Identifies the counted quantities of the step.
+	enum PROFILE_COUNTER : uint8_t
+		{	PROFILE_COUNTER_CONTACTS_GENERATED	= 0
+		,	PROFILE_COUNTER_PAIRS_TESTED			// Counts the pairs of primitives, and of primitives and half-spaces, given to the fine grained tests.
+		,	PROFILE_COUNTER_PAIRS_SKIPPED			// Counts the pairs, counted like the tested ones, that a collision world didn't test because the contact array was full. Each of them may have lost contacts.
+		,	PROFILE_COUNTER_GENERATORS_SKIPPED		// Counts the contact generators a world didn't call because the contact array was full.
+		,	PROFILE_COUNTER_AWAKE_BODIES
+		,	PROFILE_COUNTER_ISLANDS					// Counts the groups of awake bodies connected by contacts, as seen by the resolver.
+		,	PROFILE_COUNTER_VELOCITY_ITERATIONS
+		,	PROFILE_COUNTER_POSITION_ITERATIONS
+		,	PROFILE_COUNTER_COUNT
+		};
+
+	// Holds the measurements of one frame.
+	struct FrameStats {
+		uint64_t							Frame									= 0;	// Holds the number of frames ended before this one.
+		uint64_t							ScopeTime	[PROFILE_SCOPE_COUNT]		= {};	// Holds the total time spent in each phase, in nanoseconds. Phases run by several threads at once add up the time of every thread.
+		uint32_t							ScopeCalls	[PROFILE_SCOPE_COUNT]		= {};	// Holds the number of times each phase was entered.
+		uint64_t							Counters	[PROFILE_COUNTER_COUNT]		= {};
+	};
+
+	// Holds a phase recorded into the trace, with its times in nanoseconds.
+	struct ProfileEvent {
+		uint64_t							Begin									= 0;
+		uint64_t							End										= 0;
+		PROFILE_SCOPE						Scope									= PROFILE_SCOPE_COUNT;
+	};
+
+	// Collects the measurements of the current frame. The measurements are made by the engine through the macros below, which only do something when CYCLONE_PROFILE is defined for the whole build.
+	// Without it they expand to nothing and don't evaluate their arguments, so the instrumentation costs nothing. The functions here are always available, and the statistics are all zero without it.
+	// Measurements can be added from any thread. The host calls EndFrame once per frame, after the step, to publish the measurements of the frame and start the next one.
+	// Between StartTrace and StopTrace every timed phase is also recorded into a ring buffer of the thread that ran it, which keeps the last TraceCapacity phases of the thread. Recording takes no lock: each buffer is only written by its own thread, and only
+	// the first recording of a thread locks, to add its buffer to the list. WriteTrace writes the buffers as Chrome trace JSON, which trace viewers such as Perfetto open as a timeline with a track for each thread and the phases nested in each other.
+	// StartTrace, StopTrace and WriteTrace must be called between steps, while no thread is running a timed phase.
+	struct Profile {
+		static constexpr	uint32_t		TraceCapacity							= 1 << 16;
+
+		static	uint64_t					GetTimestamp							();	// Returns the time of a monotonic clock, in nanoseconds.
+		static	void						AddTime									(PROFILE_SCOPE scope, uint64_t nanoseconds);
+		static	void						Count									(PROFILE_COUNTER counter, uint64_t value);
+		static	FrameStats					EndFrame								();	// Publishes the measurements of the current frame, returns them and starts a new frame.
+		static	FrameStats					GetLastFrame							();	// Returns the measurements published by the last call to EndFrame.
+
+		static	void						StartTrace								();	// Discards the recorded phases and starts recording.
+		static	void						StopTrace								();
+		static	void						TraceScope								(PROFILE_SCOPE scope, uint64_t begin, uint64_t end);	// Records the given phase into the buffer of the calling thread, if recording.
+		static	bool						WriteTrace								(const char *fileName);	// Returns false if the file couldn't be written.
+
+		static	const char*					GetScopeName							(PROFILE_SCOPE scope);
+		static	const char*					GetCounterName							(PROFILE_COUNTER counter);
+	};
+
+	// Adds the time between its construction and its destruction to the given phase, and records it into the trace.
+	struct ProfileScope {
+		const PROFILE_SCOPE					Scope;
+		const uint64_t						Start;
+
+		inline								ProfileScope							(PROFILE_SCOPE scope)							: Scope(scope), Start(Profile::GetTimestamp())	{}
+		inline								~ProfileScope							()												{
+			const uint64_t							end										= Profile::GetTimestamp();
+			Profile::AddTime	(Scope, end - Start);
+			Profile::TraceScope	(Scope, Start, end);
+		}
+	};
+} // namespace cyclone
+
+#define CYCLONE_PROFILE_CONCAT_(a, b)		a##b
+#define CYCLONE_PROFILE_CONCAT(a, b)		CYCLONE_PROFILE_CONCAT_(a, b)
+
+#ifdef CYCLONE_PROFILE
+#	define CYCLONE_PROFILE_SCOPE(scope)				const ::cyclone::ProfileScope CYCLONE_PROFILE_CONCAT(profileScope, __LINE__)(scope)	// Times the rest of the enclosing block as the given phase.
+#	define CYCLONE_PROFILE_COUNT(counter, value)	::cyclone::Profile::Count(counter, value)												// Adds the given value to the given counter.
+#else
+#	define CYCLONE_PROFILE_SCOPE(scope)				((void)0)
+#	define CYCLONE_PROFILE_COUNT(counter, value)	((void)0)
+#endif
+
+#endif // CYCLONE_PROFILE_H
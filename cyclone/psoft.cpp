@@ -0,0 +1,278 @@
+// Implementation file for the soft bodies.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "psoft.h"
+
+using namespace cyclone;
+
+static constexpr	uint32_t			MaxParallelColors						= 64;	// Constraints that can't be given one of these colors go to a last group, solved on the calling thread.
+
+uint32_t								SoftDistanceConstraints::Add			(uint32_t particleA, uint32_t particleB, double restLength, double compliance)							{
+	ParticleA	.push_back(particleA);
+	ParticleB	.push_back(particleB);
+	RestLength	.push_back(restLength);
+	Compliance	.push_back(compliance);
+	Lambda		.push_back(0);
+	return Size() - 1;
+}
+
+uint32_t								SoftVolumeConstraints::Add				(const uint32_t particles[4], double restVolume, double compliance)										{
+	Particles	.insert(Particles.end(), particles, particles + 4);
+	RestVolume	.push_back(restVolume);
+	Compliance	.push_back(compliance);
+	Lambda		.push_back(0);
+	return Size() - 1;
+}
+
+static inline	double					tetrahedronVolume						(const Vector3 &a, const Vector3 &b, const Vector3 &c, const Vector3 &d)								{ return ((b - a) % (c - a)) * (d - a) * (1.0 / 6); }
+
+uint32_t								SoftBody::AddStretch					(uint32_t particleA, uint32_t particleB, double compliance)												{
+	IsColored								= false;
+	return Stretch.Add(particleA, particleB, (Particles.GetPosition(particleA) - Particles.GetPosition(particleB)).magnitude(), compliance);
+}
+
+uint32_t								SoftBody::AddBending					(uint32_t particleA, uint32_t particleB, double compliance)												{
+	IsColored								= false;
+	return Bending.Add(particleA, particleB, (Particles.GetPosition(particleA) - Particles.GetPosition(particleB)).magnitude(), compliance);
+}
+
+uint32_t								SoftBody::AddTetrahedron				(const uint32_t particles[4], double compliance)															{
+	IsColored								= false;
+	const double								volume									= tetrahedronVolume(Particles.GetPosition(particles[0]), Particles.GetPosition(particles[1]), Particles.GetPosition(particles[2]), Particles.GetPosition(particles[3]));
+	return Volume.Add(particles, volume, compliance);
+}
+
+uint32_t								SoftBody::AddCloth						(const Vector3 &corner, const Vector3 &edgeU, const Vector3 &edgeV, uint32_t countU, uint32_t countV, double mass, double stretchCompliance, double bendingCompliance, uint16_t dampingClass)	{
+	if (0 == Particles.Damping.Size())
+		dampingClass							= Particles.AddDampingClass(1);
+	const uint32_t								first									= Particles.Size();
+	const uint32_t								particleCount							= countU * countV;
+	const double								inverseMass								= (mass > 0 && particleCount) ? particleCount / mass : 0;
+	Particles.Reserve(first + particleCount);
+	for (uint32_t v = 0; v < countV; ++v)
+		for (uint32_t u = 0; u < countU; ++u)
+			Particles.Add(corner + edgeU * u + edgeV * v, {}, Vector3::GRAVITY, inverseMass, dampingClass);
+
+	for (uint32_t v = 0; v < countV; ++v) {
+		for (uint32_t u = 0; u < countU; ++u) {
+			const uint32_t								particle								= first + v * countU + u;
+			if (u + 1 < countU)					AddStretch(particle, particle + 1, stretchCompliance);
+			if (v + 1 < countV)					AddStretch(particle, particle + countU, stretchCompliance);
+			if (u + 1 < countU && v + 1 < countV) {
+				AddStretch(particle, particle + countU + 1, stretchCompliance);
+				AddStretch(particle + 1, particle + countU, stretchCompliance);
+			}
+			if (u + 2 < countU)					AddBending(particle, particle + 2, bendingCompliance);
+			if (v + 2 < countV)					AddBending(particle, particle + countU * 2, bendingCompliance);
+		}
+	}
+	return first;
+}
+
+// Gives each constraint the lowest color not used yet by any of its particles, and returns the constraints sorted by color with the offsets of each color.
+// The particles of each constraint are given one after the other, particlesPerConstraint at a time.
+static			void					colorConstraints						(const ::std::vector<uint32_t> &particles, uint32_t particlesPerConstraint, uint32_t particleCount, ::std::vector<uint32_t> &order, ::std::vector<uint32_t> &offsets)	{
+	const uint32_t								constraintCount							= (uint32_t)(particles.size() / particlesPerConstraint);
+	::std::vector<uint64_t>						usedColors								(particleCount, 0);
+	::std::vector<uint32_t>						colors									(constraintCount);
+	uint32_t									colorCount								= 0;
+	for (uint32_t iConstraint = 0; iConstraint < constraintCount; ++iConstraint) {
+		const uint32_t								* constraintParticles					= &particles[iConstraint * particlesPerConstraint];
+		uint64_t									used									= 0;
+		for (uint32_t iParticle = 0; iParticle < particlesPerConstraint; ++iParticle)
+			used									|= usedColors[constraintParticles[iParticle]];
+		uint32_t									color									= 0;
+		while (color < MaxParallelColors && (used & (1ULL << color)))
+			++color;
+		if (color < MaxParallelColors)
+			for (uint32_t iParticle = 0; iParticle < particlesPerConstraint; ++iParticle)
+				usedColors[constraintParticles[iParticle]]	|= 1ULL << color;
+		colors[iConstraint]						= color;
+		if (color >= colorCount)
+			colorCount								= color + 1;
+	}
+	offsets.assign(colorCount + 1, 0);
+	for (uint32_t iConstraint = 0; iConstraint < constraintCount; ++iConstraint)
+		++offsets[colors[iConstraint] + 1];
+	for (uint32_t iColor = 0; iColor < colorCount; ++iColor)
+		offsets[iColor + 1]						+= offsets[iColor];
+	::std::vector<uint32_t>						next									(offsets.begin(), offsets.end() - 1);
+	order.resize(constraintCount);
+	for (uint32_t iConstraint = 0; iConstraint < constraintCount; ++iConstraint)
+		order[next[colors[iConstraint]]++]		= iConstraint;
+}
+
+template<typename _tValue>
+static			void					permute									(::std::vector<_tValue> &values, const ::std::vector<uint32_t> &order, uint32_t stride = 1)				{
+	::std::vector<_tValue>						sorted									(values.size());
+	for (uint32_t iSorted = 0; iSorted < order.size(); ++iSorted)
+		for (uint32_t iValue = 0; iValue < stride; ++iValue)
+			sorted[iSorted * stride + iValue]		= values[order[iSorted] * stride + iValue];
+	values.swap(sorted);
+}
+
+static			void					colorDistances							(SoftDistanceConstraints &constraints, uint32_t particleCount)											{
+	::std::vector<uint32_t>						particles								(constraints.Size() * 2);
+	for (uint32_t iConstraint = 0; iConstraint < constraints.Size(); ++iConstraint) {
+		particles[iConstraint * 2]				= constraints.ParticleA[iConstraint];
+		particles[iConstraint * 2 + 1]			= constraints.ParticleB[iConstraint];
+	}
+	::std::vector<uint32_t>						order;
+	colorConstraints(particles, 2, particleCount, order, constraints.ColorOffsets);
+	permute(constraints.ParticleA	, order);
+	permute(constraints.ParticleB	, order);
+	permute(constraints.RestLength	, order);
+	permute(constraints.Compliance	, order);
+	constraints.Lambda.assign(constraints.Size(), 0);
+}
+
+void									SoftBody::Color							()																										{
+	colorDistances(Stretch, Particles.Size());
+	colorDistances(Bending, Particles.Size());
+	::std::vector<uint32_t>						order;
+	colorConstraints(Volume.Particles, 4, Particles.Size(), order, Volume.ColorOffsets);
+	permute(Volume.Particles	, order, 4);
+	permute(Volume.RestVolume	, order);
+	permute(Volume.Compliance	, order);
+	Volume.Lambda.assign(Volume.Size(), 0);
+	IsColored								= true;
+}
+
+static			void					solveDistances							(SoftDistanceConstraints &constraints, ParticleSystem &particles, uint32_t begin, uint32_t end, double inverseDurationSquared)	{
+	for (uint32_t iConstraint = begin; iConstraint < end; ++iConstraint) {
+		const uint32_t								a										= constraints.ParticleA[iConstraint];
+		const uint32_t								b										= constraints.ParticleB[iConstraint];
+		const double								inverseMassA							= particles.InverseMass[a];
+		const double								inverseMassB							= particles.InverseMass[b];
+		const double								alpha									= constraints.Compliance[iConstraint] * inverseDurationSquared;
+		const double								totalInverseMass						= inverseMassA + inverseMassB + alpha;
+		const Vector3								offset									= particles.GetPosition(a) - particles.GetPosition(b);
+		const double								length									= offset.magnitude();
+		if (0 == totalInverseMass || 0 == length)
+			continue;
+		const double								error									= length - constraints.RestLength[iConstraint];
+		const double								deltaLambda								= (-error - alpha * constraints.Lambda[iConstraint]) / totalInverseMass;
+		constraints.Lambda[iConstraint]			+= deltaLambda;
+		const Vector3								correction								= offset * (deltaLambda / length);
+		particles.SetPosition(a, particles.GetPosition(a) + correction * inverseMassA);
+		particles.SetPosition(b, particles.GetPosition(b) - correction * inverseMassB);
+	}
+}
+
+static			void					solveVolumes							(SoftVolumeConstraints &constraints, ParticleSystem &particles, uint32_t begin, uint32_t end, double inverseDurationSquared)	{
+	for (uint32_t iConstraint = begin; iConstraint < end; ++iConstraint) {
+		const uint32_t								* indices								= &constraints.Particles[iConstraint * 4];
+		const Vector3								positions	[4]							= {particles.GetPosition(indices[0]), particles.GetPosition(indices[1]), particles.GetPosition(indices[2]), particles.GetPosition(indices[3])};
+		Vector3										gradients	[4];
+		gradients[1]							= ((positions[2] - positions[0]) % (positions[3] - positions[0])) * (1.0 / 6);
+		gradients[2]							= ((positions[3] - positions[0]) % (positions[1] - positions[0])) * (1.0 / 6);
+		gradients[3]							= ((positions[1] - positions[0]) % (positions[2] - positions[0])) * (1.0 / 6);
+		gradients[0]							= (gradients[1] + gradients[2] + gradients[3]) * -1;
+		const double								alpha									= constraints.Compliance[iConstraint] * inverseDurationSquared;
+		double										weight									= alpha;
+		for (uint32_t iCorner = 0; iCorner < 4; ++iCorner)
+			weight									+= particles.InverseMass[indices[iCorner]] * gradients[iCorner].squareMagnitude();
+		if (0 == weight)
+			continue;
+		const double								error									= gradients[3] * (positions[3] - positions[0]) - constraints.RestVolume[iConstraint];
+		const double								deltaLambda								= (-error - alpha * constraints.Lambda[iConstraint]) / weight;
+		constraints.Lambda[iConstraint]			+= deltaLambda;
+		for (uint32_t iCorner = 0; iCorner < 4; ++iCorner)
+			particles.SetPosition(indices[iCorner], positions[iCorner] + gradients[iCorner] * (deltaLambda * particles.InverseMass[indices[iCorner]]));
+	}
+}
+
+// Solves each color of constraints in turn. The constraints of a color share no particle, so they are split between the threads. The last group is solved on the calling thread if it holds the constraints that couldn't be colored.
+static			void					solveGroups								(ThreadPool *threads, uint32_t chunkSize, const ::std::vector<uint32_t> &offsets, const ::std::function<void(uint32_t, uint32_t)> &solve)	{
+	for (uint32_t iColor = 0; iColor + 1 < offsets.size(); ++iColor) {
+		const uint32_t								begin									= offsets[iColor];
+		const uint32_t								end										= offsets[iColor + 1];
+		if (0 == threads || iColor >= MaxParallelColors)
+			solve(begin, end);
+		else
+			threads->ParallelFor(end - begin, chunkSize, [&solve, begin](uint32_t first, uint32_t last) { solve(begin + first, begin + last); });
+	}
+}
+
+void									SoftBody::Step							(double duration)																						{
+	if (duration <= 0)
+		return;
+	if (!IsColored)
+		Color();
+	const uint32_t								particleCount							= Particles.Size();
+	if (!IsAwake) {
+		for (uint32_t iParticle = 0; iParticle < particleCount && !IsAwake; ++iParticle)
+			if (Particles.ForceX[iParticle] || Particles.ForceY[iParticle] || Particles.ForceZ[iParticle])
+				SetAwake(true);
+		if (!IsAwake)
+			return;
+	}
+
+	// Each substep is a whole step of the method with a fraction of the duration. Substeps make stiff and heavily loaded bodies converge much better than the same number of extra iterations.
+	const uint32_t								substeps								= Substeps ? Substeps : 1;
+	const double								substepDuration							= duration / substeps;
+	const double								inverseDuration							= 1.0 / substepDuration;
+	const double								inverseDurationSquared					= inverseDuration * inverseDuration;
+	const ::std::function<void(uint32_t, uint32_t)>	solveStretch						= [this, inverseDurationSquared](uint32_t begin, uint32_t end) { solveDistances(Stretch, Particles, begin, end, inverseDurationSquared); };
+	const ::std::function<void(uint32_t, uint32_t)>	solveBending						= [this, inverseDurationSquared](uint32_t begin, uint32_t end) { solveDistances(Bending, Particles, begin, end, inverseDurationSquared); };
+	const ::std::function<void(uint32_t, uint32_t)>	solveVolume							= [this, inverseDurationSquared](uint32_t begin, uint32_t end) { solveVolumes(Volume, Particles, begin, end, inverseDurationSquared); };
+	double										fastestMotion							= 0;
+	Particles.UpdateDampingFactors(substepDuration);
+	for (uint32_t iSubstep = 0; iSubstep < substeps; ++iSubstep) {
+		// Move the particles freely, keeping their positions to find the velocities from at the end.
+		PreviousX								= Particles.PositionX;
+		PreviousY								= Particles.PositionY;
+		PreviousZ								= Particles.PositionZ;
+		for (uint32_t iParticle = 0; iParticle < particleCount; ++iParticle) {
+			const double								inverseMass								= Particles.InverseMass[iParticle];
+			const bool									moves									= inverseMass > 0;
+			const double								step									= moves ? substepDuration : 0;
+			const double								damping									= moves ? Particles.Damping.GetFactor(Particles.DampingClass[iParticle]) : 1;
+			const Vector3								velocity								= (Particles.GetVelocity(iParticle) + (Particles.GetAcceleration(iParticle) + Particles.GetForce(iParticle) * inverseMass) * step) * damping;
+			Particles.SetVelocity(iParticle, velocity);
+			Particles.SetPosition(iParticle, Particles.GetPosition(iParticle) + velocity * step);
+		}
+
+		// Move the particles back into shape.
+		Stretch	.Lambda.assign(Stretch	.Size(), 0);
+		Bending	.Lambda.assign(Bending	.Size(), 0);
+		Volume	.Lambda.assign(Volume	.Size(), 0);
+		for (uint32_t iIteration = 0; iIteration < Iterations; ++iIteration) {
+			solveGroups(Threads, ConstraintsPerChunk, Stretch	.ColorOffsets, solveStretch);
+			solveGroups(Threads, ConstraintsPerChunk, Bending	.ColorOffsets, solveBending);
+			solveGroups(Threads, ConstraintsPerChunk, Volume	.ColorOffsets, solveVolume);
+		}
+
+		// The velocities are the ones that would have taken the particles to their corrected positions.
+		fastestMotion							= 0;
+		for (uint32_t iParticle = 0; iParticle < particleCount; ++iParticle) {
+			const Vector3								velocity								= (Particles.GetPosition(iParticle) - Vector3{PreviousX[iParticle], PreviousY[iParticle], PreviousZ[iParticle]}) * inverseDuration;
+			Particles.SetVelocity(iParticle, velocity);
+			const double								motion									= velocity.squareMagnitude();
+			if (motion > fastestMotion)
+				fastestMotion							= motion;
+		}
+	}
+
+	Particles.ClearForces();	// Only now, as the forces act through every substep, like they would through a single step of the whole duration.
+
+	if (CanSleep) {	// Same test as for rigid bodies, on the fastest particle of the last substep.
+		const double								bias									= real_pow(0.5, duration);
+		Motion									= bias * Motion + (1 - bias) * fastestMotion;
+		if (Motion < sleepEpsilon)
+			SetAwake(false);
+		else if (Motion > 10 * sleepEpsilon)
+			Motion									= 10 * sleepEpsilon;
+	}
+}
+
+void									SoftBody::SetAwake						(bool awake)																							{
+	if (awake) {
+		IsAwake									= true;
+		Motion									= sleepEpsilon * 2.0f;	// Add a bit of motion to avoid it falling asleep immediately.
+	} else {
+		IsAwake									= false;
+		for (uint32_t iParticle = 0; iParticle < Particles.Size(); ++iParticle)
+			Particles.SetVelocity(iParticle, {});
+	}
+}
@@ -0,0 +1,82 @@
+// This file contains the soft bodies: cloth and deformable solids made of particles held together by position based constraints.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "psystem.h"
+#include "parallel.h"
+
+#include <vector>
+
+#ifndef CYCLONE_PSOFT_H
+#define CYCLONE_PSOFT_H
+
+namespace cyclone {
+	// Holds a set of constraints on pairs of particles: each pair is kept at its rest length.
+	// Compliance is the inverse of the stiffness of each constraint, in metres per newton. Zero makes a constraint rigid, larger values make it stretch under load, independently of the number of iterations and of the duration of the step.
+	struct SoftDistanceConstraints {
+		typedef	::std::vector<double>		TReals;
+
+		::std::vector<uint32_t>				ParticleA				= {};
+		::std::vector<uint32_t>				ParticleB				= {};
+		TReals								RestLength				= {};
+		TReals								Compliance				= {};
+		TReals								Lambda					= {};	// Holds the total impulse applied by each constraint during the current step.
+		::std::vector<uint32_t>				ColorOffsets			= {};	// Holds the index of the first constraint of each color, followed by the number of constraints.
+
+		inline	uint32_t					Size					()															const	{ return (uint32_t)RestLength.size(); }
+		uint32_t							Add						(uint32_t particleA, uint32_t particleB, double restLength, double compliance);
+	};
+
+	// Holds a set of constraints on groups of four particles: the volume of each tetrahedron is kept at its rest volume. The volume is signed, so a tetrahedron can't be turned inside out.
+	struct SoftVolumeConstraints {
+		typedef	::std::vector<double>		TReals;
+
+		::std::vector<uint32_t>				Particles				= {};	// Holds the four particles of each tetrahedron, one after the other.
+		TReals								RestVolume				= {};
+		TReals								Compliance				= {};	// Holds the inverse of the stiffness of each constraint, in cubic metres per newton.
+		TReals								Lambda					= {};
+		::std::vector<uint32_t>				ColorOffsets			= {};
+
+		inline	uint32_t					Size					()															const	{ return (uint32_t)RestVolume.size(); }
+		uint32_t							Add						(const uint32_t particles[4], double restVolume, double compliance);
+	};
+
+	// Holds a cloth or a deformable solid and simulates it with extended position based dynamics: the particles are moved freely for the whole step, and the constraints then move them back into shape.
+	// Each step runs a fixed number of iterations over the constraints, so its cost doesn't depend on how the body is deformed. The constraints are split by a graph coloring into groups that share no particle,
+	// and the constraints of a group are solved at the same time on the thread pool, if there is one. The groups are solved one after the other.
+	// Bending constraints are distance constraints kept apart from the stretch ones so they can have their own compliance, which lets cloth fold easily while resisting stretch.
+	// The particles are stored in their own system, which this body integrates. Forces can be applied to it like to any other particle system before calling Step.
+	struct SoftBody {
+		ParticleSystem						Particles				= {};
+		SoftDistanceConstraints				Stretch					= {};
+		SoftDistanceConstraints				Bending					= {};
+		SoftVolumeConstraints				Volume					= {};
+		ParticleSystem::TReals				PreviousX				= {};	// Holds the positions of the particles at the start of the step, from which the velocities are found.
+		ParticleSystem::TReals				PreviousY				= {};
+		ParticleSystem::TReals				PreviousZ				= {};
+		ThreadPool							* Threads				= 0;	// Holds the thread pool used to solve the constraints. The body doesn't own it. If null, the constraints are solved on the calling thread.
+		uint32_t							ConstraintsPerChunk		= 256;	// Holds the number of constraints of a group given to a thread at a time.
+		uint32_t							Iterations				= 8;	// Holds the number of times the constraints are solved in each substep.
+		uint32_t							Substeps				= 1;	// Holds the number of parts each step is split into. Each substep integrates the particles and solves the constraints again.
+		double								Motion					= sleepEpsilon * 2;	// Holds the recency weighted largest squared speed of the particles, to tell when the body can be put to sleep.
+		bool								IsAwake					= true;
+		bool								CanSleep				= true;
+		bool								IsColored				= false;	// Cleared when constraints are added, so the next step colors them again.
+
+		// Adds a rectangular cloth of countU by countV particles, starting at the given corner, with the given offsets between neighbouring particles. There are stretch constraints along the edges and the diagonals of each cell,
+		// and bending constraints between the particles two apart along each row and column. The mass is spread evenly between the particles. Returns the index of the first particle; the rest follow row by row along edgeU.
+		// Without damping classes in Particles, a class with no damping is added for the cloth.
+		uint32_t							AddCloth				(const Vector3 &corner, const Vector3 &edgeU, const Vector3 &edgeV, uint32_t countU, uint32_t countV, double mass, double stretchCompliance, double bendingCompliance, uint16_t dampingClass = 0);
+		// Adds a distance constraint at the current distance between the given particles.
+		uint32_t							AddStretch				(uint32_t particleA, uint32_t particleB, double compliance);
+		uint32_t							AddBending				(uint32_t particleA, uint32_t particleB, double compliance);
+		// Adds a tetrahedron at its current volume. The particles should be ordered so the volume is positive, with the fourth particle on the side the first three wind anticlockwise around.
+		uint32_t							AddTetrahedron			(const uint32_t particles[4], double compliance);
+
+		void								Color					();	// Sorts the constraints into groups that share no particle. The indices of the constraints change. This is done by Step when constraints have been added.
+		// Moves the body forward in time by the given duration and clears the forces of its particles. Sleeping bodies don't move, and are woken up by any force on their particles.
+		void								Step					(double duration);
+		void								SetAwake				(bool awake = true);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_PSOFT_H
@@ -0,0 +1,135 @@
+// Implementation file for the particle system.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "psystem.h"
+
+#include <assert.h>
+
+using namespace cyclone;
+
+uint32_t								ParticleSystem::Add						(const Vector3 &position, const Vector3 &velocity, const Vector3 &acceleration, double inverseMass, uint16_t dampingClass)	{
+	assert(dampingClass < Damping.Size() && "The damping class doesn't exist, or the damping table was full when it was asked for.");
+	PositionX		.push_back(position.x);
+	PositionY		.push_back(position.y);
+	PositionZ		.push_back(position.z);
+	VelocityX		.push_back(velocity.x);
+	VelocityY		.push_back(velocity.y);
+	VelocityZ		.push_back(velocity.z);
+	AccelerationX	.push_back(acceleration.x);
+	AccelerationY	.push_back(acceleration.y);
+	AccelerationZ	.push_back(acceleration.z);
+	ForceX			.push_back(0);
+	ForceY			.push_back(0);
+	ForceZ			.push_back(0);
+	InverseMass		.push_back(inverseMass);
+	DampingClass	.push_back(dampingClass);
+	return Size() - 1;
+}
+
+template<typename _tValue>
+static inline	void					removeSwap								(::std::vector<_tValue> &values, uint32_t index)														{
+	values[index]							= values.back();
+	values.pop_back();
+}
+
+void									ParticleSystem::Remove					(uint32_t index)																						{
+	if (index >= Size())
+		return;
+	removeSwap(PositionX		, index);
+	removeSwap(PositionY		, index);
+	removeSwap(PositionZ		, index);
+	removeSwap(VelocityX		, index);
+	removeSwap(VelocityY		, index);
+	removeSwap(VelocityZ		, index);
+	removeSwap(AccelerationX	, index);
+	removeSwap(AccelerationY	, index);
+	removeSwap(AccelerationZ	, index);
+	removeSwap(ForceX			, index);
+	removeSwap(ForceY			, index);
+	removeSwap(ForceZ			, index);
+	removeSwap(InverseMass		, index);
+	removeSwap(DampingClass		, index);
+}
+
+void									ParticleSystem::Clear					()																										{
+	PositionX		.clear(); PositionY		.clear(); PositionZ		.clear();
+	VelocityX		.clear(); VelocityY		.clear(); VelocityZ		.clear();
+	AccelerationX	.clear(); AccelerationY	.clear(); AccelerationZ	.clear();
+	ForceX			.clear(); ForceY		.clear(); ForceZ		.clear();
+	InverseMass		.clear();
+	DampingClass	.clear();
+}
+
+void									ParticleSystem::Reserve					(uint32_t count)																						{
+	PositionX		.reserve(count); PositionY		.reserve(count); PositionZ		.reserve(count);
+	VelocityX		.reserve(count); VelocityY		.reserve(count); VelocityZ		.reserve(count);
+	AccelerationX	.reserve(count); AccelerationY	.reserve(count); AccelerationZ	.reserve(count);
+	ForceX			.reserve(count); ForceY			.reserve(count); ForceZ			.reserve(count);
+	InverseMass		.reserve(count);
+	DampingClass	.reserve(count);
+}
+
+void									ParticleSystem::Resize					(uint32_t count)																						{
+	PositionX		.resize(count); PositionY		.resize(count); PositionZ		.resize(count);
+	VelocityX		.resize(count); VelocityY		.resize(count); VelocityZ		.resize(count);
+	AccelerationX	.resize(count); AccelerationY	.resize(count); AccelerationZ	.resize(count);
+	ForceX			.resize(count); ForceY			.resize(count); ForceZ			.resize(count);
+	InverseMass		.resize(count);
+	DampingClass	.resize(count);
+}
+
+void									ParticleSystem::Move					(uint32_t from, uint32_t to)																			{
+	PositionX		[to] = PositionX		[from]; PositionY		[to] = PositionY		[from]; PositionZ		[to] = PositionZ		[from];
+	VelocityX		[to] = VelocityX		[from]; VelocityY		[to] = VelocityY		[from]; VelocityZ		[to] = VelocityZ		[from];
+	AccelerationX	[to] = AccelerationX	[from]; AccelerationY	[to] = AccelerationY	[from]; AccelerationZ	[to] = AccelerationZ	[from];
+	ForceX			[to] = ForceX			[from]; ForceY			[to] = ForceY			[from]; ForceZ			[to] = ForceZ			[from];
+	InverseMass		[to] = InverseMass		[from];
+	DampingClass	[to] = DampingClass		[from];
+}
+
+void									ParticleSystem::ClearForces				()																										{
+	const uint32_t								count									= Size();
+	for (uint32_t iParticle = 0; iParticle < count; ++iParticle) {
+		ForceX[iParticle]						= 0;
+		ForceY[iParticle]						= 0;
+		ForceZ[iParticle]						= 0;
+	}
+}
+
+void									ParticleSystem::Integrate				(double duration)																						{
+	UpdateDampingFactors(duration);
+	IntegrateRange(0, Size(), duration);
+}
+
+// Same steps as Particle::Integrate. Particles with infinite mass are masked out by a zero step rather than skipped, so every particle runs the same instructions.
+void									ParticleSystem::IntegrateRange			(uint32_t begin, uint32_t end, double duration)															{
+	double										* positionX								= PositionX		.data();
+	double										* positionY								= PositionY		.data();
+	double										* positionZ								= PositionZ		.data();
+	double										* velocityX								= VelocityX		.data();
+	double										* velocityY								= VelocityY		.data();
+	double										* velocityZ								= VelocityZ		.data();
+	const double								* accelerationX							= AccelerationX	.data();
+	const double								* accelerationY							= AccelerationY	.data();
+	const double								* accelerationZ							= AccelerationZ	.data();
+	double										* forceX								= ForceX		.data();
+	double										* forceY								= ForceY		.data();
+	double										* forceZ								= ForceZ		.data();
+	const double								* inverseMass							= InverseMass	.data();
+	const uint16_t								* dampingClass							= DampingClass	.data();
+	const double								* dampingFactors						= Damping.Factors.data();
+	for (uint32_t iParticle = begin; iParticle < end; ++iParticle) {
+		const bool									moves									= inverseMass[iParticle] > 0;
+		const double								step									= moves ? duration : 0;
+		const double								damping									= moves ? dampingFactors[dampingClass[iParticle]] : 1;
+		positionX[iParticle]					+= velocityX[iParticle] * step;	// Update linear position.
+		positionY[iParticle]					+= velocityY[iParticle] * step;
+		positionZ[iParticle]					+= velocityZ[iParticle] * step;
+		velocityX[iParticle]					= (velocityX[iParticle] + (accelerationX[iParticle] + forceX[iParticle] * inverseMass[iParticle]) * step) * damping;	// Update linear velocity from the acceleration and impose drag.
+		velocityY[iParticle]					= (velocityY[iParticle] + (accelerationY[iParticle] + forceY[iParticle] * inverseMass[iParticle]) * step) * damping;
+		velocityZ[iParticle]					= (velocityZ[iParticle] + (accelerationZ[iParticle] + forceZ[iParticle] * inverseMass[iParticle]) * step) * damping;
+		forceX[iParticle]						= 0;	// Clear the forces.
+		forceY[iParticle]						= 0;
+		forceZ[iParticle]						= 0;
+	}
+}
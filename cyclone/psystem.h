@@ -0,0 +1,65 @@
+// This file contains the particle system: a set of particles stored as structures of arrays, for simulating large numbers of particles at once.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "core.h"
+#include "damping.h"
+
+#include <vector>
+
+#ifndef CYCLONE_PSYSTEM_H
+#define CYCLONE_PSYSTEM_H
+
+namespace cyclone {
+	// Holds a set of particles with the same behaviour as Particle, but with each of their properties stored in its own contiguous array, one entry per particle.
+	// Integrating the set streams through the arrays once, with no pointer chasing and with the same arithmetic for every particle, so the compiler can process several particles per instruction.
+	// Particles are addressed by index. Damping is given through the classes of a damping table, so the damping factor for the frame is calculated once per class instead of once per particle.
+	struct ParticleSystem {
+		typedef	::std::vector<double>		TReals;
+
+		TReals								PositionX				= {};
+		TReals								PositionY				= {};
+		TReals								PositionZ				= {};
+		TReals								VelocityX				= {};
+		TReals								VelocityY				= {};
+		TReals								VelocityZ				= {};
+		TReals								AccelerationX			= {};
+		TReals								AccelerationY			= {};
+		TReals								AccelerationZ			= {};
+		TReals								ForceX					= {};	// Holds the accumulated force of each particle. It is cleared on each integration.
+		TReals								ForceY					= {};
+		TReals								ForceZ					= {};
+		TReals								InverseMass				= {};	// Particles with zero inverse mass are not integrated.
+		::std::vector<uint16_t>				DampingClass			= {};	// Holds the index of the damping class of each particle.
+		DampingTable						Damping					= {};
+
+		inline	uint32_t					Size					()																			const	{ return (uint32_t)InverseMass.size(); }
+		// Returns the damping class with the given damping value, adding it if there isn't one yet, or DampingTable::InvalidClass if the table is full. Particles hold no damping of their own, so they must be given a valid class.
+		inline	uint16_t					AddDampingClass			(double damping)																	{ return Damping.AddClass(damping); }
+		// Adds a particle and returns its index. The force accumulator of the new particle is clear.
+		uint32_t							Add						(const Vector3 &position, const Vector3 &velocity, const Vector3 &acceleration, double inverseMass, uint16_t dampingClass);
+		// Removes the given particle by moving the last particle into its place. The index of the last particle changes to the removed index.
+		void								Remove					(uint32_t index);
+		void								Clear					();	// Removes all the particles. The damping classes are kept.
+		void								Reserve					(uint32_t count);
+		// Sets the number of particles. New particles are zeroed, with the first damping class. Within the reserved count this never allocates memory.
+		void								Resize					(uint32_t count);
+		void								Move					(uint32_t from, uint32_t to);	// Copies every property of the particle at the first index over the particle at the second one.
+
+		inline	Vector3						GetPosition				(uint32_t index)															const	{ return {PositionX		[index], PositionY		[index], PositionZ		[index]}; }
+		inline	Vector3						GetVelocity				(uint32_t index)															const	{ return {VelocityX		[index], VelocityY		[index], VelocityZ		[index]}; }
+		inline	Vector3						GetAcceleration			(uint32_t index)															const	{ return {AccelerationX	[index], AccelerationY	[index], AccelerationZ	[index]}; }
+		inline	Vector3						GetForce				(uint32_t index)															const	{ return {ForceX		[index], ForceY			[index], ForceZ			[index]}; }
+		inline	void						SetPosition				(uint32_t index, const Vector3 &position)											{ PositionX		[index] = position.x	; PositionY		[index] = position.y	; PositionZ		[index] = position.z	; }
+		inline	void						SetVelocity				(uint32_t index, const Vector3 &velocity)											{ VelocityX		[index] = velocity.x	; VelocityY		[index] = velocity.y	; VelocityZ		[index] = velocity.z	; }
+		inline	void						SetAcceleration			(uint32_t index, const Vector3 &acceleration)										{ AccelerationX	[index] = acceleration.x; AccelerationY	[index] = acceleration.y; AccelerationZ	[index] = acceleration.z; }
+		inline	void						AddForce				(uint32_t index, const Vector3 &force)												{ ForceX		[index] += force.x		; ForceY		[index] += force.y		; ForceZ		[index] += force.z		; }
+
+		void								ClearForces				();	// Clears the force accumulators of all the particles.
+		void								Integrate				(double duration);	// Integrates all the particles forward in time by the given duration, and clears their force accumulators.
+		// Integrates the particles in the range [begin, end). The damping factors for the duration must have been calculated with UpdateDampingFactors.
+		void								IntegrateRange			(uint32_t begin, uint32_t end, double duration);
+		inline	void						UpdateDampingFactors	(double duration)																	{ Damping.Update(duration); }	// Calculates the damping factor of each class for the given duration.
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_PSYSTEM_H
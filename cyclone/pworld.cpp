@@ -1,6 +1,7 @@
 // Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "pworld.h"
+#include "profile.h"
 
 #include <cstddef>
 
@@ -20,11 +21,13 @@ using namespace cyclone;
 }
 
 void								ParticleWorld::StartFrame			()																		{
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_START_FRAME);
 	for (TParticles::iterator p = Particles.begin(); p != Particles.end(); ++p)
 		(*p)->AccumulatedForce				= {};	// Remove all forces from the accumulator
 }
 
 uint32_t							ParticleWorld::GenerateContacts		()																		{
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_GENERATE_CONTACTS);
 	uint32_t								limit								= MaxContacts;
 	ParticleContact							* nextContact						= Contacts;
 	for (TContactGenerators::iterator g = ContactGenerators.begin(); g != ContactGenerators.end(); ++g) {
@@ -32,19 +35,57 @@ uint32_t							ParticleWorld::GenerateContacts		()																		{
 		limit								-= used;
 		nextContact							+= used;
 
-		if (limit <= 0)		// We've run out of contacts to fill. This means we're missing contacts.
+		if (limit <= 0) {	// We've run out of contacts to fill. This means we're missing contacts.
+			CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_GENERATORS_SKIPPED, (uint32_t)(ContactGenerators.end() - (g + 1)));	// The generators left uncalled.
 			break;
+		}
 	}
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_CONTACTS_GENERATED, MaxContacts - limit);
 	return MaxContacts - limit;	// Return the number of contacts used.
 }
 
+// Integrates the given particles. Particles usually share a few damping values, so the damping factor is only calculated again when the damping differs from the one of the previous particle.
+static	void						integrateParticles					(Particle **particles, uint32_t begin, uint32_t end, double duration)	{
+	double									damping								= 1;
+	double									dampingFactor						= 1;
+	for (uint32_t iParticle = begin; iParticle < end; ++iParticle) {
+		Particle								& particle							= *particles[iParticle];
+		if (particle.Damping != damping) {
+			damping								= particle.Damping;
+			dampingFactor						= real_pow(damping, duration);
+		}
+		particle.Integrate(duration, dampingFactor);
+	}
+}
+
 void								ParticleWorld::Integrate			(double duration)														{
-	for (TParticles::iterator p = Particles.begin(); p != Particles.end(); ++p)
-		(*p)->Integrate(duration);		// Remove all forces from the accumulator
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_INTEGRATE);
+	Particle								** particles						= Particles.data();
+	if (0 == Threads) {
+		integrateParticles(particles, 0, (uint32_t)Particles.size(), duration);
+		System.Integrate(duration);
+		return;
+	}
+	Threads->ParallelFor((uint32_t)Particles.size(), ParticlesPerChunk, [particles, duration](uint32_t begin, uint32_t end) { integrateParticles(particles, begin, end, duration); });
+	System.UpdateDampingFactors(duration);
+	Threads->ParallelFor(System.Size(), ParticlesPerChunk, [this, duration](uint32_t begin, uint32_t end) { System.IntegrateRange(begin, end, duration); });
 }
 
 void								ParticleWorld::RunPhysics			(double duration)														{
-	ForceRegistry.UpdateForces	(duration);		// First apply the force generators
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_STEP);
+	if (Threads) {	// First apply the force generators and the force fields
+		ForceRegistry.UpdateForces(duration, *Threads, ParticlesPerChunk);
+		if (Fields.Fields.size()) {
+			Particle								** particles						= Particles.data();
+			Threads->ParallelFor((uint32_t)Particles.size(), ParticlesPerChunk, [this, particles](uint32_t begin, uint32_t end) { Fields.Apply(particles + begin, end - begin); });
+			Threads->ParallelFor(System.Size(), ParticlesPerChunk, [this](uint32_t begin, uint32_t end) { Fields.Apply(System, begin, end); });
+		}
+	}
+	else {
+		ForceRegistry.UpdateForces(duration);
+		Fields.Apply(Particles.data(), (uint32_t)Particles.size());
+		Fields.Apply(System, 0, System.Size());
+	}
 	Integrate					(duration);		// Then integrate the objects
 	uint32_t								usedContacts						= GenerateContacts();	// Generate contacts
 	if (usedContacts) {// And process them
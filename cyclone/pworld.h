@@ -2,6 +2,8 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "pfgen.h"
 #include "plinks.h"
+#include "psystem.h"
+#include "ffield.h"
 
 #ifndef CYCLONE_PWORLD_H
 #define CYCLONE_PWORLD_H
@@ -13,12 +15,16 @@ namespace cyclone {
 		typedef	::std::vector<ParticleContactGenerator*>	TContactGenerators;
 		
 		TParticles											Particles				= {};				// Holds the particles
+		ParticleSystem										System					= {};				// Holds the particles stored as structures of arrays. These are integrated along with the particles above; their forces are cleared by the integration rather than by StartFrame.
 		bool												CalculateIterations		= false;			// True if the world should calculate the number of iterations to give the contact resolver at each frame.
 		ParticleForceRegistry								ForceRegistry			= {};				// Holds the force generators for the particles in this world.
+		ForceFields											Fields					= {};				// Holds the force fields that apply to all the particles in this world, both the ones in Particles and the ones in System.
 		ParticleContactResolver								Resolver				= 0;				// Holds the resolver for contacts.
 		TContactGenerators									ContactGenerators		= {};				// Contact generators.
 		ParticleContact										* Contacts				= 0;				// Holds the list of contacts.
 		uint32_t											MaxContacts				= 0;				// Holds the maximum number of contacts allowed (i.e. the size of the contacts array).
+		ThreadPool											* Threads				= 0;				// Holds the thread pool used to run the force and integration phases. The world doesn't own it. If null, the phases run on the calling thread.
+		uint32_t											ParticlesPerChunk		= 2048;				// Holds the number of particles taken by a thread at a time when running on the thread pool.
 		
 															ParticleWorld			(uint32_t maxContacts, uint32_t iterations = 0);	// Creates a new particle simulator that can handle up to the given number of contacts per frame. You can also optionally give a number of contact-resolution iterations to use. If you don't give a number of iterations, then twice the number of contacts will be used.
 															~ParticleWorld			();	
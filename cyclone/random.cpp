@@ -88,3 +88,84 @@ Vector3				Random::RandomVector			(const Vector3 &min, const Vector3 &max)	{
 		, RandomReal(min.z, max.z)
 		};
 }
+
+static constexpr	uint64_t		StreamStep						= 0x9E3779B97F4A7C15ULL;	// Holds the odd constant added to the hashed number for each position, so consecutive positions hash very different numbers.
+
+// Returns the finaliser of SplitMix64, which turns numbers that differ by a constant into numbers with no visible relation.
+static inline	uint64_t		mixBits							(uint64_t value)							{
+	value				= (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value				= (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+static inline	double			bitsToReal						(uint64_t bits)								{ return (double)(int64_t)(bits >> 11) * (1.0 / 9007199254740992.0); }	// Makes a number in [0, 1) from the top 53 bits. The signed conversion is the one processors can do several at a time.
+
+void				RandomStream::Seed				(uint64_t seed, uint32_t stream)			{
+	SeedValue			= seed;
+	Key					= mixBits(mixBits(seed) + stream * StreamStep);
+	Position			= 0;
+	Buffered			= false;
+}
+
+void				RandomStream::Generate			(uint64_t first, uint64_t *values, uint32_t count)	const	{
+	const uint64_t			start				= Key + first * StreamStep;
+	for (uint32_t iValue = 0; iValue < count; ++iValue)
+		values[iValue]			= mixBits(start + iValue * StreamStep);
+}
+
+uint64_t			RandomStream::Random64			()											{ return mixBits(Key + Position++ * StreamStep); }
+double				RandomStream::RandomReal		()											{ return bitsToReal(Random64()); }
+
+uint32_t			RandomStream::RandomBits		()											{
+	if (Buffered) {
+		Buffered			= false;
+		return (uint32_t)Buffer;
+	}
+	const uint64_t			bits				= Random64();
+	Buffer				= bits >> 32;
+	Buffered			= true;
+	return (uint32_t)bits;
+}
+
+void				RandomStream::FillReal			(double *values, uint32_t count, double min, double max)					{
+	const uint64_t			start				= Key + Position * StreamStep;
+	const double			range				= max - min;
+	for (uint32_t iValue = 0; iValue < count; ++iValue)
+		values[iValue]			= min + bitsToReal(mixBits(start + iValue * StreamStep)) * range;
+	Position			+= count;
+	Buffered			= false;
+}
+
+void				RandomStream::FillVectors		(Vector3 *values, uint32_t count, const Vector3 &min, const Vector3 &max)	{
+	static constexpr	uint32_t	chunkVectors	= 64;
+	double					reals	[chunkVectors * 3];
+	const Vector3			range				= max - min;
+	for (uint32_t first = 0; first < count; first += chunkVectors) {
+		const uint32_t			chunkCount			= (count - first < chunkVectors) ? count - first : chunkVectors;
+		FillReal(reals, chunkCount * 3);
+		for (uint32_t iVector = 0; iVector < chunkCount; ++iVector)
+			values[first + iVector]	= 
+				{ min.x + reals[iVector * 3]		* range.x
+				, min.y + reals[iVector * 3 + 1]	* range.y
+				, min.z + reals[iVector * 3 + 2]	* range.z
+				};
+	}
+}
+
+// Uses the method of Shoemake, which maps three uniform numbers to a rotation, so every orientation is equally likely.
+void				RandomStream::FillQuaternions	(Quaternion *values, uint32_t count)		{
+	static constexpr	uint32_t	chunkQuaternions	= 64;
+	double					reals	[chunkQuaternions * 3];
+	for (uint32_t first = 0; first < count; first += chunkQuaternions) {
+		const uint32_t			chunkCount			= (count - first < chunkQuaternions) ? count - first : chunkQuaternions;
+		FillReal(reals, chunkCount * 3);
+		for (uint32_t iQuaternion = 0; iQuaternion < chunkCount; ++iQuaternion) {
+			const double			split				= reals[iQuaternion * 3];
+			const double			angle1				= 2 * R_PI * reals[iQuaternion * 3 + 1];
+			const double			angle2				= 2 * R_PI * reals[iQuaternion * 3 + 2];
+			const double			scale1				= real_sqrt(1 - split);
+			const double			scale2				= real_sqrt(split);
+			values[first + iQuaternion]	= Quaternion(scale2 * real_cos(angle2), scale1 * real_sin(angle1), scale1 * real_cos(angle1), scale2 * real_sin(angle2));
+		}
+	}
+}
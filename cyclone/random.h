@@ -13,7 +13,7 @@ namespace cyclone {
 		int32_t									p2												= 0;
 		uint32_t								Buffer[17]										= {};
 	public:
-		inline									Random											()											{ Seed(0);		}	// Creates a new random number stream with a seed based on timing data.
+		inline									Random											()											{ Seed(1);		}	// Creates a new random number stream with a fixed seed, so it gives the same numbers on every run. Seed(0) seeds it from the clock instead.
 		inline									Random											(uint32_t seed)								{ Seed(seed);	}	// Creates a new random stream with the given seed.
 
 		static inline	uint32_t				rotl											(uint32_t n, uint32_t r)					{ return (n << r) | (n >> (32 - r)); };	// left bitwise rotation
@@ -33,6 +33,42 @@ namespace cyclone {
 		Vector3									RandomXZVector									(double scale);				// Returns a random vector where each component is binomially distributed in the range (-scale to scale) [mean = 0.0f], except the y coordinate which is zero.
 		Quaternion								RandomQuaternion								();							// Returns a random orientation (i.e. normalized) quaternion.
 	};
+
+	// Holds a counter based random stream: the value at each position of the stream is a hash of the position and of a key made from the seed and the stream number, with the finaliser of SplitMix64.
+	// The state is just the key and the position, so a stream can jump anywhere at once, and streams with the same seed and different stream numbers are independent and reproducible.
+	// Give each thread, or each chunk of a parallel job, its own stream number and the results don't depend on how the work was scheduled.
+	// The values don't depend on each other, so the bulk fill methods are loops the compiler can process several values per instruction, and are much faster than the one value at a time methods.
+	class RandomStream {
+		uint64_t								SeedValue										= 0;
+		uint64_t								Key												= 0;
+		uint64_t								Position										= 0;	// Holds the position of the next value.
+		uint64_t								Buffer											= 0;	// Holds the upper half of the last value, for RandomBits.
+		bool									Buffered										= false;
+	public:
+		inline									RandomStream									(uint64_t seed = 0, uint32_t stream = 0)	{ Seed(seed, stream); }
+
+		void									Seed											(uint64_t seed, uint32_t stream = 0);	// Restarts the stream with the given seed and stream number, at the first position.
+		inline	RandomStream					GetStream										(uint32_t stream)					const	{ return RandomStream(SeedValue, stream); }	// Returns the stream with the same seed and the given stream number, at its first position.
+		inline	uint64_t						GetPosition										()									const	{ return Position; }
+		inline	void							SetPosition										(uint64_t position)							{ Position = position; Buffered = false; }	// Moves the stream to the given position.
+
+		static constexpr	uint32_t			StateWords										= 5;
+		inline	void							SaveState										(uint64_t *state)					const	{ state[0] = SeedValue; state[1] = Key; state[2] = Position; state[3] = Buffer; state[4] = Buffered; }	// Writes the whole state of the stream into StateWords values.
+		inline	void							LoadState										(const uint64_t *state)						{ SeedValue = state[0]; Key = state[1]; Position = state[2]; Buffer = state[3]; Buffered = 0 != state[4]; }
+
+		// Writes the given number of consecutive values, starting at the given position, without changing the state of the stream.
+		void									Generate										(uint64_t first, uint64_t *values, uint32_t count)		const;
+
+		uint64_t								Random64										();	// Returns the next 64 random bits from the stream.
+		uint32_t								RandomBits										();	// Returns 32 random bits. Two calls use the two halves of the same value.
+		double									RandomReal										();	// Returns a random floating point number between 0 and 1, with 53 random bits.
+		inline uint32_t							RandomInt										(uint32_t max)								{ return (uint32_t)(((uint64_t)RandomBits() * max) >> 32); }	// Returns a random integer less than the given value.
+		inline double							RandomReal										(double min, double max)					{ return RandomReal() * (max - min) + min; }
+
+		void									FillReal										(double *values, uint32_t count, double min = 0, double max = 1);	// Fills the given array with random numbers between min and max.
+		void									FillVectors										(Vector3 *values, uint32_t count, const Vector3 &min, const Vector3 &max);	// Fills the given array with random vectors in the box between min and max.
+		void									FillQuaternions									(Quaternion *values, uint32_t count);	// Fills the given array with random orientations, spread evenly over all the rotations.
+	};
 } // namespace cyclone
 
 #endif // CYCLONE_BODY_H
@@ -0,0 +1,522 @@
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "scene.h"
+
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+using namespace cyclone;
+
+static constexpr	uint32_t			SCENE_MAX_DEPTH							= 62;	// Holds the deepest tree BroadPhase::Query can walk with its fixed stack.
+static constexpr	uint64_t			SCENE_ALIGNMENT							= 16;
+
+static const uint32_t					sceneRecordSizes	[SCENE_SECTION_COUNT]	= {sizeof(RigidBody), sizeof(ScenePrimitive), sizeof(CollisionPlane), sizeof(SceneJoint), sizeof(BVHNode), sizeof(uint32_t)};
+
+bool									SceneFile::Open							(const char *fileName)																	{
+	Close();
+	uint8_t										* data									= 0;
+	uint64_t									size									= 0;
+#if defined(_WIN32)
+	const HANDLE								file									= CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (INVALID_HANDLE_VALUE == file)
+		return false;
+	LARGE_INTEGER								fileSize								= {};
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+		const HANDLE								mapping									= CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+		if (mapping) {
+			data									= (uint8_t*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+			size									= (uint64_t)fileSize.QuadPart;
+			CloseHandle(mapping);	// The view keeps the mapping alive.
+		}
+	}
+	CloseHandle(file);
+	if (0 == data)
+		return false;
+#else
+	const int									file									= open(fileName, O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat									status;
+	if (0 == fstat(file, &status) && status.st_size > 0) {
+		void										* mapping								= mmap(0, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (MAP_FAILED != mapping) {
+			data									= (uint8_t*)mapping;
+			size									= (uint64_t)status.st_size;
+		}
+	}
+	close(file);	// The mapping keeps the file open.
+	if (0 == data)
+		return false;
+#endif
+	if (Attach(data, size)) {
+		Mapped									= true;
+		return true;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+#else
+	munmap(data, (size_t)size);
+#endif
+	return false;
+}
+
+void									SceneFile::Close						()																						{
+	if (Mapped) {
+#if defined(_WIN32)
+		UnmapViewOfFile(Data);
+#else
+		munmap(Data, (size_t)Size);
+#endif
+	}
+	Data									= 0;
+	Size									= 0;
+	Mapped									= false;
+}
+
+bool									SceneFile::Attach						(uint8_t *data, uint64_t size)															{
+	Close();
+	if (0 == data || size < sizeof(SceneHeader) || ((uintptr_t)data % 8))
+		return false;
+	const SceneHeader							& header								= *(const SceneHeader*)data;
+	if (header.Magic != Magic || header.Version != Version || header.HeaderSize != sizeof(SceneHeader) || header.FileSize != size)
+		return false;
+	for (uint32_t iSection = 0; iSection < SCENE_SECTION_COUNT; ++iSection) {
+		const SceneSection							& section								= header.Sections[iSection];
+		if (header.RecordSize[iSection] != sceneRecordSizes[iSection] || section.Count > 0xFFFFFFFFU)
+			return false;
+		if (section.Offset < sizeof(SceneHeader) || section.Offset > size || (section.Offset % 8) || section.Count > (size - section.Offset) / sceneRecordSizes[iSection])
+			return false;
+	}
+
+	// Check the indices, so nothing read from the image can point outside of it.
+	const uint64_t								bodyCount								= header.Sections[SCENE_SECTION_BODIES		].Count;
+	const uint64_t								primitiveCount							= header.Sections[SCENE_SECTION_PRIMITIVES	].Count;
+	const uint64_t								nodeCount								= header.Sections[SCENE_SECTION_NODES		].Count;
+	const uint64_t								leafCount								= header.Sections[SCENE_SECTION_LEAVES		].Count;
+	const ScenePrimitive						* primitives							= (const ScenePrimitive	*)(data + header.Sections[SCENE_SECTION_PRIMITIVES	].Offset);
+	const SceneJoint							* joints								= (const SceneJoint		*)(data + header.Sections[SCENE_SECTION_JOINTS		].Offset);
+	const BVHNode								* nodes									= (const BVHNode		*)(data + header.Sections[SCENE_SECTION_NODES		].Offset);
+	const uint32_t								* leaves								= (const uint32_t		*)(data + header.Sections[SCENE_SECTION_LEAVES		].Offset);
+	for (uint64_t iPrimitive = 0; iPrimitive < primitiveCount; ++iPrimitive)
+		if (primitives[iPrimitive].Body >= bodyCount || primitives[iPrimitive].Type >= SHAPE_TYPE_COUNT)
+			return false;
+	for (uint64_t iJoint = 0; iJoint < header.Sections[SCENE_SECTION_JOINTS].Count; ++iJoint)
+		if (joints[iJoint].Body[0] >= bodyCount || joints[iJoint].Body[1] >= bodyCount)
+			return false;
+	for (uint64_t iLeaf = 0; iLeaf < leafCount; ++iLeaf)
+		if (leaves[iLeaf] >= primitiveCount)
+			return false;
+	if ((0 == nodeCount) != (0 == primitiveCount))
+		return false;
+	// Children must come after their parent, which rules out cycles, and have a single parent, so the depth of each node is the one of its only path. The tree must be shallow enough for the fixed stack of the queries.
+	::std::vector<uint8_t>						depths									(nodeCount);	// Only the root has a depth of zero, so zero also marks the nodes no parent has claimed yet.
+	for (uint64_t iNode = 0; iNode < nodeCount; ++iNode) {
+		const BVHNode								& node									= nodes[iNode];
+		if (node.IsLeaf()) {
+			if (node.First > leafCount || node.Count > leafCount - node.First)
+				return false;
+			continue;
+		}
+		if (node.First <= iNode || node.First + 1ULL >= nodeCount || depths[iNode] >= SCENE_MAX_DEPTH || depths[node.First] || depths[node.First + 1])
+			return false;
+		depths[node.First]						= depths[node.First + 1]				= depths[iNode] + 1;
+	}
+
+	Data									= data;
+	Size									= size;
+	return true;
+}
+
+void									SceneInstance::Load						(const SceneFile &file, bool inPlace)													{
+	File									= &file;
+	BodyCount								= file.GetCount(SCENE_SECTION_BODIES);
+	if (inPlace) {
+		BodyCopies.clear();
+		Bodies									= file.GetBodies();
+	}
+	else {
+		BodyCopies.resize(BodyCount);
+		if (BodyCount)
+			memcpy(BodyCopies.data(), file.GetBodies(), BodyCount * sizeof(RigidBody));
+		Bodies									= BodyCopies.data();
+	}
+
+	// Reserve the storage first, so the pointers to the primitives stay valid as they are added.
+	const uint32_t								primitiveCount							= file.GetCount(SCENE_SECTION_PRIMITIVES);
+	const ScenePrimitive						* records								= file.GetPrimitives();
+	uint32_t									typeCounts	[SHAPE_TYPE_COUNT]			= {};
+	for (uint32_t iPrimitive = 0; iPrimitive < primitiveCount; ++iPrimitive)
+		++typeCounts[records[iPrimitive].Type];
+	Boxes		.clear();
+	Spheres		.clear();
+	Primitives	.clear();
+	Boxes		.reserve(typeCounts[SHAPE_TYPE_BOX]);
+	Spheres		.reserve(typeCounts[SHAPE_TYPE_SPHERE]);
+	Primitives	.reserve(primitiveCount);
+	for (uint32_t iPrimitive = 0; iPrimitive < primitiveCount; ++iPrimitive) {
+		const ScenePrimitive						& record								= records[iPrimitive];
+		CollisionPrimitive							* primitive;
+		if (SHAPE_TYPE_SPHERE == record.Type) {
+			Spheres.push_back({});
+			Spheres.back().Radius					= record.Radius;
+			primitive								= &Spheres.back();
+		}
+		else {
+			Boxes.push_back({});
+			Boxes.back().HalfSize					= record.HalfSize;
+			primitive								= &Boxes.back();
+		}
+		primitive->Body							= &Bodies[record.Body];
+		primitive->Offset						= record.Offset;
+		primitive->Transform					= record.Transform;
+		primitive->CollisionLayer				= record.CollisionLayer;
+		primitive->CollisionMask				= record.CollisionMask;
+		primitive->CachedBody					= primitive->Body;	// The transform is the one of the body as stored, so it doesn't need calculating.
+		primitive->CachedBodyGeneration			= primitive->Body->TransformGeneration;
+		Primitives.push_back(primitive);
+	}
+
+	const uint32_t								jointCount								= file.GetCount(SCENE_SECTION_JOINTS);
+	const SceneJoint							* joints								= file.GetJoints();
+	Joints.resize(jointCount);
+	for (uint32_t iJoint = 0; iJoint < jointCount; ++iJoint) {
+		const SceneJoint							& joint									= joints[iJoint];
+		Joints[iJoint].Set(&Bodies[joint.Body[0]], joint.Position[0], &Bodies[joint.Body[1]], joint.Position[1], joint.Error);
+	}
+}
+
+void									SceneInstance::Register					(CollisionWorld &world)																	{
+	BroadPhase									& coarse								= world.Coarse;
+	const ScenePrimitive						* records								= File->GetPrimitives();
+	if (coarse.Proxies.empty()) {	// Take the tree as it is. Proxy indices are the primitive indices of the image.
+		coarse.Proxies.resize(Primitives.size());
+		for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive) {
+			const ScenePrimitive						& record								= records[iPrimitive];
+			CollisionProxy								& proxy									= coarse.Proxies[iPrimitive];
+			proxy.Primitive							= Primitives[iPrimitive];
+			proxy.Type								= (SHAPE_TYPE)record.Type;
+			proxy.Bounds							= record.Bounds;
+			proxy.Layer								= record.CollisionLayer;
+			proxy.Mask								= record.CollisionMask;
+			proxy.TransformGeneration				= Primitives[iPrimitive]->TransformGeneration;
+		}
+		coarse.Nodes	.assign(File->GetNodes	(), File->GetNodes	() + File->GetCount(SCENE_SECTION_NODES	));
+		coarse.Leaves	.assign(File->GetLeaves	(), File->GetLeaves	() + File->GetCount(SCENE_SECTION_LEAVES));
+		coarse.FreeProxies.clear();
+		coarse.NeedsRebuild						= false;
+	}
+	else
+		for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive) {
+			if (SHAPE_TYPE_SPHERE == records[iPrimitive].Type)
+				world.Register((CollisionSphere*)Primitives[iPrimitive]);
+			else
+				world.Register((CollisionBox*)Primitives[iPrimitive]);
+		}
+
+	world.HalfSpaces.insert(world.HalfSpaces.end(), File->GetPlanes(), File->GetPlanes() + File->GetCount(SCENE_SECTION_PLANES));
+	for (uint32_t iJoint = 0; iJoint < Joints.size(); ++iJoint)
+		coarse.ExcludePair(Joints[iJoint].Body[0], Joints[iJoint].Body[1]);
+}
+
+void									SceneInstance::AddTo					(World &world)																			{
+	for (uint32_t iBody = 0; iBody < BodyCount; ++iBody)
+		if (Bodies[iBody].Mass.InverseMass > 0)
+			world.AddBody(&Bodies[iBody]);
+	for (uint32_t iJoint = 0; iJoint < Joints.size(); ++iJoint)
+		world.AddContactGenerator(&Joints[iJoint]);
+}
+
+// Holds the words of a line of a scene description, and reads them in order.
+struct SceneLine {
+	::std::vector<::std::string>				Words									= {};
+	uint32_t									Next									= 0;
+
+	inline	bool								HasMore									()										const	{ return Next < Words.size(); }
+	inline	bool								IsNext									(const char *word)								{	// Consumes the next word if it is the given one.
+		if (!HasMore() || Words[Next] != word)
+			return false;
+		++Next;
+		return true;
+	}
+	bool										ReadReal								(double &value)									{
+		if (!HasMore())
+			return false;
+		const char									* word									= Words[Next].c_str();
+		char										* end									= 0;
+		value									= strtod(word, &end);
+		if (end == word || *end)
+			return false;
+		++Next;
+		return true;
+	}
+	bool										ReadBits								(uint32_t &value)								{
+		if (!HasMore())
+			return false;
+		const char									* word									= Words[Next].c_str();
+		char										* end									= 0;
+		value									= (uint32_t)strtoul(word, &end, 0);
+		if (end == word || *end)
+			return false;
+		++Next;
+		return true;
+	}
+	inline	bool								ReadVector								(Vector3 &value)								{ return ReadReal(value.x) && ReadReal(value.y) && ReadReal(value.z); }
+	inline	bool								ReadQuaternion							(Quaternion &value)								{ return ReadReal(value.r) && ReadReal(value.i) && ReadReal(value.j) && ReadReal(value.k); }
+	bool										ReadBody								(const ::std::vector<::std::string> &names, uint32_t firstBody, uint32_t &body)	{
+		if (!HasMore())
+			return false;
+		for (uint32_t iName = 0; iName < names.size(); ++iName)
+			if (names[iName] == Words[Next]) {
+				body									= firstBody + iName;
+				++Next;
+				return true;
+			}
+		return false;
+	}
+};
+
+// Splits the given line into words separated by blanks, dropping the comment.
+static	void							splitLine								(const char *begin, const char *end, SceneLine &line)									{
+	line.Words.clear();
+	line.Next								= 0;
+	while (begin < end && '#' != *begin) {
+		if (' ' == *begin || '\t' == *begin || '\r' == *begin) {
+			++begin;
+			continue;
+		}
+		const char									* word									= begin;
+		while (begin < end && ' ' != *begin && '\t' != *begin && '\r' != *begin && '#' != *begin)
+			++begin;
+		line.Words.emplace_back(word, begin);
+	}
+}
+
+// Reads the layer and mask options shared by the primitives.
+static	bool							readPrimitiveOption						(SceneLine &line, ScenePrimitive &primitive)											{
+	if (line.IsNext("layer"	)) return line.ReadBits(primitive.CollisionLayer);
+	if (line.IsNext("mask"	)) return line.ReadBits(primitive.CollisionMask);
+	if (line.IsNext("offset")) {
+		Vector3										position;
+		if (!line.ReadVector(position))
+			return false;
+		primitive.Offset.data[3]				= position.x;
+		primitive.Offset.data[7]				= position.y;
+		primitive.Offset.data[11]				= position.z;
+		return true;
+	}
+	return false;
+}
+
+bool									SceneBuilder::Parse						(const char *text, uint32_t *errorLine)													{
+	::std::vector<::std::string>				names;	// Holds the names of the bodies added by this text, which start at firstBody.
+	::std::vector<uint8_t>						needsInertia;
+	const uint32_t								firstBody								= (uint32_t)Bodies.size();
+	SceneLine									line;
+	uint32_t									lineNumber								= 0;
+	while (text && *text) {
+		const char									* end									= strchr(text, '\n');
+		if (0 == end)
+			end										= text + strlen(text);
+		++lineNumber;
+		splitLine(text, end, line);
+		text									= *end ? end + 1 : end;
+		if (!line.HasMore())
+			continue;
+
+		bool										valid									= true;
+		if (line.IsNext("body")) {
+			valid									= line.HasMore();
+			names.push_back(valid ? line.Words[line.Next++] : "");
+			RigidBody									body									= {};
+			body.Pivot.Orientation					= {1, 0, 0, 0};
+			body.Mass.setDamping(0.95, 0.8);
+			double										mass									= 0;
+			Vector3										inertia									= {};
+			bool										hasInertia								= false;
+			bool										awake									= true;
+			bool										canSleep								= true;
+			while (valid && line.HasMore()) {
+					 if (line.IsNext("mass"			)) valid = line.ReadReal		(mass) && mass > 0;
+				else if (line.IsNext("position"		)) valid = line.ReadVector		(body.Pivot.Position);
+				else if (line.IsNext("orientation"	)) valid = line.ReadQuaternion	(body.Pivot.Orientation);
+				else if (line.IsNext("velocity"		)) valid = line.ReadVector		(body.Force.Velocity);
+				else if (line.IsNext("rotation"		)) valid = line.ReadVector		(body.Force.Rotation);
+				else if (line.IsNext("acceleration"	)) valid = line.ReadVector		(body.Force.Acceleration);
+				else if (line.IsNext("damping"		)) valid = line.ReadReal		(body.Mass.LinearDamping) && line.ReadReal(body.Mass.AngularDamping);
+				else if (line.IsNext("inertia"		)) valid = hasInertia = line.ReadVector(inertia);
+				else if (line.IsNext("asleep"		)) awake	= false;
+				else if (line.IsNext("nosleep"		)) canSleep	= false;
+				else valid = false;
+			}
+			if (mass > 0) {
+				body.Mass.setMass(mass);
+				if (hasInertia) {
+					Matrix3										tensor;
+					tensor.setInertiaTensorCoeffs(inertia.x, inertia.y, inertia.z);
+					body.Mass.setInertiaTensor(tensor);
+				}
+			}
+			else	// Static bodies have no mass and no inertia, which Matrix3 and the damping setters leave at zero.
+				awake									= false;
+			body.setCanSleep(canSleep);
+			body.setAwake(awake);
+			body.Pivot.Orientation.normalise();
+			Bodies.push_back(body);
+			needsInertia.push_back(mass > 0 && !hasInertia);
+		}
+		else if (line.IsNext("box") || line.IsNext("sphere")) {
+			const bool									isSphere								= line.Words[0] == "sphere";
+			ScenePrimitive								primitive								= {};
+			primitive.Type							= isSphere ? SHAPE_TYPE_SPHERE : SHAPE_TYPE_BOX;
+			valid									= line.ReadBody(names, firstBody, primitive.Body) && (isSphere ? line.ReadReal(primitive.Radius) : line.ReadVector(primitive.HalfSize));
+			while (valid && line.HasMore()) {
+				if (!isSphere && line.IsNext("turn")) {
+					Quaternion									turn;
+					valid									= line.ReadQuaternion(turn);
+					turn.normalise();
+					primitive.Offset.setOrientationAndPos(turn, {primitive.Offset.data[3], primitive.Offset.data[7], primitive.Offset.data[11]});
+				}
+				else
+					valid									= readPrimitiveOption(line, primitive);
+			}
+			if (valid) {
+				Primitives.push_back(primitive);
+				const uint32_t								body									= primitive.Body - firstBody;
+				if (needsInertia[body]) {
+					RigidBody									& owner									= Bodies[primitive.Body];
+					const double								mass									= owner.Mass.getMass();
+					Matrix3										tensor;
+					if (isSphere) {
+						const double								moment									= 0.4 * mass * primitive.Radius * primitive.Radius;
+						tensor.setInertiaTensorCoeffs(moment, moment, moment);
+					}
+					else
+						tensor.setBlockInertiaTensor(primitive.HalfSize, mass);
+					owner.Mass.setInertiaTensor(tensor);
+					needsInertia[body]						= false;
+				}
+			}
+		}
+		else if (line.IsNext("plane")) {
+			CollisionPlane								plane;
+			valid									= line.ReadVector(plane.Direction) && line.ReadReal(plane.Offset) && !line.HasMore();
+			if (valid) {
+				plane.Direction.normalise();
+				Planes.push_back(plane);
+			}
+		}
+		else if (line.IsNext("joint")) {
+			SceneJoint									joint;
+			valid									= line.ReadBody(names, firstBody, joint.Body[0]) && line.ReadVector(joint.Position[0])
+													&& line.ReadBody(names, firstBody, joint.Body[1]) && line.ReadVector(joint.Position[1])
+													&& line.ReadReal(joint.Error) && !line.HasMore()
+													;
+			if (valid)
+				Joints.push_back(joint);
+		}
+		else
+			valid									= false;
+
+		if (!valid) {
+			if (errorLine)
+				*errorLine								= lineNumber;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool									SceneBuilder::Build						(::std::vector<uint8_t> &image)															{
+	const uint32_t								bodyCount								= (uint32_t)Bodies.size();
+	for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive)
+		if (Primitives[iPrimitive].Body >= bodyCount || Primitives[iPrimitive].Type >= SHAPE_TYPE_COUNT)
+			return false;
+	for (uint32_t iJoint = 0; iJoint < Joints.size(); ++iJoint)
+		if (Joints[iJoint].Body[0] >= bodyCount || Joints[iJoint].Body[1] >= bodyCount)
+			return false;
+
+	for (uint32_t iBody = 0; iBody < bodyCount; ++iBody) {
+		Bodies[iBody].Id						= iBody;
+		Bodies[iBody].CalculateDerivedData();
+	}
+
+	// Build the tree the way the broad phase would, with primitives standing in for the records. Proxies are inserted in order into an empty broad phase, so their indices are the primitive indices.
+	uint32_t									typeCounts	[SHAPE_TYPE_COUNT]			= {};
+	for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive)
+		++typeCounts[Primitives[iPrimitive].Type];
+	::std::vector<CollisionBox>					boxes;
+	::std::vector<CollisionSphere>				spheres;
+	boxes	.reserve(typeCounts[SHAPE_TYPE_BOX]);
+	spheres	.reserve(typeCounts[SHAPE_TYPE_SPHERE]);
+	BroadPhase									coarse;
+	for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive) {
+		const ScenePrimitive						& record								= Primitives[iPrimitive];
+		CollisionPrimitive							* primitive;
+		if (SHAPE_TYPE_SPHERE == record.Type) {
+			spheres.push_back({});
+			spheres.back().Radius					= record.Radius;
+			coarse.Insert(&spheres.back());
+			primitive								= &spheres.back();
+		}
+		else {
+			boxes.push_back({});
+			boxes.back().HalfSize					= record.HalfSize;
+			coarse.Insert(&boxes.back());
+			primitive								= &boxes.back();
+		}
+		primitive->Body							= &Bodies[record.Body];
+		primitive->Offset						= record.Offset;
+		primitive->CollisionLayer				= record.CollisionLayer;
+		primitive->CollisionMask				= record.CollisionMask;
+		primitive->CalculateInternals();
+	}
+	coarse.Update();
+	for (uint32_t iPrimitive = 0; iPrimitive < Primitives.size(); ++iPrimitive) {
+		Primitives[iPrimitive].Transform		= coarse.Proxies[iPrimitive].Primitive->Transform;
+		Primitives[iPrimitive].Bounds			= coarse.Proxies[iPrimitive].Bounds;
+	}
+
+	SceneHeader									header;
+	header.Magic							= SceneFile::Magic;
+	header.Version							= SceneFile::Version;
+	header.HeaderSize						= sizeof(SceneHeader);
+	const void									* sections	[SCENE_SECTION_COUNT]		= {Bodies.data(), Primitives.data(), Planes.data(), Joints.data(), coarse.Nodes.data(), coarse.Leaves.data()};
+	const uint64_t								counts		[SCENE_SECTION_COUNT]		= {Bodies.size(), Primitives.size(), Planes.size(), Joints.size(), coarse.Nodes.size(), coarse.Leaves.size()};
+	uint64_t									offset									= sizeof(SceneHeader);
+	for (uint32_t iSection = 0; iSection < SCENE_SECTION_COUNT; ++iSection) {
+		offset									= (offset + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT;
+		header.RecordSize[iSection]				= sceneRecordSizes[iSection];
+		header.Sections[iSection]				= {offset, counts[iSection]};
+		offset									+= counts[iSection] * sceneRecordSizes[iSection];
+	}
+	header.FileSize							= offset;
+
+	image.assign((size_t)offset, 0);
+	memcpy(image.data(), &header, sizeof(header));
+	for (uint32_t iSection = 0; iSection < SCENE_SECTION_COUNT; ++iSection)
+		if (counts[iSection])
+			memcpy(&image[(size_t)header.Sections[iSection].Offset], sections[iSection], (size_t)(counts[iSection] * sceneRecordSizes[iSection]));
+	return true;
+}
+
+bool									SceneBuilder::Write						(const char *fileName)																	{
+	::std::vector<uint8_t>						image;
+	if (!Build(image))
+		return false;
+	FILE										* file									= fopen(fileName, "wb");
+	if (0 == file)
+		return false;
+	const bool									written									= fwrite(image.data(), 1, image.size(), file) == image.size();
+	return (0 == fclose(file)) && written;
+}
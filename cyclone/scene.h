@@ -0,0 +1,131 @@
+// This file contains the scene format: a flat binary image of the bodies, primitives, half-spaces and joints of a scene, with the broad phase tree already built, that is loaded by mapping the file into memory instead of parsing it and building the objects one by one.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "collide_world.h"
+#include "world.h"
+
+#ifndef CYCLONE_SCENE_H
+#define CYCLONE_SCENE_H
+
+namespace cyclone {
+	// Identifies the arrays of a scene image.
+	enum SCENE_SECTION : uint32_t
+		{	SCENE_SECTION_BODIES		= 0	// Holds RigidBody records, with their derived data calculated, so they can be simulated where they are.
+		,	SCENE_SECTION_PRIMITIVES		// Holds ScenePrimitive records.
+		,	SCENE_SECTION_PLANES			// Holds CollisionPlane records.
+		,	SCENE_SECTION_JOINTS			// Holds SceneJoint records.
+		,	SCENE_SECTION_NODES				// Holds the BVHNode records of the broad phase tree over the primitives.
+		,	SCENE_SECTION_LEAVES			// Holds the primitive indices referenced by the leaves of the tree.
+		,	SCENE_SECTION_COUNT
+		};
+
+	// Locates an array of a scene image. The offset is counted from the start of the image, so the image can be loaded at any address.
+	struct SceneSection {
+		uint64_t							Offset									= 0;
+		uint64_t							Count									= 0;
+	};
+
+	// Holds the header found at the start of a scene image. The sizes of the records are stored so an image written by a build with a different layout of the engine structures is rejected instead of misread.
+	struct SceneHeader {
+		uint32_t							Magic									= 0;
+		uint16_t							Version									= 0;
+		uint16_t							HeaderSize								= 0;
+		uint32_t							RecordSize	[SCENE_SECTION_COUNT]		= {};
+		uint64_t							FileSize								= 0;
+		SceneSection						Sections	[SCENE_SECTION_COUNT]		= {};
+	};
+
+	// Holds a primitive of a scene image. The body is an index into the bodies of the image. The transform and bounds are those of the body as stored, so loading doesn't recalculate them.
+	struct ScenePrimitive {
+		Matrix4								Offset									= {};
+		Matrix4								Transform								= {};
+		BoundingBox							Bounds									= {};
+		Vector3								HalfSize								= {};	// Holds the half-sizes of boxes.
+		double								Radius									= 0;	// Holds the radius of spheres.
+		uint32_t							Body									= 0;
+		uint32_t							CollisionLayer							= 1;
+		uint32_t							CollisionMask							= 0xFFFFFFFFU;
+		uint32_t							Type									= SHAPE_TYPE_BOX;
+	};
+
+	// Holds a joint of a scene image. The bodies are indices into the bodies of the image.
+	struct SceneJoint {
+		Vector3								Position	[2]							= {};
+		double								Error									= 0;
+		uint32_t							Body		[2]							= {};
+	};
+
+	// Gives access to a scene image, either mapped from a file or already in memory. Open maps the file copy on write, so the bodies can be simulated where they are: the pages that are written to are copied by the system, and the file doesn't change.
+	// Opening checks the header and every index in the image, so a damaged or foreign file is refused instead of making the loader read or write outside its arrays. The image must have been written by a build with the same layout of the engine structures.
+	class SceneFile {
+		uint8_t								* Data									= 0;
+		uint64_t							Size									= 0;
+		bool								Mapped									= false;
+
+		template<typename T>
+		inline	T*							GetSection								(SCENE_SECTION section)					const	{ return (T*)(Data + ((const SceneHeader*)Data)->Sections[section].Offset);	}
+	public:
+		static constexpr	uint32_t		Magic									= 0x43535943;	// "CYSC"
+		static constexpr	uint16_t		Version									= 1;
+
+											~SceneFile								()												{ Close(); }
+
+		bool								Open									(const char *fileName);	// Maps the given file. Returns false if it can't be mapped or isn't a valid scene image.
+		bool								Attach									(uint8_t *data, uint64_t size);	// Uses the given image, which must stay alive and be aligned to 8 bytes. Returns false if it isn't a valid scene image.
+		void								Close									();
+
+		inline	bool						IsOpen									()										const	{ return 0 != Data;																		}
+		inline	uint32_t					GetCount								(SCENE_SECTION section)					const	{ return Data ? (uint32_t)((const SceneHeader*)Data)->Sections[section].Count : 0;		}
+		inline	RigidBody*					GetBodies								()										const	{ return GetSection<RigidBody			>(SCENE_SECTION_BODIES		);					}
+		inline	const ScenePrimitive*		GetPrimitives							()										const	{ return GetSection<const ScenePrimitive>(SCENE_SECTION_PRIMITIVES	);					}
+		inline	const CollisionPlane*		GetPlanes								()										const	{ return GetSection<const CollisionPlane	>(SCENE_SECTION_PLANES		);					}
+		inline	const SceneJoint*			GetJoints								()										const	{ return GetSection<const SceneJoint	>(SCENE_SECTION_JOINTS		);					}
+		inline	const BVHNode*				GetNodes								()										const	{ return GetSection<const BVHNode		>(SCENE_SECTION_NODES		);					}
+		inline	const uint32_t*				GetLeaves								()										const	{ return GetSection<const uint32_t		>(SCENE_SECTION_LEAVES		);					}
+	};
+
+	// Holds the objects of a loaded scene that can't stay in the image because they point to each other: the primitives and the joints. The bodies are used in the image, or copied out of it with a single copy.
+	// Load is a loop over the primitives and the joints filling in their fields, with nothing to parse or calculate. Register gives the primitives to a collision world along with the tree of the image, so the broad phase doesn't have to build it.
+	struct SceneInstance {
+		RigidBody							* Bodies								= 0;	// Points to the bodies in the image, or to BodyCopies.
+		uint32_t							BodyCount								= 0;
+		::std::vector<RigidBody>			BodyCopies								= {};
+		::std::vector<CollisionBox>			Boxes									= {};
+		::std::vector<CollisionSphere>		Spheres									= {};
+		::std::vector<CollisionPrimitive*>	Primitives								= {};	// Holds the primitives in the order of the image.
+		::std::vector<Joint>				Joints									= {};
+		const SceneFile						* File									= 0;
+
+		// Creates the objects of the given scene, which must stay open while they are in use. In place, the bodies are the ones of the image, otherwise they are copied.
+		void								Load									(const SceneFile &file, bool inPlace = false);
+		// Registers the primitives and the half-spaces with the given collision world, and excludes the bodies of each joint from colliding with each other. If the world has no primitives yet, it takes the tree of the image as it is.
+		void								Register								(CollisionWorld &world);
+		void								AddTo									(World &world);	// Adds the bodies with a finite mass and the joints to the given world. The bodies without one never move, so they aren't integrated.
+	};
+
+	// Builds scene images, from code or from a text description. The text holds one object per line: a keyword, the values it needs, then its options in any order. A # starts a comment:
+	//
+	//	body <name> [mass <kg>] [position <x> <y> <z>] [orientation <r> <i> <j> <k>] [velocity <x> <y> <z>] [rotation <x> <y> <z>] [acceleration <x> <y> <z>] [damping <linear> <angular>] [inertia <x> <y> <z>] [asleep] [nosleep]
+	//	box <body> <half x> <half y> <half z> [offset <x> <y> <z>] [turn <r> <i> <j> <k>] [layer <bits>] [mask <bits>]
+	//	sphere <body> <radius> [offset <x> <y> <z>] [layer <bits>] [mask <bits>]
+	//	plane <normal x> <normal y> <normal z> <offset>
+	//	joint <body> <x> <y> <z> <body> <x> <y> <z> <error>
+	//
+	// Bodies without a mass are static: their inverse mass and inertia are zero and they start asleep. Static geometry of any size is best given as many primitives of a single static body, placed with their offsets.
+	// Dynamic bodies without an inertia take the inertia of a solid of their first primitive. The damping defaults to 0.95 and 0.8. Bodies are referred to by name and must come before the primitives and joints that use them.
+	class SceneBuilder {
+	public:
+		::std::vector<RigidBody>			Bodies									= {};
+		::std::vector<ScenePrimitive>		Primitives								= {};	// Only the shape, offset, body, layer and mask need to be set. The rest is calculated by Build.
+		::std::vector<CollisionPlane>		Planes									= {};
+		::std::vector<SceneJoint>			Joints									= {};
+
+		// Adds the objects of the given text description. Returns false and the number of the line at fault if the text can't be read, leaving the objects of the lines before it added.
+		bool								Parse									(const char *text, uint32_t *errorLine = 0);
+		// Calculates the derived data of the bodies and primitives, builds the broad phase tree and writes the image. Returns false if a primitive or joint refers to a body that doesn't exist.
+		bool								Build									(::std::vector<uint8_t> &image);
+		bool								Write									(const char *fileName);	// Builds the image and writes it to the given file.
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_SCENE_H
@@ -0,0 +1,361 @@
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "trajectory.h"
+#include "world.h"
+
+#include <string.h>
+
+using namespace cyclone;
+
+static constexpr	uint32_t			TRAJECTORY_VALUES						= 7;	// Holds the number of values stored for each body: three for the position and four for the orientation.
+
+// Seeks with 64 bit offsets, as recordings easily grow past the 2 GB that fseek can reach on some systems.
+static	int								seekFile								(FILE *file, int64_t offset, int origin)												{
+#if defined(_WIN32)
+	return _fseeki64(file, offset, origin);
+#else
+	return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+// Returns the number of bytes between the current position of the file and its end, or zero if it can't be found.
+static	uint64_t						remainingBytes							(FILE *file)																			{
+#if defined(_WIN32)
+	const int64_t								position								= _ftelli64(file);
+#else
+	const int64_t								position								= ftello(file);
+#endif
+	if (position < 0 || seekFile(file, 0, SEEK_END))
+		return 0;
+#if defined(_WIN32)
+	const int64_t								end										= _ftelli64(file);
+#else
+	const int64_t								end										= ftello(file);
+#endif
+	if (seekFile(file, position, SEEK_SET))
+		return 0;
+	return (end > position) ? (uint64_t)(end - position) : 0;
+}
+
+// Appends the given value as a variable length integer, with small values of either sign taking a single byte.
+static	void							writeVarint								(::std::vector<uint8_t> &output, int64_t value)											{
+	uint64_t									bits									= ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);	// Zigzag, so small negative values stay small.
+	while (bits >= 0x80) {
+		output.push_back((uint8_t)(bits | 0x80));
+		bits									>>= 7;
+	}
+	output.push_back((uint8_t)bits);
+}
+
+static	bool							readVarint								(const ::std::vector<uint8_t> &input, uint32_t &cursor, int64_t &value)					{
+	uint64_t									bits									= 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		if (cursor >= input.size())
+			return false;
+		const uint8_t								byte									= input[cursor++];
+		bits									|= (uint64_t)(byte & 0x7F) << shift;
+		if (0 == (byte & 0x80)) {
+			value									= (int64_t)(bits >> 1) ^ -(int64_t)(bits & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline	void					quantize								(const SPivot3D &pivot, const TrajectorySettings &settings, int64_t *values)			{
+	const double								positionScale							= 1 / settings.PositionPrecision;
+	const double								orientationScale						= 1 / settings.OrientationPrecision;
+	values[0]								= llround(pivot.Position.x		* positionScale);
+	values[1]								= llround(pivot.Position.y		* positionScale);
+	values[2]								= llround(pivot.Position.z		* positionScale);
+	values[3]								= llround(pivot.Orientation.r	* orientationScale);
+	values[4]								= llround(pivot.Orientation.i	* orientationScale);
+	values[5]								= llround(pivot.Orientation.j	* orientationScale);
+	values[6]								= llround(pivot.Orientation.k	* orientationScale);
+}
+
+// Moves the given values of a body on by a frame, carrying on the motion of the two frames before and adding the given residuals, if any.
+static inline	void					predict									(int64_t *previous, int64_t *beforePrevious, const int64_t *residuals)					{
+	for (uint32_t iValue = 0; iValue < TRAJECTORY_VALUES; ++iValue) {
+		const int64_t								value									= 2 * previous[iValue] - beforePrevious[iValue] + (residuals ? residuals[iValue] : 0);
+		beforePrevious[iValue]					= previous[iValue];
+		previous[iValue]						= value;
+	}
+}
+
+bool									TrajectoryRecorder::Open				(const char *fileName, const TrajectorySettings &settings)								{
+	Close();
+	if (!(settings.PositionPrecision > 0) || !(settings.OrientationPrecision > 0) || 0 == settings.KeyframeInterval || 0 == settings.QueueLength)
+		return false;
+	File									= fopen(fileName, "wb");
+	if (0 == File)
+		return false;
+	TrajectoryHeader							header;
+	header.Magic							= Magic;
+	header.Version							= Version;
+	header.HeaderSize						= sizeof(TrajectoryHeader);
+	header.PositionPrecision				= settings.PositionPrecision;
+	header.OrientationPrecision				= settings.OrientationPrecision;
+	header.KeyframeInterval					= settings.KeyframeInterval;
+	if (1 != fwrite(&header, sizeof(header), 1, File)) {
+		fclose(File);
+		File									= 0;
+		return false;
+	}
+
+	Settings								= settings;
+	Frames.assign(settings.QueueLength, {});
+	FirstQueued								= 0;
+	QueuedCount								= 0;
+	Stopping								= false;
+	Time									= 0;
+	Stalls									= 0;
+	Chunk									= {};
+	Payload.clear();
+	Failed			.store(false				, ::std::memory_order_relaxed);
+	BytesWritten	.store(sizeof(header)		, ::std::memory_order_relaxed);
+	FramesWritten	.store(0					, ::std::memory_order_relaxed);
+	Writer									= ::std::thread(&TrajectoryRecorder::WriterLoop, this);
+	return true;
+}
+
+bool									TrajectoryRecorder::Close				()																						{
+	if (0 == File)
+		return true;
+	{
+		const ::std::lock_guard<::std::mutex>		lock									(Mutex);
+		Stopping								= true;
+	}
+	FrameQueued.notify_one();
+	Writer.join();
+	if (0 != fclose(File))
+		Failed.store(true, ::std::memory_order_relaxed);
+	File									= 0;
+	return !HasFailed();
+}
+
+bool									TrajectoryRecorder::Capture				(const World &world, double duration)													{
+	if (0 == File || HasFailed())
+		return false;
+	::std::unique_lock<::std::mutex>			lock									(Mutex);
+	if (QueuedCount == Frames.size()) {
+		++Stalls;
+		FrameWritten.wait(lock, [this]() { return QueuedCount < Frames.size(); });
+	}
+	Frame										& frame									= Frames[(FirstQueued + QueuedCount) % Frames.size()];
+	lock.unlock();	// The writer thread doesn't touch the frames that aren't queued.
+
+	Time									+= duration;
+	frame.Time								= Time;
+	frame.Pivots.resize(world.GetBodyCount());
+	frame.Pivots.resize(world.GetPivots(frame.Pivots.data(), (uint32_t)frame.Pivots.size()));
+
+	lock.lock();
+	++QueuedCount;
+	lock.unlock();
+	FrameQueued.notify_one();
+	return true;
+}
+
+void									TrajectoryRecorder::WriterLoop			()																						{
+	::std::unique_lock<::std::mutex>			lock									(Mutex);
+	while (true) {
+		FrameQueued.wait(lock, [this]() { return QueuedCount || Stopping; });
+		if (0 == QueuedCount)	// Stopping, with every frame written.
+			break;
+		const Frame									& frame									= Frames[FirstQueued];
+		lock.unlock();
+		Encode(frame);
+		lock.lock();
+		FirstQueued								= (FirstQueued + 1) % Frames.size();
+		--QueuedCount;
+		FrameWritten.notify_one();
+	}
+	lock.unlock();
+	FlushChunk();
+}
+
+void									TrajectoryRecorder::Encode				(const Frame &frame)																	{
+	const uint32_t								bodyCount								= (uint32_t)frame.Pivots.size();
+	if (Chunk.FrameCount && (Chunk.FrameCount >= Settings.KeyframeInterval || bodyCount != Chunk.BodyCount))
+		FlushChunk();
+	const bool									isKeyframe								= 0 == Chunk.FrameCount;
+	if (isKeyframe) {
+		Chunk.BodyCount							= bodyCount;
+		Previous		.resize(bodyCount * TRAJECTORY_VALUES);
+		BeforePrevious	.resize(bodyCount * TRAJECTORY_VALUES);
+	}
+
+	const size_t								timeOffset								= Payload.size();
+	Payload.resize(timeOffset + sizeof(frame.Time));
+	memcpy(&Payload[timeOffset], &frame.Time, sizeof(frame.Time));
+	uint32_t									unchanged								= 0;	// Holds the number of bodies the prediction got right since the last one written.
+	for (uint32_t iBody = 0; iBody < bodyCount; ++iBody) {
+		int64_t										values	[TRAJECTORY_VALUES];
+		int64_t										* previous								= &Previous			[iBody * TRAJECTORY_VALUES];
+		int64_t										* beforePrevious						= &BeforePrevious	[iBody * TRAJECTORY_VALUES];
+		quantize(frame.Pivots[iBody], Settings, values);
+		if (isKeyframe) {
+			for (uint32_t iValue = 0; iValue < TRAJECTORY_VALUES; ++iValue) {
+				writeVarint(Payload, values[iValue]);
+				previous[iValue]						= beforePrevious[iValue]				= values[iValue];	// So the first prediction of the chunk is no motion.
+			}
+			continue;
+		}
+		int64_t										residuals	[TRAJECTORY_VALUES];
+		bool										predicted								= true;
+		for (uint32_t iValue = 0; iValue < TRAJECTORY_VALUES; ++iValue) {
+			residuals[iValue]						= values[iValue] - (2 * previous[iValue] - beforePrevious[iValue]);
+			predicted								= predicted && 0 == residuals[iValue];
+			beforePrevious[iValue]					= previous[iValue];
+			previous[iValue]						= values[iValue];
+		}
+		if (predicted) {
+			++unchanged;
+			continue;
+		}
+		writeVarint(Payload, unchanged);
+		unchanged								= 0;
+		for (uint32_t iValue = 0; iValue < TRAJECTORY_VALUES; ++iValue)
+			writeVarint(Payload, residuals[iValue]);
+	}
+	if (unchanged)
+		writeVarint(Payload, unchanged);
+	++Chunk.FrameCount;
+}
+
+void									TrajectoryRecorder::FlushChunk			()																						{
+	if (0 == Chunk.FrameCount)
+		return;
+	Chunk.Magic								= ChunkMagic;
+	Chunk.PayloadSize						= (uint32_t)Payload.size();
+	if (!HasFailed()) {
+		if (1 != fwrite(&Chunk, sizeof(Chunk), 1, File) || Payload.size() != fwrite(Payload.data(), 1, Payload.size(), File) || 0 != fflush(File))
+			Failed.store(true, ::std::memory_order_relaxed);
+		else {
+			BytesWritten	.fetch_add(sizeof(Chunk) + Payload.size()	, ::std::memory_order_relaxed);
+			FramesWritten	.fetch_add(Chunk.FrameCount					, ::std::memory_order_relaxed);
+		}
+	}
+	Chunk.FirstFrame						+= Chunk.FrameCount;
+	Chunk.FrameCount						= 0;
+	Payload.clear();
+}
+
+bool									TrajectoryReader::Open					(const char *fileName)																	{
+	Close();
+	File									= fopen(fileName, "rb");
+	if (0 == File)
+		return false;
+	if (1 != fread(&Header, sizeof(Header), 1, File) || Header.Magic != TrajectoryRecorder::Magic || Header.Version != TrajectoryRecorder::Version || Header.HeaderSize != sizeof(TrajectoryHeader)
+		|| !(Header.PositionPrecision > 0) || !(Header.OrientationPrecision > 0)
+		) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void									TrajectoryReader::Close					()																						{
+	if (File)
+		fclose(File);
+	File									= 0;
+	Header									= {};
+	Chunk									= {};
+	ChunkFrame								= 0;
+	Frame									= 0;
+	Time									= 0;
+}
+
+bool									TrajectoryReader::ReadChunk				()																						{
+	if (0 == File || 1 != fread(&Chunk, sizeof(Chunk), 1, File) || Chunk.Magic != TrajectoryRecorder::ChunkMagic || 0 == Chunk.FrameCount) {
+		Chunk									= {};
+		return false;
+	}
+	// Check the sizes against what they must hold before allocating anything, so a damaged chunk is refused instead of asking for gigabytes. Every frame holds its time,
+	// and the first one a value of at least a byte for each body. This also keeps the counts of values below 2^32.
+	const uint64_t								smallestPayload							= (uint64_t)Chunk.FrameCount * sizeof(Time) + (uint64_t)Chunk.BodyCount * TRAJECTORY_VALUES;
+	if (smallestPayload > Chunk.PayloadSize || Chunk.PayloadSize > remainingBytes(File)) {
+		Chunk									= {};
+		return false;
+	}
+	Payload.resize(Chunk.PayloadSize);
+	if (Chunk.PayloadSize != fread(Payload.data(), 1, Chunk.PayloadSize, File)) {
+		Chunk									= {};
+		return false;
+	}
+	Cursor									= 0;
+	ChunkFrame								= 0;
+	Previous		.resize(Chunk.BodyCount * TRAJECTORY_VALUES);
+	BeforePrevious	.resize(Chunk.BodyCount * TRAJECTORY_VALUES);
+	Positions		.resize(Chunk.BodyCount);
+	Orientations	.resize(Chunk.BodyCount);
+	return true;
+}
+
+bool									TrajectoryReader::NextFrame				()																						{
+	if (ChunkFrame >= Chunk.FrameCount && !ReadChunk())
+		return false;
+	if (Cursor + sizeof(Time) > Payload.size())
+		return false;
+	memcpy(&Time, &Payload[Cursor], sizeof(Time));
+	Cursor									+= sizeof(Time);
+
+	const uint32_t								bodyCount								= Chunk.BodyCount;
+	if (0 == ChunkFrame) {
+		for (uint32_t iValue = 0; iValue < bodyCount * TRAJECTORY_VALUES; ++iValue) {
+			if (!readVarint(Payload, Cursor, Previous[iValue]))
+				return false;
+			BeforePrevious[iValue]					= Previous[iValue];
+		}
+	}
+	else {
+		// Each run of bodies the prediction got right is followed by the residuals of a body it didn't get right, unless the run reaches the last body.
+		uint32_t									iBody									= 0;
+		while (iBody < bodyCount) {
+			int64_t										run;
+			if (!readVarint(Payload, Cursor, run) || run < 0 || run > bodyCount - iBody)
+				return false;
+			for (const uint32_t runEnd = iBody + (uint32_t)run; iBody < runEnd; ++iBody)
+				predict(&Previous[iBody * TRAJECTORY_VALUES], &BeforePrevious[iBody * TRAJECTORY_VALUES], 0);
+			if (iBody == bodyCount)
+				break;
+			int64_t										residuals	[TRAJECTORY_VALUES];
+			for (uint32_t iValue = 0; iValue < TRAJECTORY_VALUES; ++iValue)
+				if (!readVarint(Payload, Cursor, residuals[iValue]))
+					return false;
+			predict(&Previous[iBody * TRAJECTORY_VALUES], &BeforePrevious[iBody * TRAJECTORY_VALUES], residuals);
+			++iBody;
+		}
+	}
+
+	const double								positionStep							= Header.PositionPrecision;
+	const double								orientationStep							= Header.OrientationPrecision;
+	for (uint32_t iBody = 0; iBody < bodyCount; ++iBody) {
+		const int64_t								* values								= &Previous[iBody * TRAJECTORY_VALUES];
+		Positions	[iBody]						= {values[0] * positionStep, values[1] * positionStep, values[2] * positionStep};
+		Orientations[iBody]						= {values[3] * orientationStep, values[4] * orientationStep, values[5] * orientationStep, values[6] * orientationStep};
+	}
+	Frame									= Chunk.FirstFrame + ChunkFrame;
+	++ChunkFrame;
+	return true;
+}
+
+bool									TrajectoryReader::Seek					(uint64_t frame)																		{
+	if (0 == File || seekFile(File, sizeof(TrajectoryHeader), SEEK_SET))
+		return false;
+	TrajectoryChunk								chunk;
+	while (1 == fread(&chunk, sizeof(chunk), 1, File) && chunk.Magic == TrajectoryRecorder::ChunkMagic) {
+		if (frame < chunk.FirstFrame + chunk.FrameCount) {
+			if (frame < chunk.FirstFrame || seekFile(File, -(int64_t)sizeof(chunk), SEEK_CUR) || !ReadChunk())
+				return false;
+			for (uint64_t iFrame = chunk.FirstFrame; iFrame < frame; ++iFrame)
+				if (!NextFrame())
+					return false;
+			return true;
+		}
+		if (seekFile(File, chunk.PayloadSize, SEEK_CUR))
+			return false;
+	}
+	return false;
+}
@@ -0,0 +1,138 @@
+// This file contains the trajectory recorder, which streams the position and orientation of every body of a world at every step into a compact file from a background thread, and the reader that plays the file back frame by frame.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "body.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stdio.h>
+
+#ifndef CYCLONE_TRAJECTORY_H
+#define CYCLONE_TRAJECTORY_H
+
+namespace cyclone {
+	class World;
+
+	// Holds the settings of a recording.
+	struct TrajectorySettings {
+		double								PositionPrecision						= 1.0 / 4096;	// Holds the step the positions are rounded to, in metres.
+		double								OrientationPrecision					= 1.0 / 32768;	// Holds the step the components of the orientations are rounded to.
+		uint32_t							KeyframeInterval						= 120;	// Holds the number of frames of each chunk. Each chunk starts with a keyframe, so it can be read without the ones before it.
+		uint32_t							QueueLength								= 16;	// Holds the number of frames waiting for the writer thread before Capture has to wait for it.
+	};
+
+	// Holds the header found at the start of a recording. Chunks follow it up to the end of the file.
+	struct TrajectoryHeader {
+		uint32_t							Magic									= 0;
+		uint16_t							Version									= 0;
+		uint16_t							HeaderSize								= 0;
+		double								PositionPrecision						= 0;
+		double								OrientationPrecision					= 0;
+		uint32_t							KeyframeInterval						= 0;
+		uint32_t							Reserved								= 0;
+	};
+
+	// Holds the header of a chunk of a recording. The body count is the same for all the frames of a chunk, and a new chunk starts whenever it changes.
+	struct TrajectoryChunk {
+		uint32_t							Magic									= 0;
+		uint32_t							BodyCount								= 0;
+		uint64_t							FirstFrame								= 0;
+		uint32_t							FrameCount								= 0;
+		uint32_t							PayloadSize								= 0;
+	};
+
+	// Records the position and orientation of every body of a world at every step. Set it on the world with World::SetRecorder and it captures a frame at the end of each step, in the order of World::GetPivots.
+	// Capture only copies the state of the bodies into a queue. A writer thread rounds the values to the precision of the settings, encodes them and appends them to the file, so the simulation thread never waits for the disk unless the queue is full.
+	// The first frame of a chunk stores the rounded values. The other frames store the difference between them and a prediction that carries on the motion of the two frames before, as variable length integers, and runs of bodies the prediction
+	// gets exactly right, such as the ones at rest, take a single byte. Each chunk is written whole and flushed, so a recording cut short by a crash loses at most the chunk being filled.
+	class TrajectoryRecorder {
+		// Holds a frame waiting for the writer thread.
+		struct Frame {
+			double								Time									= 0;
+			::std::vector<SPivot3D>				Pivots									= {};
+		};
+
+		TrajectorySettings					Settings								= {};
+		FILE								* File									= 0;
+		::std::thread						Writer									;
+		::std::mutex						Mutex									;
+		::std::condition_variable			FrameQueued								;
+		::std::condition_variable			FrameWritten							;
+		::std::vector<Frame>				Frames									= {};	// Holds the queue, as a ring of QueueLength frames.
+		uint32_t							FirstQueued								= 0;
+		uint32_t							QueuedCount								= 0;
+		bool								Stopping								= false;
+		double								Time									= 0;	// Holds the sum of the durations of the captured steps.
+		::std::atomic<bool>					Failed									= {false};
+		::std::atomic<uint64_t>				BytesWritten							= {0};
+		::std::atomic<uint64_t>				FramesWritten							= {0};
+		uint64_t							Stalls									= 0;
+
+		// Hold the state of the encoder, used by the writer thread only.
+		::std::vector<uint8_t>				Payload									= {};
+		TrajectoryChunk						Chunk									= {};
+		::std::vector<int64_t>				Previous								= {};	// Holds the rounded values of the last frame, seven for each body.
+		::std::vector<int64_t>				BeforePrevious							= {};
+
+		void								WriterLoop								();
+		void								Encode									(const Frame &frame);
+		void								FlushChunk								();
+	public:
+		static constexpr	uint32_t		Magic									= 0x52545943;	// "CYTR"
+		static constexpr	uint32_t		ChunkMagic								= 0x43545943;	// "CYTC"
+		static constexpr	uint16_t		Version									= 1;
+
+											TrajectoryRecorder						()												{}
+											~TrajectoryRecorder						()												{ Close(); }
+											TrajectoryRecorder						(const TrajectoryRecorder &)					= delete;
+		TrajectoryRecorder&					operator=								(const TrajectoryRecorder &)					= delete;
+
+		bool								Open									(const char *fileName, const TrajectorySettings &settings = {});	// Creates the file and starts the writer thread. Returns false if the file can't be created or the settings are invalid.
+		bool								Close									();	// Writes the queued frames, stops the writer thread and closes the file. Returns false if anything failed to be written.
+		// Queues the state of the bodies of the given world after a step of the given duration. Waits for the writer thread if the queue is full. Returns false if the recorder isn't open or writing has failed.
+		bool								Capture									(const World &world, double duration);
+
+		inline	bool						IsOpen									()										const	{ return 0 != File;											}
+		inline	bool						HasFailed								()										const	{ return Failed.load(::std::memory_order_relaxed);			}
+		inline	uint64_t					GetBytesWritten							()										const	{ return BytesWritten.load(::std::memory_order_relaxed);	}
+		inline	uint64_t					GetFramesWritten						()										const	{ return FramesWritten.load(::std::memory_order_relaxed);	}
+		inline	uint64_t					GetStalls								()										const	{ return Stalls;											}	// Returns the number of captures that had to wait for the writer thread.
+	};
+
+	// Reads a recording frame by frame. Call NextFrame until it returns false, reading the bodies after each call. Seek jumps to any frame by reading the chunk headers only, and decoding from the keyframe of its chunk.
+	class TrajectoryReader {
+		FILE								* File									= 0;
+		TrajectoryHeader					Header									= {};
+		TrajectoryChunk						Chunk									= {};
+		::std::vector<uint8_t>				Payload									= {};
+		uint32_t							Cursor									= 0;	// Holds the offset of the next frame in the payload.
+		uint32_t							ChunkFrame								= 0;	// Holds the number of frames of the chunk read so far.
+		uint64_t							Frame									= 0;
+		double								Time									= 0;
+		::std::vector<int64_t>				Previous								= {};
+		::std::vector<int64_t>				BeforePrevious							= {};
+		::std::vector<Vector3>				Positions								= {};
+		::std::vector<Quaternion>			Orientations							= {};
+
+		bool								ReadChunk								();
+	public:
+											~TrajectoryReader						()												{ Close(); }
+
+		bool								Open									(const char *fileName);	// Returns false if the file can't be opened or isn't a recording.
+		void								Close									();
+		bool								NextFrame								();	// Decodes the next frame. Returns false at the end of the recording, or at a chunk that is damaged or was cut short.
+		bool								Seek									(uint64_t frame);	// Makes the next call to NextFrame decode the given frame. Returns false if the recording doesn't have it.
+
+		inline	const TrajectoryHeader&		GetHeader								()										const	{ return Header;							}
+		inline	uint64_t					GetFrame								()										const	{ return Frame;								}	// Returns the number of the frame decoded by the last call to NextFrame, counting from zero.
+		inline	double						GetTime									()										const	{ return Time;								}	// Returns the time of the frame, as the sum of the durations of the steps up to it.
+		inline	uint32_t					GetBodyCount							()										const	{ return (uint32_t)Positions.size();		}
+		inline	const Vector3*				GetPositions							()										const	{ return Positions.data();					}
+		inline	const Quaternion*			GetOrientations							()										const	{ return Orientations.data();				}
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_TRAJECTORY_H
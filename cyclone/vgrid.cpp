@@ -0,0 +1,220 @@
+// Implementation file for the velocity grid.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "vgrid.h"
+
+#include <utility>
+
+using namespace cyclone;
+
+// Returns the number of bytes between the current position of the file and its end, or UINT64_MAX if the file can't be seeked, such as a pipe.
+static	uint64_t						remainingBytes							(FILE *file)																				{
+#if defined(_WIN32)
+	const int64_t								position								= _ftelli64(file);
+	if (position < 0 || _fseeki64(file, 0, SEEK_END))
+		return UINT64_MAX;
+	const int64_t								end										= _ftelli64(file);
+	_fseeki64(file, position, SEEK_SET);
+#else
+	const int64_t								position								= ftello(file);
+	if (position < 0 || fseeko(file, 0, SEEK_END))
+		return UINT64_MAX;
+	const int64_t								end										= ftello(file);
+	fseeko(file, (off_t)position, SEEK_SET);
+#endif
+	return (end < position) ? 0 : (uint64_t)(end - position);
+}
+
+// Calculates the number of nodes of a grid of the given size. Returns false if an axis has no nodes or there would be more than MaxNodeCount. Both products fit, as each size is below 2^32 and the slice is checked before it is multiplied again.
+static	bool							countNodes								(uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, uint64_t &nodeCount)						{
+	const uint64_t								sliceSize								= (uint64_t)sizeX * sizeY;
+	if (0 == sliceSize || 0 == sizeZ || sliceSize > VelocityGrid::MaxNodeCount || sliceSize * sizeZ > VelocityGrid::MaxNodeCount)
+		return false;
+	nodeCount								= sliceSize * sizeZ;
+	return true;
+}
+
+bool									VelocityGrid::Resize					(const Vector3 &origin, double cellSize, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, const Vector3 &velocity)	{
+	uint64_t									nodeCount								= 0;
+	if (!countNodes(sizeX, sizeY, sizeZ, nodeCount))
+		return false;
+	Origin									= origin;
+	CellSize								= cellSize;
+	SizeX									= sizeX;
+	SizeY									= sizeY;
+	SizeZ									= sizeZ;
+	VelocityX.assign((size_t)nodeCount, velocity.x);
+	VelocityY.assign((size_t)nodeCount, velocity.y);
+	VelocityZ.assign((size_t)nodeCount, velocity.z);
+	return true;
+}
+
+void									VelocityGrid::BlendTowards				(const VelocityGrid &target, double fraction)																{
+	const uint32_t								nodeCount								= (uint32_t)VelocityX.size();
+	if (target.VelocityX.size() != nodeCount)
+		return;
+	for (uint32_t iNode = 0; iNode < nodeCount; ++iNode) {
+		VelocityX[iNode]						+= (target.VelocityX[iNode] - VelocityX[iNode]) * fraction;
+		VelocityY[iNode]						+= (target.VelocityY[iNode] - VelocityY[iNode]) * fraction;
+		VelocityZ[iNode]						+= (target.VelocityZ[iNode] - VelocityZ[iNode]) * fraction;
+	}
+}
+
+// Finds the cell along one axis that holds the given grid coordinate, clamped to the grid, and the position within the cell.
+static inline	void					locateAxis								(double coordinate, uint32_t size, uint32_t &node, double &fraction)										{
+	if (size < 2 || coordinate <= 0) {
+		node									= 0;
+		fraction								= 0;
+		return;
+	}
+	if (coordinate >= size - 1) {
+		node									= size - 2;
+		fraction								= 1;
+		return;
+	}
+	node									= (uint32_t)coordinate;
+	fraction								= coordinate - node;
+}
+
+Vector3									VelocityGrid::Sample					(const Vector3 &position)																	const	{
+	if (VelocityX.empty())
+		return {};
+	const double								inverseCellSize							= 1.0 / CellSize;
+	uint32_t									x, y, z;
+	double										fx, fy, fz;
+	locateAxis((position.x - Origin.x) * inverseCellSize, SizeX, x, fx);
+	locateAxis((position.y - Origin.y) * inverseCellSize, SizeY, y, fy);
+	locateAxis((position.z - Origin.z) * inverseCellSize, SizeZ, z, fz);
+
+	// The steps to the next node along each axis are zero for axes with a single node, so the same eight reads work for flat grids.
+	const uint32_t								stepX									= (SizeX > 1) ? 1 : 0;
+	const uint32_t								stepY									= (SizeY > 1) ? SizeX : 0;
+	const uint32_t								stepZ									= (SizeZ > 1) ? SizeX * SizeY : 0;
+	const uint32_t								node									= GetNodeIndex(x, y, z);
+	const double								weights	[8]								=
+		{ (1 - fx) * (1 - fy) * (1 - fz), fx * (1 - fy) * (1 - fz), (1 - fx) * fy * (1 - fz), fx * fy * (1 - fz)
+		, (1 - fx) * (1 - fy) * fz		, fx * (1 - fy) * fz		, (1 - fx) * fy * fz		, fx * fy * fz
+		};
+	const uint32_t								nodes	[8]								=
+		{ node					, node + stepX					, node + stepY					, node + stepX + stepY
+		, node + stepZ			, node + stepX + stepZ			, node + stepY + stepZ			, node + stepX + stepY + stepZ
+		};
+	Vector3										velocity								= {};
+	for (uint32_t iCorner = 0; iCorner < 8; ++iCorner) {
+		velocity.x								+= VelocityX[nodes[iCorner]] * weights[iCorner];
+		velocity.y								+= VelocityY[nodes[iCorner]] * weights[iCorner];
+		velocity.z								+= VelocityZ[nodes[iCorner]] * weights[iCorner];
+	}
+	return velocity;
+}
+
+// Interpolates one velocity component for a block of samples, from the first node and the weights of the eight corners of each.
+static inline	void					interpolateBlock						(const double *component, const uint32_t *nodes, const double (*weights)[8], const uint32_t (&steps)[8], double *output, uint32_t count)	{
+	for (uint32_t iSample = 0; iSample < count; ++iSample) {
+		const double								* corner								= component + nodes[iSample];
+		const double								* weight								= weights[iSample];
+		output[iSample]							= corner[steps[0]] * weight[0] + corner[steps[1]] * weight[1] + corner[steps[2]] * weight[2] + corner[steps[3]] * weight[3]
+			+ corner[steps[4]] * weight[4] + corner[steps[5]] * weight[5] + corner[steps[6]] * weight[6] + corner[steps[7]] * weight[7];
+	}
+}
+
+void									VelocityGrid::Sample					(const Vector3 *positions, Vector3 *velocities, uint32_t count)								const	{
+	if (VelocityX.empty()) {
+		for (uint32_t iSample = 0; iSample < count; ++iSample)
+			velocities[iSample]						= {};
+		return;
+	}
+	// The layout of the grid is worked out once for all the samples. The cells and weights of a block of samples are found first, then each component is interpolated for the whole block from its own array.
+	static constexpr	uint32_t			blockSize								= 64;
+	const double								inverseCellSize							= 1.0 / CellSize;
+	const uint32_t								stepX									= (SizeX > 1) ? 1 : 0;
+	const uint32_t								stepY									= (SizeY > 1) ? SizeX : 0;
+	const uint32_t								stepZ									= (SizeZ > 1) ? SizeX * SizeY : 0;
+	const uint32_t								steps	[8]								= {0, stepX, stepY, stepX + stepY, stepZ, stepX + stepZ, stepY + stepZ, stepX + stepY + stepZ};
+	uint32_t									nodes	[blockSize];
+	double										weights	[blockSize][8];
+	double										output	[3][blockSize];
+	for (uint32_t iBlock = 0; iBlock < count; iBlock += blockSize) {
+		const uint32_t								blockLength								= (count - iBlock < blockSize) ? count - iBlock : blockSize;
+		for (uint32_t iSample = 0; iSample < blockLength; ++iSample) {
+			const Vector3								& position								= positions[iBlock + iSample];
+			uint32_t									x, y, z;
+			double										fx, fy, fz;
+			locateAxis((position.x - Origin.x) * inverseCellSize, SizeX, x, fx);
+			locateAxis((position.y - Origin.y) * inverseCellSize, SizeY, y, fy);
+			locateAxis((position.z - Origin.z) * inverseCellSize, SizeZ, z, fz);
+			nodes[iSample]							= GetNodeIndex(x, y, z);
+			double										* weight								= weights[iSample];
+			const double								gx										= 1 - fx;
+			const double								gy										= 1 - fy;
+			const double								gz										= 1 - fz;
+			weight[0]								= gx * gy * gz;
+			weight[1]								= fx * gy * gz;
+			weight[2]								= gx * fy * gz;
+			weight[3]								= fx * fy * gz;
+			weight[4]								= gx * gy * fz;
+			weight[5]								= fx * gy * fz;
+			weight[6]								= gx * fy * fz;
+			weight[7]								= fx * fy * fz;
+		}
+		interpolateBlock(VelocityX.data(), nodes, weights, steps, output[0], blockLength);
+		interpolateBlock(VelocityY.data(), nodes, weights, steps, output[1], blockLength);
+		interpolateBlock(VelocityZ.data(), nodes, weights, steps, output[2], blockLength);
+		for (uint32_t iSample = 0; iSample < blockLength; ++iSample)
+			velocities[iBlock + iSample]			= {output[0][iSample], output[1][iSample], output[2][iSample]};
+	}
+}
+
+bool									VelocityGrid::Save						(FILE *file)																				const	{
+	GridFileHeader								header									= {};
+	header.Magic							= FileMagic;
+	header.Version							= FileVersion;
+	header.Size[0]							= SizeX;
+	header.Size[1]							= SizeY;
+	header.Size[2]							= SizeZ;
+	header.Origin[0]						= Origin.x;
+	header.Origin[1]						= Origin.y;
+	header.Origin[2]						= Origin.z;
+	header.CellSize							= CellSize;
+	if (1 != fwrite(&header, sizeof(GridFileHeader), 1, file))
+		return false;
+	for (uint32_t iNode = 0; iNode < VelocityX.size(); ++iNode) {
+		const double								velocity	[3]							= {VelocityX[iNode], VelocityY[iNode], VelocityZ[iNode]};
+		if (3 != fwrite(velocity, sizeof(double), 3, file))
+			return false;
+	}
+	return true;
+}
+
+bool									VelocityGrid::Load						(FILE *file)																						{
+	GridFileHeader								header									= {};
+	if (1 != fread(&header, sizeof(GridFileHeader), 1, file) || header.Magic != FileMagic || header.Version != FileVersion)
+		return false;
+	if (!(header.CellSize > 0))
+		return false;
+	uint64_t									nodeCount								= 0;
+	if (!countNodes(header.Size[0], header.Size[1], header.Size[2], nodeCount) || remainingBytes(file) < nodeCount * 3 * sizeof(double))	// Refuse a header claiming more nodes than the file holds before allocating them.
+		return false;
+	VelocityGrid								loaded									= {};
+	if (!loaded.Resize({header.Origin[0], header.Origin[1], header.Origin[2]}, header.CellSize, header.Size[0], header.Size[1], header.Size[2]))
+		return false;
+	if (!loaded.LoadSlices(file, 0, loaded.SizeZ))
+		return false;
+	*this									= ::std::move(loaded);
+	return true;
+}
+
+bool									VelocityGrid::LoadSlices				(FILE *file, uint32_t firstZ, uint32_t countZ)														{
+	if (firstZ > SizeZ || countZ > SizeZ - firstZ || VelocityX.size() != (uint64_t)SizeX * SizeY * SizeZ)	// The second check also catches sizes set without Resize.
+		return false;
+	const uint32_t								sliceSize								= SizeX * SizeY;	// Fits, as the node count matches the sizes and Resize keeps it below MaxNodeCount.
+	double										velocity	[3]							= {};
+	for (uint32_t iNode = firstZ * sliceSize; iNode < (firstZ + countZ) * sliceSize; ++iNode) {
+		if (3 != fread(velocity, sizeof(double), 3, file))
+			return false;
+		VelocityX[iNode]						= velocity[0];
+		VelocityY[iNode]						= velocity[1];
+		VelocityZ[iNode]						= velocity[2];
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+// This file contains the velocity grid: a field of wind or water velocities sampled on a regular grid, for forces that depend on a velocity that changes across the world.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "core.h"
+
+#include <vector>
+#include <cstdio>
+
+#ifndef CYCLONE_VGRID_H
+#define CYCLONE_VGRID_H
+
+namespace cyclone {
+	// Holds a velocity at each node of a regular grid, and interpolates between the nodes. Positions outside the grid take the velocity of the closest point on its border.
+	// The nodes are stored with x varying fastest and z slowest, so a range of z slices is contiguous and the grid can be updated a few slices at a time while it is being used.
+	// The file format is a GridFileHeader followed by the velocity of each node in that order, as three doubles.
+	struct VelocityGrid {
+		typedef	::std::vector<double>		TReals;
+
+		// Holds the description of a grid at the start of a file.
+		struct GridFileHeader {
+			uint32_t							Magic					= 0;	// Holds FileMagic.
+			uint32_t							Version					= 0;	// Holds FileVersion.
+			uint32_t							Size	[3]				= {};
+			double								Origin	[3]				= {};
+			double								CellSize				= 0;
+		};
+		static constexpr	uint32_t		FileMagic				= 0x52475643U;	// "CVGR"
+		static constexpr	uint32_t		FileVersion				= 1;
+		static constexpr	uint32_t		MaxNodeCount			= 1U << 26;	// Holds the largest number of nodes a grid can have, which keeps the node indices and the memory of a grid read from a damaged file in bounds.
+
+		Vector3								Origin					= {};	// Holds the position of the first node.
+		double								CellSize				= 1;	// Holds the distance between neighbouring nodes along each axis.
+		uint32_t							SizeX					= 0;	// Holds the number of nodes along each axis.
+		uint32_t							SizeY					= 0;
+		uint32_t							SizeZ					= 0;
+		TReals								VelocityX				= {};
+		TReals								VelocityY				= {};
+		TReals								VelocityZ				= {};
+
+		// Sets the layout of the grid. Every node is set to the given velocity. Returns false, leaving the grid unchanged, if an axis has no nodes or the grid would have more than MaxNodeCount.
+		bool								Resize					(const Vector3 &origin, double cellSize, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ, const Vector3 &velocity = {});
+
+		inline	uint32_t					GetNodeIndex			(uint32_t x, uint32_t y, uint32_t z)								const	{ return (z * SizeY + y) * SizeX + x; }
+		inline	Vector3						GetNode					(uint32_t x, uint32_t y, uint32_t z)								const	{ const uint32_t node = GetNodeIndex(x, y, z); return {VelocityX[node], VelocityY[node], VelocityZ[node]}; }
+		inline	void						SetNode					(uint32_t x, uint32_t y, uint32_t z, const Vector3 &velocity)				{ const uint32_t node = GetNodeIndex(x, y, z); VelocityX[node] = velocity.x; VelocityY[node] = velocity.y; VelocityZ[node] = velocity.z; }
+		// Moves each node the given fraction of the way towards the velocity of the same node in the target grid, which must have the same size. Use this to ease between weather states rather than switching at once.
+		void								BlendTowards			(const VelocityGrid &target, double fraction);
+
+		Vector3								Sample					(const Vector3 &position)											const;	// Returns the velocity at the given position, interpolated between the eight surrounding nodes.
+		void								Sample					(const Vector3 *positions, Vector3 *velocities, uint32_t count)		const;	// Samples the velocity at each of the given positions, finding the cells of a block of positions before interpolating each component over the block.
+
+		bool								Save					(FILE *file)														const;	// Writes the header and all the nodes. Returns false if the file couldn't be written.
+		bool								Load					(FILE *file);	// Reads a header and all the nodes, resizing the grid. Returns false, leaving the grid unchanged, if the file doesn't hold a grid.
+		// Reads the given range of z slices of nodes from the current position of the file, which must be laid out like the nodes of this grid. This streams a new state into the grid a piece at a time.
+		// Returns false if the range is outside the grid or the file ended early. The slices read before the error are kept.
+		bool								LoadSlices				(FILE *file, uint32_t firstZ, uint32_t countZ);
+	};
+} // namespace cyclone
+
+#endif // CYCLONE_VGRID_H
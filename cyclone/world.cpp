@@ -1,10 +1,60 @@
 // Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "world.h"
+#include "profile.h"
+#include "trajectory.h"
+
+#include <algorithm>
+#include <string.h>
 
 using namespace cyclone;
 
+										World::~World					()									{
+	while (FirstBody) {
+		BodyRegistration							* next							= FirstBody->Next;
+		delete FirstBody;
+		FirstBody								= next;
+	}
+	while (FirstContactGen) {
+		ContactGenRegistration						* next							= FirstContactGen->Next;
+		delete FirstContactGen;
+		FirstContactGen							= next;
+	}
+	if (Contacts)
+		delete[] Contacts;
+}
+
+void									World::AddBody					(RigidBody *body)					{
+	BodyRegistration							* reg							= new BodyRegistration();
+	reg->Body								= body;
+	body->Id								= BodyCount++;
+	body->Mass.LinearDampingClass			= Dampings.AddClass(body->Mass.LinearDamping);
+	body->Mass.AngularDampingClass			= Dampings.AddClass(body->Mass.AngularDamping);
+	reg->PreviousPosition					= body->Pivot.Position;
+	reg->PreviousOrientation				= body->Pivot.Orientation;
+	reg->Next								= FirstBody;
+	FirstBody								= reg;
+}
+
+bool									World::SetBodyDamping			(RigidBody &body, uint16_t linearClass, uint16_t angularClass)	{
+	if (linearClass >= Dampings.Size() || angularClass >= Dampings.Size())
+		return false;
+	body.Mass.LinearDamping					= Dampings.Dampings[linearClass];
+	body.Mass.AngularDamping				= Dampings.Dampings[angularClass];
+	body.Mass.LinearDampingClass			= linearClass;
+	body.Mass.AngularDampingClass			= angularClass;
+	return true;
+}
+
+void									World::AddContactGenerator		(ContactGenerator *generator)		{
+	ContactGenRegistration						* reg							= new ContactGenRegistration();
+	reg->Generator							= generator;
+	reg->Next								= FirstContactGen;
+	FirstContactGen							= reg;
+}
+
 void									World::StartFrame				()									{
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_START_FRAME);
 	BodyRegistration							* reg							= FirstBody;
 	while (reg) {
 		// Remove all forces from the accumulator
@@ -14,7 +64,22 @@ void									World::StartFrame				()									{
 	}
 }
 
+// Orders contacts by the ids of their bodies, with contacts against the scenery last, and then by their point, normal and penetration. None of these depend on where the bodies are in memory or on which generator found the contact.
+static	bool							contactPrecedes					(const Contact &a, const Contact &b)	{
+	const uint32_t								keysA	[2]						= {a.Body[0] ? a.Body[0]->Id : UINT32_MAX, a.Body[1] ? a.Body[1]->Id : UINT32_MAX};
+	const uint32_t								keysB	[2]						= {b.Body[0] ? b.Body[0]->Id : UINT32_MAX, b.Body[1] ? b.Body[1]->Id : UINT32_MAX};
+	if (keysA[0] != keysB[0]) return keysA[0] < keysB[0];
+	if (keysA[1] != keysB[1]) return keysA[1] < keysB[1];
+	const double								valuesA	[]						= {a.ContactPoint.x, a.ContactPoint.y, a.ContactPoint.z, a.ContactNormal.x, a.ContactNormal.y, a.ContactNormal.z, a.Penetration};
+	const double								valuesB	[]						= {b.ContactPoint.x, b.ContactPoint.y, b.ContactPoint.z, b.ContactNormal.x, b.ContactNormal.y, b.ContactNormal.z, b.Penetration};
+	for (uint32_t iValue = 0; iValue < sizeof(valuesA) / sizeof(valuesA[0]); ++iValue)
+		if (valuesA[iValue] != valuesB[iValue])
+			return valuesA[iValue] < valuesB[iValue];
+	return false;
+}
+
 uint32_t								World::GenerateContacts			()									{
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_GENERATE_CONTACTS);
 	uint32_t									limit							= MaxContacts;
 	Contact										* nextContact					= Contacts;
 
@@ -23,24 +88,337 @@ uint32_t								World::GenerateContacts			()									{
 		uint32_t									used							= reg->Generator->AddContact(nextContact, limit);
 		limit									-= used;
 		nextContact								+= used;
-		if (limit <= 0)		// We've run out of contacts to fill. This means we're missing contacts.
+		if (limit <= 0) {	// We've run out of contacts to fill. This means we're missing contacts.
+#ifdef CYCLONE_PROFILE
+			uint32_t									skipped							= 0;	// The generators left uncalled.
+			for (const ContactGenRegistration * left = reg->Next; left; left = left->Next)
+				++skipped;
+			CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_GENERATORS_SKIPPED, skipped);
+#endif
 			break;
+		}
 		reg										= reg->Next;
 	}
+	CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_CONTACTS_GENERATED, MaxContacts - limit);
+	if (Deterministic)
+		::std::stable_sort(Contacts, nextContact, contactPrecedes);
 	return MaxContacts - limit;	// Return the number of contacts used.
 }
 
+uint64_t								World::GetStateHash				()									const	{
+	uint64_t									hash							= 14695981039346656037ULL;	// FNV-1a
+	for (const BodyRegistration * reg = FirstBody; reg; reg = reg->Next) {
+		const RigidBody								& body							= *reg->Body;
+		const double								state	[]						=
+			{ body.Pivot.Position.x, body.Pivot.Position.y, body.Pivot.Position.z
+			, body.Pivot.Orientation.r, body.Pivot.Orientation.i, body.Pivot.Orientation.j, body.Pivot.Orientation.k
+			, body.Force.Velocity.x, body.Force.Velocity.y, body.Force.Velocity.z
+			, body.Force.Rotation.x, body.Force.Rotation.y, body.Force.Rotation.z
+			, body.IsAwake ? 1.0 : 0.0
+			};
+		uint8_t										bytes	[sizeof(state)];
+		memcpy(bytes, state, sizeof(state));	// Hash the bits, so the hash tells apart values that compare equal, like 0 and -0.
+		for (uint32_t iByte = 0; iByte < sizeof(bytes); ++iByte)
+			hash									= (hash ^ bytes[iByte]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Returns the factor of the given damping for the duration of the table. The class is checked against the damping, as it may have been changed on the body since it was classified, and the body is moved to the class of its new value.
+// Bodies the full table has no class for get the factor of their own damping, so they are damped exactly as asked, only more slowly.
+static inline		double				dampingFactor					(DampingTable &dampings, uint16_t &dampingClass, double damping)	{
+	if (dampingClass < dampings.Size() && dampings.Dampings[dampingClass] == damping)
+		return dampings.Factors[dampingClass];
+	if (dampingClass != DampingTable::InvalidClass || dampings.Size() < DampingTable::MaxClasses)
+		dampingClass							= dampings.AddClass(damping);
+	return (dampingClass == DampingTable::InvalidClass) ? real_pow(damping, dampings.Duration) : dampings.Factors[dampingClass];
+}
+
 void									World::RunPhysics				(double duration)					{
+	CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_STEP);
 	//registry.UpdateForces(duration);	// First apply the force generators
 	// Then integrate the objects
-	BodyRegistration							* reg							= FirstBody;
-	while (reg) {
-		reg->Body->Integrate(duration);	// Remove all forces from the accumulator
-		reg										= reg->Next;	// Get the next registration
+	{
+		CYCLONE_PROFILE_SCOPE(PROFILE_SCOPE_INTEGRATE);
+		Dampings.Update(duration);	// Only calculates anything when the duration changes, which with a fixed step is never after the first step.
+		const double								motionBias						= Dampings.GetFactor(MotionBiasClass);
+		BodyRegistration							* reg							= FirstBody;
+		while (reg) {
+			RigidBody									& body							= *reg->Body;
+			CYCLONE_PROFILE_COUNT(PROFILE_COUNTER_AWAKE_BODIES, body.IsAwake ? 1 : 0);
+			const double								linearFactor					= dampingFactor(Dampings, body.Mass.LinearDampingClass	, body.Mass.LinearDamping	);
+			const double								angularFactor					= dampingFactor(Dampings, body.Mass.AngularDampingClass	, body.Mass.AngularDamping	);
+			body.Integrate(duration, linearFactor, angularFactor, motionBias);	// Remove all forces from the accumulator
+			reg										= reg->Next;	// Get the next registration
+		}
 	}
 	uint32_t									usedContacts					= GenerateContacts();	// Generate contacts
 	// And process them
 	if (CalculateIterations) 
 		Resolver.setIterations(usedContacts * 4);
 	Resolver.resolveContacts(Contacts, usedContacts, duration);
+	if (Recorder)
+		Recorder->Capture(*this, duration);
+}
+
+uint32_t								World::GetPivots				(SPivot3D *pivots, uint32_t maxCount)	const	{
+	uint32_t									count							= 0;
+	for (const BodyRegistration * reg = FirstBody; reg && count < maxCount; reg = reg->Next)
+		pivots[count++]							= reg->Body->Pivot;
+	return count;
+}
+
+bool									World::SetFixedStep				(double stepDuration, uint32_t maxSteps)	{
+	if (stepDuration <= 0 || 0 == maxSteps)
+		return false;
+	StepDuration							= stepDuration;
+	MaxSteps								= maxSteps;
+	Accumulator								= real_fmod(Accumulator, stepDuration);
+	return true;
+}
+
+uint32_t								World::Advance					(double frameDuration)				{
+	if (frameDuration > 0)
+		Accumulator								+= frameDuration;
+	for (BodyRegistration * reg = FirstBody; reg; reg = reg->Next) {
+		reg->FrameForce							= reg->Body->AccumulatedForce;
+		reg->FrameTorque						= reg->Body->AccumulatedTorque;
+	}
+	uint32_t									steps							= 0;
+	while (Accumulator >= StepDuration && steps < MaxSteps) {
+		for (BodyRegistration * reg = FirstBody; reg; reg = reg->Next) {
+			RigidBody									& body							= *reg->Body;
+			reg->PreviousPosition					= body.Pivot.Position;
+			reg->PreviousOrientation				= body.Pivot.Orientation;
+			if (steps) {	// Integrate cleared the forces of the frame.
+				body.AccumulatedForce					= reg->FrameForce;
+				body.AccumulatedTorque					= reg->FrameTorque;
+			}
+		}
+		RunPhysics(StepDuration);
+		Accumulator								-= StepDuration;
+		++steps;
+	}
+	if (Accumulator >= StepDuration) {	// Drop the steps that didn't fit, keeping the fraction of a step for the interpolation.
+		const double								kept							= real_fmod(Accumulator, StepDuration);
+		DroppedTime								+= Accumulator - kept;
+		Accumulator								= kept;
+	}
+	return steps;
+}
+
+uint32_t								World::GetInterpolatedTransforms	(Matrix4 *transforms, uint32_t maxCount)	const	{
+	const double								alpha							= GetInterpolationAlpha();
+	uint32_t									count							= 0;
+	for (const BodyRegistration * reg = FirstBody; reg && count < maxCount; reg = reg->Next, ++count) {
+		const SPivot3D								& current						= reg->Body->Pivot;
+		const Vector3								position						= reg->PreviousPosition * (1 - alpha) + current.Position * alpha;
+		const Quaternion							& previous						= reg->PreviousOrientation;
+		const double								sign							= (previous.r * current.Orientation.r + previous.i * current.Orientation.i + previous.j * current.Orientation.j + previous.k * current.Orientation.k < 0) ? -1 : 1;	// Blend along the shorter arc.
+		Quaternion									orientation						=
+			{ previous.r * (1 - alpha) + current.Orientation.r * alpha * sign
+			, previous.i * (1 - alpha) + current.Orientation.i * alpha * sign
+			, previous.j * (1 - alpha) + current.Orientation.j * alpha * sign
+			, previous.k * (1 - alpha) + current.Orientation.k * alpha * sign
+			};
+		orientation.normalise();
+		transforms[count].setOrientationAndPos(orientation, position);
+	}
+	return count;
+}
+
+// Holds the header of a snapshot. The world values and the body records follow it.
+struct SnapshotHeader {
+	uint32_t								Magic							;
+	uint16_t								Version							;
+	uint16_t								IsDelta							;
+	uint32_t								BodyCount						;
+	uint32_t								BodyWords						;
+	uint64_t								Id								;	// Holds the number of the snapshot for full ones, and of their baseline for deltas.
+};
+
+static constexpr	uint32_t			SNAPSHOT_MAGIC					= 0x53574359;	// "CYWS"
+static constexpr	uint32_t			SNAPSHOT_WORLD_WORDS			= 2 + RandomStream::StateWords;
+static constexpr	uint32_t			SNAPSHOT_BODY_WORDS				= 34;	// Must stay below 64, as deltas mark the changed values of a body with the bits of a word.
+
+static inline		uint64_t			wordOf							(double value)						{ uint64_t word; memcpy(&word, &value, sizeof(word)); return word; }
+static inline		double				realOf							(uint64_t word)						{ double value; memcpy(&value, &word, sizeof(value)); return value; }
+
+static				void				saveBody						(const RigidBody &body, const Vector3 &previousPosition, const Quaternion &previousOrientation, uint64_t *words)	{
+	const double								values	[SNAPSHOT_BODY_WORDS - 1]	=
+		{ body.Pivot.Position.x, body.Pivot.Position.y, body.Pivot.Position.z
+		, body.Pivot.Orientation.r, body.Pivot.Orientation.i, body.Pivot.Orientation.j, body.Pivot.Orientation.k
+		, body.Force.Velocity.x, body.Force.Velocity.y, body.Force.Velocity.z
+		, body.Force.Rotation.x, body.Force.Rotation.y, body.Force.Rotation.z
+		, body.Force.Acceleration.x, body.Force.Acceleration.y, body.Force.Acceleration.z
+		, body.LastFrameAcceleration.x, body.LastFrameAcceleration.y, body.LastFrameAcceleration.z
+		, body.AccumulatedForce.x, body.AccumulatedForce.y, body.AccumulatedForce.z
+		, body.AccumulatedTorque.x, body.AccumulatedTorque.y, body.AccumulatedTorque.z
+		, body.Motion
+		, previousPosition.x, previousPosition.y, previousPosition.z
+		, previousOrientation.r, previousOrientation.i, previousOrientation.j, previousOrientation.k
+		};
+	for (uint32_t iWord = 0; iWord < SNAPSHOT_BODY_WORDS - 1; ++iWord)
+		words[iWord]							= wordOf(values[iWord]);
+	words[SNAPSHOT_BODY_WORDS - 1]			= (body.IsAwake ? 1 : 0) | (body.CanSleep ? 2 : 0);
+}
+
+static				void				loadBody						(const uint64_t *words, RigidBody &body, Vector3 &previousPosition, Quaternion &previousOrientation)	{
+	double										values	[SNAPSHOT_BODY_WORDS - 1];
+	for (uint32_t iWord = 0; iWord < SNAPSHOT_BODY_WORDS - 1; ++iWord)
+		values[iWord]							= realOf(words[iWord]);
+	body.Pivot.Position						= {values[0], values[1], values[2]};
+	body.Pivot.Orientation					= {values[3], values[4], values[5], values[6]};
+	body.Force.Velocity						= {values[7], values[8], values[9]};
+	body.Force.Rotation						= {values[10], values[11], values[12]};
+	body.Force.Acceleration					= {values[13], values[14], values[15]};
+	body.LastFrameAcceleration				= {values[16], values[17], values[18]};
+	body.AccumulatedForce					= {values[19], values[20], values[21]};
+	body.AccumulatedTorque					= {values[22], values[23], values[24]};
+	body.Motion								= values[25];
+	previousPosition						= {values[26], values[27], values[28]};
+	previousOrientation						= {values[29], values[30], values[31], values[32]};
+	body.IsAwake							= 0 != (words[SNAPSHOT_BODY_WORDS - 1] & 1);
+	body.CanSleep							= 0 != (words[SNAPSHOT_BODY_WORDS - 1] & 2);
+	body.CalculateTransforms();	// The saved orientation is already normalised, and normalising it again could change its last bits.
+}
+
+// Returns the body records of the given full snapshot of a world with the given number of bodies, or NULL if it isn't one.
+static				const uint8_t*		fullSnapshotBodies				(const uint8_t *snapshot, uint32_t size, uint32_t bodyCount)	{
+	SnapshotHeader								header;
+	const uint32_t								expected						= (uint32_t)(sizeof(SnapshotHeader) + (SNAPSHOT_WORLD_WORDS + bodyCount * SNAPSHOT_BODY_WORDS) * sizeof(uint64_t));
+	if (0 == snapshot || size != expected)
+		return 0;
+	memcpy(&header, snapshot, sizeof(header));
+	if (header.Magic != SNAPSHOT_MAGIC || header.Version != World::SnapshotVersion || header.IsDelta || header.BodyCount != bodyCount || header.BodyWords != SNAPSHOT_BODY_WORDS)
+		return 0;
+	return snapshot + sizeof(SnapshotHeader) + SNAPSHOT_WORLD_WORDS * sizeof(uint64_t);
+}
+
+uint32_t								World::GetSnapshotSize			()									const	{ return (uint32_t)(sizeof(SnapshotHeader) + (SNAPSHOT_WORLD_WORDS + BodyCount * SNAPSHOT_BODY_WORDS) * sizeof(uint64_t)); }
+uint32_t								World::GetMaxDeltaSize			()									const	{ return (uint32_t)(sizeof(SnapshotHeader) + (SNAPSHOT_WORLD_WORDS + BodyCount * (SNAPSHOT_BODY_WORDS + 1)) * sizeof(uint64_t)); }
+
+uint32_t								World::Snapshot					(uint8_t *buffer, uint32_t size, const uint8_t *baseline, uint32_t baselineSize)	const	{
+	const uint8_t								* baselineBodies				= 0;
+	SnapshotHeader								header							= {SNAPSHOT_MAGIC, SnapshotVersion, 0, BodyCount, SNAPSHOT_BODY_WORDS, 0};
+	if (baseline) {
+		baselineBodies							= fullSnapshotBodies(baseline, baselineSize, BodyCount);
+		if (0 == baselineBodies)
+			return 0;
+		SnapshotHeader								baselineHeader;
+		memcpy(&baselineHeader, baseline, sizeof(baselineHeader));
+		header.IsDelta							= 1;
+		header.Id								= baselineHeader.Id;
+	}
+	// A delta is checked for space body by body below, as a body whose every value changed takes a word more than in a full snapshot.
+	if (0 == buffer || size < (baseline ? sizeof(SnapshotHeader) + SNAPSHOT_WORLD_WORDS * sizeof(uint64_t) : GetSnapshotSize()))
+		return 0;
+	if (0 == baseline)
+		header.Id								= ++SnapshotCount;
+
+	uint8_t										* cursor						= buffer;
+	memcpy(cursor, &header, sizeof(header));
+	cursor									+= sizeof(header);
+	uint64_t									worldWords	[SNAPSHOT_WORLD_WORDS]	= {wordOf(Accumulator), wordOf(DroppedTime)};
+	Generator.SaveState(&worldWords[2]);
+	memcpy(cursor, worldWords, sizeof(worldWords));
+	cursor									+= sizeof(worldWords);
+
+	uint64_t									words	[SNAPSHOT_BODY_WORDS];
+	uint32_t									iBody							= 0;
+	for (const BodyRegistration * reg = FirstBody; reg; reg = reg->Next, ++iBody) {
+		saveBody(*reg->Body, reg->PreviousPosition, reg->PreviousOrientation, words);
+		if (0 == baselineBodies) {
+			memcpy(cursor, words, sizeof(words));
+			cursor									+= sizeof(words);
+			continue;
+		}
+		uint64_t									baseWords	[SNAPSHOT_BODY_WORDS];
+		memcpy(baseWords, baselineBodies + iBody * sizeof(baseWords), sizeof(baseWords));
+		uint64_t									mask							= 0;
+		uint32_t									changedCount					= 0;
+		for (uint32_t iWord = 0; iWord < SNAPSHOT_BODY_WORDS; ++iWord)
+			if (words[iWord] != baseWords[iWord]) {
+				mask									|= 1ULL << iWord;
+				words[changedCount++]					= words[iWord];	// Packs the changed values at the front, never overwriting a value not yet compared.
+			}
+		if ((size_t)(buffer + size - cursor) < (1 + changedCount) * sizeof(uint64_t))
+			return 0;
+		memcpy(cursor, &mask, sizeof(mask));
+		cursor									+= sizeof(mask);
+		memcpy(cursor, words, changedCount * sizeof(uint64_t));
+		cursor									+= changedCount * sizeof(uint64_t);
+	}
+	return (uint32_t)(cursor - buffer);
+}
+
+bool									World::Restore					(const uint8_t *snapshot, uint32_t size, const uint8_t *baseline, uint32_t baselineSize)	{
+	SnapshotHeader								header;
+	if (0 == snapshot || size < sizeof(header) + SNAPSHOT_WORLD_WORDS * sizeof(uint64_t))
+		return false;
+	memcpy(&header, snapshot, sizeof(header));
+	if (header.Magic != SNAPSHOT_MAGIC || header.Version != SnapshotVersion || header.BodyCount != BodyCount || header.BodyWords != SNAPSHOT_BODY_WORDS)
+		return false;
+
+	const uint8_t								* baselineBodies				= 0;
+	if (header.IsDelta) {
+		baselineBodies							= fullSnapshotBodies(baseline, baselineSize, BodyCount);
+		if (0 == baselineBodies)
+			return false;
+		SnapshotHeader								baselineHeader;
+		memcpy(&baselineHeader, baseline, sizeof(baselineHeader));
+		if (baselineHeader.Id != header.Id)
+			return false;
+		// Check the size of every record before changing anything.
+		const uint8_t								* cursor						= snapshot + sizeof(header) + SNAPSHOT_WORLD_WORDS * sizeof(uint64_t);
+		const uint8_t								* end							= snapshot + size;
+		for (uint32_t iBody = 0; iBody < BodyCount; ++iBody) {
+			uint64_t									mask;
+			if ((size_t)(end - cursor) < sizeof(mask))
+				return false;
+			memcpy(&mask, cursor, sizeof(mask));
+			if (mask >> SNAPSHOT_BODY_WORDS)
+				return false;
+			uint32_t									changed							= 0;
+			for (uint64_t bits = mask; bits; bits &= bits - 1)
+				++changed;
+			cursor									+= sizeof(mask) + changed * sizeof(uint64_t);
+			if (cursor > end)
+				return false;
+		}
+		if (cursor != end)
+			return false;
+	}
+	else if (size != GetSnapshotSize())
+		return false;
+
+	const uint8_t								* cursor						= snapshot + sizeof(header);
+	uint64_t									worldWords	[SNAPSHOT_WORLD_WORDS];
+	memcpy(worldWords, cursor, sizeof(worldWords));
+	cursor									+= sizeof(worldWords);
+	Accumulator								= realOf(worldWords[0]);
+	DroppedTime								= realOf(worldWords[1]);
+	Generator.LoadState(&worldWords[2]);
+
+	uint64_t									words	[SNAPSHOT_BODY_WORDS];
+	uint32_t									iBody							= 0;
+	for (BodyRegistration * reg = FirstBody; reg; reg = reg->Next, ++iBody) {
+		if (0 == baselineBodies) {
+			memcpy(words, cursor, sizeof(words));
+			cursor									+= sizeof(words);
+		}
+		else {
+			memcpy(words, baselineBodies + iBody * sizeof(words), sizeof(words));
+			uint64_t									mask;
+			memcpy(&mask, cursor, sizeof(mask));
+			cursor									+= sizeof(mask);
+			for (uint32_t iWord = 0; iWord < SNAPSHOT_BODY_WORDS; ++iWord)
+				if (mask & (1ULL << iWord)) {
+					memcpy(&words[iWord], cursor, sizeof(uint64_t));
+					cursor									+= sizeof(uint64_t);
+				}
+		}
+		loadBody(words, *reg->Body, reg->PreviousPosition, reg->PreviousOrientation);
+	}
+	return true;
 }
@@ -2,18 +2,31 @@
 // Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "contacts.h"
+#include "damping.h"
+#include "random.h"
 
 #ifndef CYCLONE_WORLD_H
 #define CYCLONE_WORLD_H
 
 namespace cyclone {
+	class TrajectoryRecorder;
+
 	// The world represents an independent simulation of physics. It keeps track of a set of rigid bodies, and provides the means to update them all.
 	// If you don't give a number of iterations, then four times the number of detected contacts will be used for each frame.
+	// RunPhysics steps the world by whatever duration it is given. Advance instead takes the duration of a rendered frame and runs as many steps of a fixed duration as fit in it, carrying the rest over to the next frame, so the
+	// simulation behaves the same at any frame rate. As the steps don't line up with the frames, the bodies are drawn between their last two states, with GetInterpolatedTransforms.
+	// In deterministic mode the contacts are sorted by the ids of their bodies and their geometry before they are resolved, so their order no longer depends on the order of the generators or of the broad phase.
+	// With the same bodies added in the same order and the same inputs, every run then gives bit-identical states, which GetStateHash summarises for comparing runs frame by frame.
+	// Snapshot and Restore save and load the changing state of the world into a flat buffer, so the host can roll the simulation back to an earlier frame and run it again with corrected inputs, as networked games do.
 	class World {
 		// Holds a single rigid body in a linked list of bodies.
 		struct	BodyRegistration {
 			RigidBody							* Body						= 0;
 			BodyRegistration					* Next						= 0;
+			Vector3								PreviousPosition			= {};	// Holds the state of the body before the last step, for interpolating.
+			Quaternion							PreviousOrientation			= {};
+			Vector3								FrameForce					= {};	// Holds the force and torque added for the frame, so every step of the frame applies them.
+			Vector3								FrameTorque					= {};
 		};
 		// Holds one contact generators in a linked list.
 		struct ContactGenRegistration {
@@ -29,19 +42,78 @@ namespace cyclone {
 		Contact									* Contacts					= 0;	// Holds an array of contacts, for filling by the contact generators.
 		uint32_t								MaxContacts					= 0;	// Holds the maximum number of contacts allowed (i.e. the size of the contacts array).
 
+		double									StepDuration				= 1.0 / 60;	// Holds the duration of each step run by Advance.
+		uint32_t								MaxSteps					= 4;	// Holds the most steps Advance runs for a frame. Frames longer than these steps lose the rest of their time, so a slow frame can't make the next one slower.
+		double									Accumulator					= 0;	// Holds the time advanced but not stepped yet, always less than a step after Advance.
+		double									DroppedTime					= 0;	// Holds the time lost to the limit of steps per frame since the world was created.
+
+		uint32_t								BodyCount					= 0;
+		bool									Deterministic				= false;
+		RandomStream							Generator					= {};	// Holds a random stream for the host, saved and restored with the world, so random events replay the same after a rollback.
+		mutable	uint64_t						SnapshotCount				= 0;	// Numbers the full snapshots, so a delta can check it is applied to the baseline it was made against.
+		DampingTable							Dampings					= {};	// Holds the damping classes of the bodies, and the motion bias of the sleep test, with their factors for the last step.
+		uint16_t								MotionBiasClass				= 0;
+		TrajectoryRecorder						* Recorder					= 0;	// Holds the recorder that captures the bodies at the end of each step, if any.
+
 	public:
 		// Creates a new simulator that can handle up to the given number of contacts per frame. You can also optionally give a number of contact-resolution iterations to use. 
-												~World						()													{ if(Contacts) delete[] Contacts;					}
+												~World						();
 												World						(uint32_t maxContacts, uint32_t iterations)			
 			: CalculateIterations	(iterations == 0)	
 			, Resolver				(iterations)
 			, MaxContacts			(maxContacts)
 		{
 			Contacts								= new Contact[maxContacts];
+			MotionBiasClass							= Dampings.AddClass(0.5);
 		}
+												World						(const World &)										= delete;
+		World&									operator=					(const World &)										= delete;
+
+		void									AddBody						(RigidBody *body);	// Adds a body to the simulation, with the damping classes of its damping values. The body must outlive the world.
+		void									AddContactGenerator			(ContactGenerator *generator);	// Adds a contact generator, which must outlive the world.
+
+		// Returns the damping class with the given damping value, adding it if there isn't one yet, or DampingTable::InvalidClass if the table is full.
+		inline	uint16_t						AddDampingClass				(double damping)									{ return Dampings.AddClass(damping);				}
+		// Sets the damping of a body to the given classes. Returns false, changing nothing, if either class doesn't exist. Damping values set on the body directly are also honoured: the next step moves the body to the class of its new value.
+		bool									SetBodyDamping				(RigidBody &body, uint16_t linearClass, uint16_t angularClass);
+
+		inline	void							SetDeterministic			(bool deterministic)								{ Deterministic = deterministic;					}
+		inline	bool							IsDeterministic				()											const	{ return Deterministic;								}
+		// Returns a hash of the position, orientation, velocities and sleep state of every body. Runs that are in step give the same hash for the same frame, so the first frame they differ in shows where they diverged.
+		uint64_t								GetStateHash				()											const;
+
+		inline	uint32_t						GetBodyCount				()											const	{ return BodyCount;									}
+		uint32_t								GetPivots					(SPivot3D *pivots, uint32_t maxCount)		const;	// Writes the position and orientation of the bodies, from the last added to the first. Returns the number written.
+		// Sets the recorder that captures the bodies at the end of each step, or none. The recorder must stay open while it is set.
+		inline	void							SetRecorder					(TrajectoryRecorder *recorder)						{ Recorder = recorder;								}
+
 		uint32_t								GenerateContacts			();	// Calls each of the registered contact generators to report their contacts. Returns the number of generated contacts.
 		void									RunPhysics					(double duration);	// Processes all the physics for the world.
 		void									StartFrame					();	// Initialises the world for a simulation frame. This clears the force and torque accumulators for bodies in the world. After calling this, the bodies can have their forces and torques for this frame added.
+
+		// Sets the duration of the steps run by Advance, and the most of them it runs for a frame. Returns false, changing nothing, if either is zero.
+		bool									SetFixedStep				(double stepDuration, uint32_t maxSteps);
+		// Runs the fixed steps that fit in the time advanced so far, the given frame duration included, and returns the number of steps run. Call it after StartFrame and after adding the forces of the frame, in place of RunPhysics.
+		uint32_t								Advance						(double frameDuration);
+		inline	double							GetStepDuration				()											const	{ return StepDuration;								}
+		inline	double							GetInterpolationAlpha		()											const	{ return Accumulator / StepDuration;				}	// Returns how far between the last two states the frame is, from 0 to 1.
+		inline	double							GetDroppedTime				()											const	{ return DroppedTime;								}
+		inline	RandomStream&					GetGenerator				()													{ return Generator;									}
+
+		// Snapshots hold the state that changes while the world runs: the position, orientation, velocities, accelerations, accumulated forces, sleep state and previous state of each body, the time of the fixed step and the random stream.
+		// Bodies, masses, damping classes and contact generators are not included: a snapshot is restored into the world it was taken from, or one set up the same way. The contacts are generated again on each step, so there are none to save.
+		// A snapshot made against a baseline, a full snapshot of the same world, is a delta: it only holds the values that differ from the baseline, which for bodies at rest is a few bytes each.
+		// The data is stored in the byte order of the machine. Making and restoring a snapshot doesn't allocate memory.
+		static constexpr	uint32_t			SnapshotVersion				= 1;
+		uint32_t								GetSnapshotSize				()											const;	// Returns the size of a full snapshot.
+		uint32_t								GetMaxDeltaSize				()											const;	// Returns the largest size of a delta, which is a word per body more than a full snapshot when every value of every body changed.
+		// Writes a snapshot into the given buffer and returns its size, or zero if the buffer is too small or the baseline isn't a full snapshot of this world. A buffer of GetMaxDeltaSize bytes holds any delta.
+		uint32_t								Snapshot					(uint8_t *buffer, uint32_t size, const uint8_t *baseline = 0, uint32_t baselineSize = 0)	const;
+		// Restores a snapshot. Deltas need the baseline they were made against. Returns false, changing nothing, if the snapshot doesn't match this world or the baseline.
+		bool									Restore						(const uint8_t *snapshot, uint32_t size, const uint8_t *baseline = 0, uint32_t baselineSize = 0);
+
+		// Writes the transforms of the bodies, from the last added to the first, blended between their last two states by the interpolation alpha. Returns the number of transforms written.
+		uint32_t								GetInterpolatedTransforms	(Matrix4 *transforms, uint32_t maxCount)	const;
 	};
 } // namespace cyclone
 
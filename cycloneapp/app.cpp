@@ -109,16 +109,17 @@ void							MassAggregateApplication::Display							()																{
 
 void							MassAggregateApplication::Update							()																{
 	World.StartFrame();	// Clear accumulators
-	float								duration													= (float)TimingData::get().LastFrameDuration * 0.001f;	// Find the duration of the last frame in seconds
+	float								duration													= (float)TimingData::get().LastFrameSeconds;	// Find the duration of the last frame in seconds
 	if (duration <= 0.0f) 
 		return;
 
 	World.RunPhysics(duration);	// Run the simulation
+	cyclone::Profile::EndFrame();
 	Application::Update();
 }
 
 void							RigidBodyApplication::Update								()																{
-	float								duration													= (float)TimingData::get().LastFrameDuration * 0.001f;	// Find the duration of the last frame in seconds
+	float								duration													= (float)TimingData::get().LastFrameSeconds;	// Find the duration of the last frame in seconds
 	if (duration <= 0.0f) 
 		return;	// nothing to update since no time has passed 
 	else if (duration > 0.05f) 
@@ -132,9 +133,19 @@ void							RigidBodyApplication::Update								()																{
 		PauseSimulation					= true;
 		AutoPauseSimulation				= false;
 	}
-	UpdateObjects		(duration);															// Update the objects
-	GenerateContacts	();																	// Perform the contact generation
-	Resolver.resolveContacts(Collisions.ContactArray, Collisions.ContactCount, duration);	// Resolve detected contacts
+	{
+		CYCLONE_PROFILE_SCOPE(cyclone::PROFILE_SCOPE_STEP);
+		{
+			CYCLONE_PROFILE_SCOPE(cyclone::PROFILE_SCOPE_INTEGRATE);
+			UpdateObjects		(duration);														// Update the objects
+		}
+		{
+			CYCLONE_PROFILE_SCOPE(cyclone::PROFILE_SCOPE_GENERATE_CONTACTS);
+			GenerateContacts	();																// Perform the contact generation
+		}
+		Resolver.resolveContacts(Collisions.ContactArray, Collisions.ContactCount, duration);	// Resolve detected contacts
+	}
+	cyclone::Profile::EndFrame();
 
 	Application::Update();
 }
@@ -3,50 +3,55 @@
 // Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
 #include "timing.h"
 
+#include <algorithm>
+
 #if (__APPLE__ || __unix)	// assume unix based OS
 	#define TIMING_UNIX	1
-	#include <stdlib.h>
-	#include <sys/time.h>
-	typedef unsigned long long	LONGLONG;
+	#include <time.h>
 #else	// assume windows
 	#define TIMING_WINDOWS	1
 	#include <windows.h>
 	#include <mmsystem.h>	// Import the high performance timer (c. 4ms).
-	static double qpcFrequency;
+	static LONGLONG qpcTicksPerSecond;
+#endif
+
+#if (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))	// The time stamp counter is only there on x86.
+	#define TIMING_TSC	1
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
 #endif
 
 static bool qpcFlag;		// Hold internal timing data for the performance counter.
 
 // Internal time and clock access functions
-uint64_t									systemTime									()						{
+uint64_t									systemTimeNs								()						{
 #if TIMING_UNIX
-	struct timeval									tv;
-	gettimeofday(&tv, 0);
-
-	return tv.tv_sec * 1000 + tv.tv_usec/1000;
+	struct timespec									ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 #else
 	if(!qpcFlag)
-		return (uint64_t)timeGetTime();
-	static LONGLONG qpcMillisPerTick;
-	QueryPerformanceCounter((LARGE_INTEGER*)&qpcMillisPerTick);
-	return (uint32_t)(qpcMillisPerTick * qpcFrequency);
+		return (uint64_t)timeGetTime() * 1000000ULL;
+	LONGLONG										ticks;
+	QueryPerformanceCounter((LARGE_INTEGER*)&ticks);
+	// Convert the whole seconds and the remainder separately, so the multiplication doesn't overflow.
+	return (uint64_t)(ticks / qpcTicksPerSecond) * 1000000000ULL + (uint64_t)(ticks % qpcTicksPerSecond) * 1000000000ULL / (uint64_t)qpcTicksPerSecond;
 #endif
 }
 
-uint64_t									TimingData::getTime							()						{ return systemTime(); }
+uint64_t									systemTime									()						{ return systemTimeNs() / 1000000ULL; }
 
-#if TIMING_WINDOWS
-uint64_t									systemClock									()						{ return __rdtsc(); }
-#endif
+uint64_t									TimingData::getTime							()						{ return systemTime(); }
+uint64_t									TimingData::getTimeNs						()						{ return systemTimeNs(); }
 
 uint64_t									TimingData::getClock						()						{
-#if TIMING_UNIX
-	struct timeval									tv;
-	gettimeofday(&tv, 0);
-
-	return tv.tv_sec * 1000 + tv.tv_usec/1000;
+#if TIMING_TSC
+	return __rdtsc();
 #else
-	return systemClock();
+	return systemTimeNs();
 #endif
 }
 
@@ -55,10 +60,7 @@ void										initTime									()						{
 #if TIMING_UNIX
 	qpcFlag										= false;
 #else
-	LONGLONG										time;
-	qpcFlag										= (QueryPerformanceFrequency((LARGE_INTEGER*)&time) > 0);
-	if (qpcFlag)	// Check if we have access to the performance counter at this resolution.
-		qpcFrequency								= 1000.0 / time;
+	qpcFlag										= (QueryPerformanceFrequency((LARGE_INTEGER*)&qpcTicksPerSecond) > 0 && qpcTicksPerSecond > 0);	// Check if we have access to the performance counter at this resolution.
 #endif
 }
 
@@ -69,13 +71,17 @@ TimingData&									TimingData::get								()						{ return (TimingData&)*timing
 
 // Updates the global frame information. Should be called once per frame.
 void										TimingData::update							()						{
-	if (!timingData) 
+	if (!timingData)
 		return;
 
 	if (!timingData->IsPaused)	// Advance the frame number.
 		++timingData->FrameNumber;
 
-	uint64_t										thisTime									= systemTime();	// Update the timing information.
+	uint64_t										thisTimeNs									= systemTimeNs();	// Update the timing information.
+	timingData->LastFrameDurationNs				= thisTimeNs - timingData->LastFrameTimestampNs;
+	timingData->LastFrameTimestampNs			= thisTimeNs;
+	timingData->LastFrameSeconds				= timingData->LastFrameDurationNs * 1e-9;
+	uint64_t										thisTime									= thisTimeNs / 1000000ULL;
 	timingData->LastFrameDuration				= thisTime - timingData->LastFrameTimestamp;
 	timingData->LastFrameTimestamp				= thisTime;
 
@@ -83,15 +89,29 @@ void										TimingData::update							()						{
 	uint64_t										thisClock									= getClock();
 	timingData->LastFrameClockTicks				= thisClock - timingData->LastFrameClockstamp;
 	timingData->LastFrameClockstamp				= thisClock;
+	if (thisTimeNs > timingData->InitTimestampNs)
+		timingData->ClockTicksPerSecond				= (thisClock - timingData->InitClockstamp) * 1e9 / (thisTimeNs - timingData->InitTimestampNs);
+
+	// Update the percentiles over the last frames. Sorting a copy of a few hundred durations costs a few microseconds, which is nothing next to a frame.
+	timingData->FrameDurations[timingData->FrameDurationCount++ % FrameWindowSize]	= timingData->LastFrameDurationNs;
+	const uint32_t									windowCount									= (uint32_t)std::min<uint64_t>(timingData->FrameDurationCount, FrameWindowSize);
+	uint64_t										sorted	[FrameWindowSize];
+	std::copy(timingData->FrameDurations, timingData->FrameDurations + windowCount, sorted);
+	std::sort(sorted, sorted + windowCount);
+	const auto										percentile									= [&sorted, windowCount](uint32_t percent) { return sorted[(windowCount * percent + 99) / 100 - 1] * 1e-6; };	// Nearest rank.
+	timingData->FrameDurationP50				= percentile(50);
+	timingData->FrameDurationP95				= percentile(95);
+	timingData->FrameDurationP99				= percentile(99);
 
 	// Update the RWA frame rate if we are able to.
 	if (timingData->FrameNumber > 1) {
+		const double									duration									= timingData->LastFrameDurationNs * 1e-6;
 		if (timingData->AverageFrameDuration <= 0)
-			timingData->AverageFrameDuration			= (double)timingData->LastFrameDuration;
+			timingData->AverageFrameDuration			= duration;
 		else {
 			// RWA over 100 frames.
 			timingData->AverageFrameDuration			*= 0.99;
-			timingData->AverageFrameDuration			+= 0.01 * (double)timingData->LastFrameDuration;
+			timingData->AverageFrameDuration			+= 0.01 * duration;
 			timingData->FramesPerSecond					= (float)(1000.0/timingData->AverageFrameDuration);	// Invert to get FPS
 		}
 	}
@@ -112,11 +132,21 @@ void										TimingData::init							()						{
 
 	// Set up the frame info structure.
 	timingData->FrameNumber						= 0;
-	timingData->LastFrameTimestamp				= systemTime();
+	timingData->LastFrameTimestampNs			= systemTimeNs();
+	timingData->LastFrameTimestamp				= timingData->LastFrameTimestampNs / 1000000ULL;
 	timingData->LastFrameDuration				= 0;
+	timingData->LastFrameDurationNs				= 0;
+	timingData->LastFrameSeconds				= 0;
 	timingData->LastFrameClockstamp				= getClock();
 	timingData->LastFrameClockTicks				= 0;
 	timingData->IsPaused						= false;
 	timingData->AverageFrameDuration			= 0;
 	timingData->FramesPerSecond					= 0;
+	timingData->FrameDurationP50				= 0;
+	timingData->FrameDurationP95				= 0;
+	timingData->FrameDurationP99				= 0;
+	timingData->ClockTicksPerSecond				= 0;
+	timingData->FrameDurationCount				= 0;
+	timingData->InitTimestampNs					= timingData->LastFrameTimestampNs;
+	timingData->InitClockstamp					= timingData->LastFrameClockstamp;
 }
@@ -8,24 +8,41 @@
 
 // Represents all the information that the demo might need about the timing of the game: current time, fps, frame number, and so on. */
 struct TimingData {
-	uint64_t					FrameNumber								= 0;		// The current render frame. This simply increments. 
-	uint64_t					LastFrameTimestamp						= 0;		// The timestamp when the last frame ended. Times are given in milliseconds since some undefined time. 
-	uint64_t					LastFrameDuration						= 0;		// The duration of the last frame in milliseconds. 
+	static constexpr uint32_t	FrameWindowSize							= 256;		// Holds the number of recent frames the percentiles of the frame duration are taken over.
+
+	uint64_t					FrameNumber								= 0;		// The current render frame. This simply increments.
+	uint64_t					LastFrameTimestamp						= 0;		// The timestamp when the last frame ended. Times are given in milliseconds since some undefined time.
+	uint64_t					LastFrameDuration						= 0;		// The duration of the last frame in milliseconds.
+	uint64_t					LastFrameTimestampNs					= 0;		// The timestamp when the last frame ended, in nanoseconds of a monotonic clock.
+	uint64_t					LastFrameDurationNs						= 0;		// The duration of the last frame in nanoseconds.
+	double						LastFrameSeconds						= 0;		// The duration of the last frame in seconds, without the rounding of LastFrameDuration. This is the one to step the physics with.
 	uint64_t					LastFrameClockstamp						= 0;		// The clockstamp of the end of the last frame.
-	uint64_t					LastFrameClockTicks						= 0;		// The duration of the last frame in clock ticks. 
-	bool						IsPaused								= false;	// Keeps track of whether the rendering is paused. 
+	uint64_t					LastFrameClockTicks						= 0;		// The duration of the last frame in clock ticks.
+	bool						IsPaused								= false;	// Keeps track of whether the rendering is paused.
 	// Calculated data
-	double						AverageFrameDuration					= 0;		// This is a recency weighted average of the frame time, calculated from frame durations. 
+	double						AverageFrameDuration					= 0;		// This is a recency weighted average of the frame time, calculated from frame durations.
 	float						FramesPerSecond							= 0;		// The reciprocal of the average frame duration giving the mean fps over a recency weighted average.
+	double						FrameDurationP50						= 0;		// The median duration of the last FrameWindowSize frames, in milliseconds.
+	double						FrameDurationP95						= 0;		// The duration that 95% of the last FrameWindowSize frames didn't exceed, in milliseconds.
+	double						FrameDurationP99						= 0;		// The duration that 99% of the last FrameWindowSize frames didn't exceed, in milliseconds.
+	double						ClockTicksPerSecond						= 0;		// The rate of getClock, measured against getTimeNs since init.
 
 	static TimingData&			get										();			// Gets the global timing data object.
 	static void					update									();			// Updates the timing system, should be called once per frame.
 	static void					init									();			// Initialises the frame information system. Use the overall init function to set up all modules. */
 	static void					deinit									();			// Deinitialises the frame information system.
 	static uint64_t				getTime									();			// Gets the global system time, in the best resolution possible. Timing is in milliseconds.
-	static uint64_t				getClock								();			// Gets the clock ticks since process start.
+	static uint64_t				getTimeNs								();			// Gets the time of a monotonic clock, in nanoseconds.
+	// Gets the clock ticks since some undefined time. On x86 this reads the time stamp counter, which is cheaper than getTimeNs and fit for timing hot code, but its ticks are only converted to time through ClockTicksPerSecond.
+	// Elsewhere it is the same as getTimeNs.
+	static uint64_t				getClock								();
 
 private:
+	uint64_t					FrameDurations	[FrameWindowSize]		= {};		// Holds the durations of the last frames in nanoseconds, as a ring indexed by FrameDurationCount.
+	uint64_t					FrameDurationCount						= 0;		// Counts the durations measured since init, paused or not.
+	uint64_t					InitTimestampNs							= 0;
+	uint64_t					InitClockstamp							= 0;
+
 	// These are private to stop instances being created: use get().
 								TimingData								()							{}
 
@@ -83,6 +83,7 @@ public:
         Body->setAwake();
 
         Body->CalculateDerivedData();
+        InvalidateTransform();	// The radius may have changed, so the bounds must be recalculated.
     }
 
     // Positions the box at a random location.
@@ -162,6 +163,7 @@ public:
 		Body->Force.Acceleration		= {0, -10.0f, 0};
 		Body->setAwake					();
 		Body->CalculateDerivedData		();
+		InvalidateTransform				();	// The size may have changed, so the bounds must be recalculated.
 	}
 	
 	// Positions the box at a random location.
@@ -190,13 +192,15 @@ class ExplosionDemo : public RigidBodyApplication
 	static	const uint32_t	Balls				= OBJECTS;	// Holds the number of balls in the simulation.
 	Box						BoxData		[Boxes]	= {};		// Holds the box data.
 	Ball					BallData	[Balls]	= {};		// Holds the ball data. 
+	cyclone::CollisionWorld	Collision			= {};		// Holds the boxes, the balls and the ground plane, and generates the contacts between them.
+	cyclone::ExplosionSet	Blasts				= {};		// Holds the explosions that are still going off.
 	
 	void					Fire				();	// Detonates the explosion. 
 	virtual void			Reset				();	// Resets the position of all the boxes and primes the explosion. 
 	virtual void			GenerateContacts	();	// Processes the contact generation code. 
 	virtual void			UpdateObjects		(double duration);	// Processes the objects in the simulation forward in time. 
 public:
-							ExplosionDemo		()												: RigidBodyApplication()				{ Reset(); }	// Reset the position of the boxes
+							ExplosionDemo		();	// Registers the objects with the collision world and resets their positions.
 
 	virtual const char*		GetTitle			()												{ return "Cyclone > Explosion Demo";	}
 	virtual void			InitGraphics		();						// Sets up the rendering. 
@@ -207,14 +211,33 @@ public:
 };
 
 // Method definitions
+ExplosionDemo::ExplosionDemo() : RigidBodyApplication() {
+	for (Box *box = BoxData; box < BoxData + Boxes; box++)
+		Collision.Register(box);
+	for (Ball *ball = BallData; ball < BallData + Balls; ball++)
+		Collision.Register(ball);
+	Collision.HalfSpaces.push_back({{0, 1, 0}, 0});	// The ground plane.
 
+	Reset();	// Reset the position of the boxes
+}
 
 void ExplosionDemo::Fire()
 {
-    cyclone::Vector3 pos = BallData[0].Body->Pivot.Position;
-    pos.normalise();
-
-    BallData[0].Body->addForce(pos * -1000.0f);
+	cyclone::Explosion			blast				= {};
+	blast.Detonation			= {0, 0.5, 0};
+	blast.ImplosionMaxRadius	= 10;
+	blast.ImplosionMinRadius	= 1;
+	blast.ImplosionDuration		= 0.1;
+	blast.ImplosionForce		= 50;
+	blast.ShockwaveSpeed		= 20;
+	blast.ShockwaveThickness	= 3;
+	blast.PeakConcussionForce	= 1000;
+	blast.ConcussionDuration	= 0.8;
+	blast.PeakConvectionForce	= 200;
+	blast.ChimneyRadius			= 3;
+	blast.ChimneyHeight			= 15;
+	blast.ConvectionDuration	= 2;
+	Blasts.Add(blast);
 }
 
 void ExplosionDemo::Reset()
@@ -241,65 +264,31 @@ void ExplosionDemo::Reset()
         ball->Random(&random);
 
     Collisions.ContactCount = 0;	// Reset the contacts
+	Blasts.Explosions.clear();
 }
 
 // Note that this method makes a lot of use of early returns to avoid processing lots of potential contacts that it hasn't got room to store.
 void ExplosionDemo::GenerateContacts() {
-    
-
-    // Create the ground plane data
-    cyclone::CollisionPlane		plane;
-	plane.Direction			= {0, 1, 0};
-    plane.Offset			= 0;
-
     // Set up the collision data structure
     Collisions.Reset(MaxContacts);
     Collisions.Friction			= 0.9;
     Collisions.Restitution		= 0.6;
     Collisions.Tolerance			= 0.1;
 
-    // Perform exhaustive collision detection
-    cyclone::Matrix4 transform, otherTransform;
-    cyclone::Vector3 position, otherPosition;
-    for (Box *box = BoxData; box < BoxData + Boxes; box++) {
-        // Check for collisions with the ground plane
-        if (!Collisions.HasMoreContacts()) 
-			return;
-        cyclone::CollisionDetector::boxAndHalfSpace(*box, plane, &Collisions);
-
-        // Check for collisions with each other box
-        for (Box *other = box+1; other < BoxData + Boxes; other++) {
-            if (!Collisions.HasMoreContacts()) 
-				return;
-            cyclone::CollisionDetector::boxAndBox(*box, *other, &Collisions);
+    // Let the collision world find the potential contacts and run the fine grained tests by shape type
+    Collision.Update();
+    Collision.GenerateContacts(&Collisions);
 
+    // Flag the overlapping boxes so they're rendered differently
+    for (Box *box = BoxData; box < BoxData + Boxes; box++)
+        for (Box *other = box+1; other < BoxData + Boxes; other++)
             if (cyclone::IntersectionTests::BoxAndBox(*box, *other))
                 box->IsOverlapping = other->IsOverlapping = true;
-        }
-
-        // Check for collisions with each ball
-        for (Ball *other = BallData; other < BallData + Balls; other++) {
-            if (!Collisions.HasMoreContacts()) 
-				return;
-            cyclone::CollisionDetector::boxAndSphere(*box, *other, &Collisions);
-        }
-    }
-
-    for (Ball *ball = BallData; ball < BallData + Balls; ball++) {
-        // Check for collisions with the ground plane
-        if (!Collisions.HasMoreContacts()) 
-			return;
-        cyclone::CollisionDetector::sphereAndHalfSpace(*ball, plane, &Collisions);
-
-        for (Ball *other = ball + 1; other < BallData + Balls; other++) {	// Check for collisions with the ground plane
-            if (!Collisions.HasMoreContacts()) 
-				return;
-            cyclone::CollisionDetector::sphereAndSphere(*ball, *other, &Collisions);
-        }
-    }
 }
 
 void ExplosionDemo::UpdateObjects(double duration) {
+	Blasts.Apply(Collision.Coarse);	// The broad phase holds the bounds from the last contact generation, which is close enough to find the objects near each blast.
+	Blasts.Advance(duration);
 	for (Box *box = BoxData; box < BoxData + Boxes; box++) {	// Update the physics of each box in turn
 		box->Body->Integrate(duration);	// Run the physics
 		box->CalculateInternals();
@@ -437,6 +426,7 @@ void ExplosionDemo::Key(unsigned char key) {
 	switch(key) {
 	case 'e': case 'E': EditMode	= !EditMode	; UpMode	= false; return;
 	case 't': case 'T': UpMode		= !UpMode	; EditMode	= false; return;
+	case 'f': case 'F': Fire(); return;
 	case 'w': case 'W':
 		for (Box *box	= BoxData	; box	< BoxData	+ Boxes; ++box	) box	->Body->setAwake();
 		for (Ball *ball = BallData	; ball	< BallData	+ Balls; ++ball	) ball	->Body->setAwake();
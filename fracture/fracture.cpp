@@ -171,6 +171,7 @@ public:
             blocks[i].Body->clearAccumulators		();
             blocks[i].Body->CalculateDerivedData	();
             blocks[i].Offset						= cyclone::Matrix4();
+            blocks[i].InvalidateTransform			();
             blocks[i].Exists						= true;
             blocks[i].HalfSize						= halfSize;
 
@@ -15,14 +15,14 @@
 
 // The main demo class definition.
 class PlatformDemo : public MassAggregateApplication {
-	cyclone::ParticleRod				* Rods					= 0;
+	cyclone::ParticleLinkSet			Rods					= {};
 	
 	cyclone::Vector3					MassPos					= {0,0,0.5f};
 	cyclone::Vector3					MassDisplayPos			= {};
 	
 	void								UpdateAdditionalMass	();	// Updates particle masses to take into account the mass that's on the platform.
 public:
-	virtual								~PlatformDemo			()						{ if (Rods) delete[] Rods; }
+	virtual								~PlatformDemo			()						{}
 										PlatformDemo			();
 	
 	virtual void						Display					();						// Display the particles.
@@ -53,30 +53,29 @@ PlatformDemo::PlatformDemo() : MassAggregateApplication(6)
 		ParticleArray[i].AccumulatedForce	= {};
     }
 
-    Rods = new cyclone::ParticleRod[ROD_COUNT];
-
-    Rods[0] .Particle[0] = &ParticleArray[0];	Rods[0] .Particle[1] = &ParticleArray[1];	Rods[0] .Length = 2;
-    Rods[1] .Particle[0] = &ParticleArray[2];	Rods[1] .Particle[1] = &ParticleArray[3];	Rods[1] .Length = 2;
-    Rods[2] .Particle[0] = &ParticleArray[4];	Rods[2] .Particle[1] = &ParticleArray[5];	Rods[2] .Length = 2;
-			 											 										    
-    Rods[3] .Particle[0] = &ParticleArray[2];	Rods[3] .Particle[1] = &ParticleArray[4];	Rods[3] .Length = 7;
-    Rods[4] .Particle[0] = &ParticleArray[3];	Rods[4] .Particle[1] = &ParticleArray[5];	Rods[4] .Length = 7;
-			 											 										    
-    Rods[5] .Particle[0] = &ParticleArray[0];	Rods[5] .Particle[1] = &ParticleArray[2];	Rods[5] .Length = 3.606;
-    Rods[6] .Particle[0] = &ParticleArray[1];	Rods[6] .Particle[1] = &ParticleArray[3];	Rods[6] .Length = 3.606;
-			 											 										    
-    Rods[7] .Particle[0] = &ParticleArray[0];	Rods[7] .Particle[1] = &ParticleArray[4];	Rods[7] .Length = 4.472;
-    Rods[8] .Particle[0] = &ParticleArray[1];	Rods[8] .Particle[1] = &ParticleArray[5];	Rods[8] .Length = 4.472;
-			 											 										    
-    Rods[9] .Particle[0] = &ParticleArray[0];	Rods[9] .Particle[1] = &ParticleArray[3];	Rods[9] .Length = 4.123;
-    Rods[10].Particle[0] = &ParticleArray[2];	Rods[10].Particle[1] = &ParticleArray[5];	Rods[10].Length = 7.28;
-    Rods[11].Particle[0] = &ParticleArray[4];	Rods[11].Particle[1] = &ParticleArray[1];	Rods[11].Length = 4.899;
-    Rods[12].Particle[0] = &ParticleArray[1];	Rods[12].Particle[1] = &ParticleArray[2];	Rods[12].Length = 4.123;
-    Rods[13].Particle[0] = &ParticleArray[3];	Rods[13].Particle[1] = &ParticleArray[4];	Rods[13].Length = 7.28;
-    Rods[14].Particle[0] = &ParticleArray[5];	Rods[14].Particle[1] = &ParticleArray[0];	Rods[14].Length = 4.899;
+    Rods.Particles = ParticleArray;
 
-    for (uint32_t i = 0; i < ROD_COUNT; i++)
-        World.ContactGenerators.push_back(&Rods[i]);
+    Rods.AddRod(0, 1, 2);
+    Rods.AddRod(2, 3, 2);
+    Rods.AddRod(4, 5, 2);
+
+    Rods.AddRod(2, 4, 7);
+    Rods.AddRod(3, 5, 7);
+
+    Rods.AddRod(0, 2, 3.606);
+    Rods.AddRod(1, 3, 3.606);
+
+    Rods.AddRod(0, 4, 4.472);
+    Rods.AddRod(1, 5, 4.472);
+
+    Rods.AddRod(0, 3, 4.123);
+    Rods.AddRod(2, 5, 7.28);
+    Rods.AddRod(4, 1, 4.899);
+    Rods.AddRod(1, 2, 4.123);
+    Rods.AddRod(3, 4, 7.28);
+    Rods.AddRod(5, 0, 4.899);
+
+    World.ContactGenerators.push_back(&Rods);
 
     UpdateAdditionalMass();
 }
@@ -124,9 +123,8 @@ void PlatformDemo::Display()
     glColor3f(0,0,1);
     for (uint32_t i = 0; i < ROD_COUNT; i++)
     {
-        cyclone::Particle **particles = Rods[i].Particle;
-        const cyclone::Vector3 &p0 = particles[0]->Position;
-        const cyclone::Vector3 &p1 = particles[1]->Position;
+        const cyclone::Vector3 &p0 = ParticleArray[Rods.ParticleA[i]].Position;
+        const cyclone::Vector3 &p1 = ParticleArray[Rods.ParticleB[i]].Position;
         glVertex3f(p0.x, p0.y, p0.z);
         glVertex3f(p1.x, p1.y, p1.z);
     }
@@ -17,15 +17,13 @@ public:
 									Bone								()																					{ Body = &_boneBody; }
 
     // We use a sphere to collide bone on bone to allow some limited interpenetration.
-    cyclone::CollisionSphere		getCollisionSphere					()																	const			{
-        cyclone::CollisionSphere			sphere;
+	// The sphere is updated in place rather than recreated, so it keeps its cached transform and the broad phase can tell whether it moved.
+    void							updateCollisionSphere				(cyclone::CollisionSphere &sphere)									const			{
         sphere.Body						= Body;
         sphere.Radius					= HalfSize.x;
-        sphere.Offset					= cyclone::Matrix4();
         if (HalfSize.y < sphere.Radius) sphere.Radius = HalfSize.y;
         if (HalfSize.z < sphere.Radius) sphere.Radius = HalfSize.z;
         sphere.CalculateInternals();
-        return sphere;
     }
 
 	// Draws the bone.
@@ -80,6 +78,8 @@ class RagdollDemo : public RigidBodyApplication {
 	cyclone::Random					Random								= {};
 	Bone							Bones	[NUM_BONES]					= {};	// Holds the bone bodies.	
 	cyclone::Joint					Joints	[NUM_JOINTS]				= {};	// Holds the joints.		
+	cyclone::CollisionSphere		BoneSpheres	[NUM_BONES]				= {};	// Holds the spheres used to collide bone on bone.
+	cyclone::BroadPhase				Coarse								= {};	// Holds the bone spheres. The bones held together by a joint are excluded from colliding with each other.
 
 	virtual void					GenerateContacts					();	// Processes the contact generation code. 
 	virtual void					UpdateObjects						(double duration);	// Processes the objects in the simulation forward in time.
@@ -111,6 +111,11 @@ public:
 	Joints[5]	.Set(Bones[5]	.Body, {-0.043f, 0.411f, 0}	, Bones[6]	.Body, {0, -0.411f, 0}		, 0.15f);
 	Joints[6]	.Set(Bones[6]	.Body, {0, 0.521f, 0}		, Bones[7]	.Body, {0, -0.752f, 0}		, 0.15f);
 
+	for (uint32_t i = 0; i < NUM_BONES; ++i)
+		Coarse.Insert(&BoneSpheres[i]);
+	for (uint32_t i = 0; i < NUM_JOINTS; ++i)
+		Coarse.ExcludePair(Joints[i].Body[0], Joints[i].Body[1]);
+
 	Reset();	// Set up the initial positions
 }
 
@@ -127,21 +132,22 @@ void								RagdollDemo::GenerateContacts		()																					{
 	Collisions.Tolerance				= (double)0.1;
 
 	// Perform exhaustive collision detection on the ground plane
-	cyclone::Matrix4					transform	, otherTransform;
-	cyclone::Vector3					position	, otherPosition;
 	for (Bone *bone = Bones; bone < Bones + NUM_BONES; bone++) {
-		// Check for collisions with the ground plane
 		if (!Collisions.HasMoreContacts()) 
 			return;
-
 		cyclone::CollisionDetector::boxAndHalfSpace(*bone, plane, &Collisions);
-		cyclone::CollisionSphere			boneSphere			= bone->getCollisionSphere();
-		for (Bone *other = bone+1; other < Bones + NUM_BONES; other++) {	// Check for collisions with each other box
-			if (!Collisions.HasMoreContacts()) 
-				return;
-			cyclone::CollisionSphere		otherSphere			= other->getCollisionSphere();
-			cyclone::CollisionDetector::sphereAndSphere(boneSphere, otherSphere, &Collisions);
-	    }
+	}
+
+	// Check for collisions between the bones that aren't jointed together
+	cyclone::PotentialContact			pairs	[NUM_BONES * (NUM_BONES - 1) / 2];
+	Coarse.Update();
+	const uint32_t						pairCount			= Coarse.GetPotentialContacts(pairs, NUM_BONES * (NUM_BONES - 1) / 2);
+	for (uint32_t i = 0; i < pairCount; ++i) {
+		if (!Collisions.HasMoreContacts()) 
+			return;
+		const cyclone::CollisionSphere		& boneSphere		= *(const cyclone::CollisionSphere*)Coarse.Proxies[pairs[i].Proxy[0]].Primitive;
+		const cyclone::CollisionSphere		& otherSphere		= *(const cyclone::CollisionSphere*)Coarse.Proxies[pairs[i].Proxy[1]].Primitive;
+		cyclone::CollisionDetector::sphereAndSphere(boneSphere, otherSphere, &Collisions);
 	}
 
 	// Check for joint violation
@@ -169,6 +175,8 @@ void RagdollDemo::Reset()
 	Bones[9]	.setState({ 0.000, 4.024, -1.066}, {0.267, 0.888, 0.207});
 	Bones[10]	.setState({ 0.000, 5.946,  1.066}, {0.267, 0.888, 0.207});
 	Bones[11]	.setState({ 0.000, 4.024,  1.066}, {0.267, 0.888, 0.207});
+	for (uint32_t i = 0; i < NUM_BONES; ++i)
+		Bones[i].updateCollisionSphere(BoneSpheres[i]);
 
 	double strength = -Random.RandomReal(500.0f, 1000.0f);
 	for (uint32_t i = 0; i < NUM_BONES; ++i)
@@ -183,9 +191,10 @@ void RagdollDemo::Reset()
 }
 
 void RagdollDemo::UpdateObjects(double duration) {
-    for (Bone *bone = Bones; bone < Bones + NUM_BONES; ++bone) {
-        bone->Body->Integrate(duration);
-        bone->CalculateInternals();
+    for (uint32_t i = 0; i < NUM_BONES; ++i) {
+        Bones[i].Body->Integrate(duration);
+        Bones[i].CalculateInternals();
+        Bones[i].updateCollisionSphere(BoneSpheres[i]);
     }
 }
 
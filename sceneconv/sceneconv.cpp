@@ -0,0 +1,60 @@
+// This file contains the scene converter: it reads a scene from its text description and writes it as a binary scene image, which SceneFile maps into memory without any parsing. See SceneBuilder in scene.h for the text format.
+// Copyright (c) Icosagon 2003. Published by Ian Millington under the MIT License for his book "Game Physics Engine Development" or something like that (a really good book that I actually bought in paperback after reading it).
+// Heavily modified by asm128 in order to make this code readable and free of potential bugs and inconsistencies and a large set of sources of problems and improductivity originally introduced thanks to poor advice, bad practices and OOP vices.
+#include "cyclone.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Reads the whole of the given file into the given text, ending it with a null character.
+static	bool						readText							(const char *fileName, ::std::vector<char> &text)			{
+	FILE									* file								= fopen(fileName, "rb");
+	if (0 == file)
+		return false;
+	char									buffer	[65536];
+	size_t									read;
+	text.clear();
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		text.insert(text.end(), buffer, buffer + read);
+	const bool								failed								= 0 != ferror(file);
+	fclose(file);
+	text.push_back(0);
+	return !failed;
+}
+
+int									main								(int argc, char **argv)										{
+	if (argc != 3) {
+		fprintf(stderr, "Usage: sceneconv <text scene> <binary scene>\n");
+		return EXIT_FAILURE;
+	}
+	::std::vector<char>						text;
+	if (!readText(argv[1], text)) {
+		fprintf(stderr, "Can't read %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	cyclone::SceneBuilder					builder;
+	uint32_t								errorLine							= 0;
+	if (!builder.Parse(text.data(), &errorLine)) {
+		fprintf(stderr, "%s(%u): Invalid line\n", argv[1], errorLine);
+		return EXIT_FAILURE;
+	}
+	if (!builder.Write(argv[2])) {
+		fprintf(stderr, "Can't write %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	// Check the image loads, as the programs using it will.
+	cyclone::SceneFile						scene;
+	if (!scene.Open(argv[2])) {
+		fprintf(stderr, "Can't load %s back\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	printf("%s: %u bodies, %u primitives, %u planes, %u joints, %u tree nodes\n", argv[2]
+		, scene.GetCount(cyclone::SCENE_SECTION_BODIES		)
+		, scene.GetCount(cyclone::SCENE_SECTION_PRIMITIVES	)
+		, scene.GetCount(cyclone::SCENE_SECTION_PLANES		)
+		, scene.GetCount(cyclone::SCENE_SECTION_JOINTS		)
+		, scene.GetCount(cyclone::SCENE_SECTION_NODES		)
+		);
+	return EXIT_SUCCESS;
+}